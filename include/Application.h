@@ -0,0 +1,65 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Backend.h"
+
+//--------------------------------------------------------------------------------------
+// Application
+// The update and render loop of the color banding demo, independent of the backend
+// that renders it and of the platform that hosts it.
+//--------------------------------------------------------------------------------------
+
+struct ApplicationConfig
+{
+    BackendConfig backend;
+    int          blueNoiseSize = 0;         // 0 loads the textures in data/blue-noise, otherwise generates them
+    int          blueNoiseSlices = 64;
+};
+
+class Application
+{
+public:
+
+    void Init(RenderBackend &renderBackend, const ApplicationConfig &config);
+    void Update();
+    bool Render(SoftwareFrame* readback = nullptr);
+    void Cleanup();
+
+    FrameState& Get_State() { return state; }
+
+    static BandingConstants Create_Constants(const PixelLayout &layout, uint32_t width, uint32_t height);
+
+private:
+
+    RenderBackend* backend = nullptr;
+    FrameState state;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    float angle = 0.f;
+};
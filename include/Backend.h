@@ -0,0 +1,81 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+
+//--------------------------------------------------------------------------------------
+// Render Backends
+// The application drives a backend through this interface, so the same Update() and
+// Render() loop, constants, and animation run on D3D12 with a window, or headless on
+// the software renderer. Calls are made in order: Init(), Upload_Noise_Textures(), then
+// Update_Constants(), Render(), optionally Readback(), and Present() for every frame,
+// and Destroy() last. Errors are thrown as exceptions.
+//--------------------------------------------------------------------------------------
+
+struct BackendConfig
+{
+    uint32_t     width = 640;
+    uint32_t     height = 360;
+    bool         vsync = false;
+    PixelFormat  backBufferFormat = PIXEL_FORMAT_RGBA8;
+    bool         customLayout = false;      // pack frames with layout instead of backBufferFormat's (software backend only)
+    PixelLayout  layout;
+};
+
+// Application state that a backend's UI may change while it renders a frame
+struct FrameState
+{
+    BandingConstants constants;
+    bool         vsync = false;
+    bool         animateLight = false;
+};
+
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() {}
+
+    virtual const char* Get_Name() const = 0;
+
+    virtual void Init(const BackendConfig &config, const BandingConstants &constants) = 0;
+    virtual void Upload_Noise_Textures(NoiseTextures textures) = 0;
+    virtual void Update_Constants(const BandingConstants &constants) = 0;
+    virtual void Render(FrameState &state) = 0;
+    virtual bool Readback(SoftwareFrame &frame) = 0;    // copy of the frame just rendered, false when not supported
+    virtual void Present() = 0;
+    virtual void Destroy() = 0;
+
+    virtual void Log(const char* message) = 0;          // debugger output or stderr
+};
+
+namespace Backend
+{
+    std::unique_ptr<RenderBackend> Create_Software(uint32_t numThreads = 0, TransferMode transferMode = TRANSFER_POLYNOMIAL);
+    PixelLayout Get_Layout(const BackendConfig &config);
+}
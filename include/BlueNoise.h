@@ -0,0 +1,71 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Threading.h"
+
+//--------------------------------------------------------------------------------------
+// Blue Noise
+// Loads the pre-baked textures in data/blue-noise, or generates new ones with the
+// void-and-cluster method (Ulichney 1993). Generated textures have three independent
+// blue noise masks in RGB, with the same R8G8B8A8 layout as Utils::LoadTexture().
+// Spatiotemporal blue noise has no pre-baked textures, so it is generated once and
+// cached in data/blue-noise/spatiotemporal.cache.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t BLUE_NOISE_MIN_SIZE = 4;
+static const uint32_t BLUE_NOISE_MAX_SIZE = 4096;
+static const uint32_t BLUE_NOISE_SPATIOTEMPORAL_SIZE = 64;
+static const uint32_t BLUE_NOISE_SPATIOTEMPORAL_SLICES = 32;
+
+struct BlueNoiseLoadStats
+{
+    bool cacheHit = false;          // the textures were mapped from data/blue-noise/blue-noise.cache
+    bool cacheWritten = false;      // the PNGs were decoded and the cache rebuilt
+    double milliseconds = 0.0;      // total, including the cache
+    double decodeMilliseconds = 0.0;            // wall time decoding the PNGs, zero on a cache hit
+    std::vector<double> sliceMilliseconds;      // time to decode each PNG: the array slices, then rgb-256.png
+};
+
+namespace BlueNoise
+{
+    std::vector<TextureInfo> Load_Texture_Array(ThreadPool &pool, uint32_t num, std::vector<double>* sliceMilliseconds = nullptr);
+    TextureInfo Load_Texture();
+    void Load_Textures(ThreadPool &pool, NoiseTextures &textures, uint32_t num, BlueNoiseLoadStats* stats = nullptr);
+    void Load_Textures_From_PNG(ThreadPool &pool, NoiseTextures &textures, uint32_t num, BlueNoiseLoadStats* stats = nullptr);
+
+    void Generate_Mask(uint32_t size, uint32_t seed, uint8_t* dest, uint32_t destStride);
+    TextureInfo Generate_Texture(ThreadPool &pool, uint32_t size, uint32_t seed);
+    std::vector<TextureInfo> Generate_Texture_Array(ThreadPool &pool, uint32_t size, uint32_t slices, uint32_t seed);
+    void Generate_Spatiotemporal_Mask(uint32_t size, uint32_t numSlices, uint32_t seed, uint8_t* const* dest, uint32_t destStride);
+    std::vector<TextureInfo> Generate_Spatiotemporal_Texture_Array(ThreadPool &pool, uint32_t size, uint32_t slices, uint32_t seed);
+    void Generate_Spatiotemporal_Textures(ThreadPool &pool, NoiseTextures &textures, uint32_t size, uint32_t slices, uint32_t seed);
+    bool Load_Spatiotemporal_Textures(ThreadPool &pool, NoiseTextures &textures, uint32_t size, uint32_t slices, uint32_t seed);
+    void Generate_Textures(ThreadPool &pool, NoiseTextures &textures, uint32_t size, uint32_t slices, uint32_t seed);
+}
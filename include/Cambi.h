@@ -0,0 +1,77 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Simd.h"
+#include "Threading.h"
+
+//--------------------------------------------------------------------------------------
+// Banding Detection
+// A no-reference banding index in the style of CAMBI (Tandon et al. 2021), for scoring
+// frames from the software renderer in regression tests.
+//
+// The frame is converted to luma codes at its own depth (at most 10 bits), and scored at
+// five scales, halving the resolution each time. At each scale, only pixels in flat areas
+// count, where most pixels of the surrounding 7x7 area equal their right and lower
+// neighbors; dithering noise fails this at full resolution, and is averaged away at
+// coarser scales. For each of those pixels, the window around it (65 pixels wide at 4K,
+// proportionally smaller at lower resolutions) is checked for nearby flat areas 1 to 3
+// codes away, weighted by the step and by whether the step is visible at that brightness.
+// Each scale is pooled by the mean of its highest 60% of values, and the index is the mean
+// over scales: 0 is no banding, and larger values mean wider, higher contrast bands.
+//
+// Windows are counted with sliding histograms, one per tile, so tiles run in parallel on
+// the pool; the histogram updates use AVX2 where available. Results are exact integer
+// counts pooled in a fixed order, so they do not depend on the thread count or SIMD level.
+// The heatmap holds the largest value of each pixel over every scale.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t CAMBI_NUM_SCALES = 5;
+static const uint32_t CAMBI_MAX_BITS = 10;
+static const uint32_t CAMBI_WINDOW_SIZE = 65;           // at 3840 pixels wide
+static const uint32_t CAMBI_MASK_SIZE = 7;
+static const float CAMBI_TOPK = 0.6f;
+static const float CAMBI_VISIBILITY_THRESHOLD = 0.005f; // luminance contrast of a step, with a black level of 0.1%
+
+struct CambiResult
+{
+    double score = 0.0;
+    double scaleScores[CAMBI_NUM_SCALES] = {};
+    std::vector<float> heatmap;     // width * height values, when requested
+    uint32_t width = 0;
+    uint32_t height = 0;
+    double milliseconds = 0.0;
+};
+
+namespace Cambi
+{
+    CambiResult Score(ThreadPool &pool, const SoftwareFrame &frame, const PixelLayout &layout, bool heatmap = false);
+    CambiResult Score(ThreadPool &pool, SimdLevel level, const SoftwareFrame &frame, const PixelLayout &layout, bool heatmap = false);
+    void Write_Heatmap(const std::string &filepath, const CambiResult &result);
+}
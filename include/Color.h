@@ -0,0 +1,143 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Simd.h"
+
+#include <cmath>
+
+//--------------------------------------------------------------------------------------
+// Scalar mirrors of the functions in shaders/Common.hlsl
+//--------------------------------------------------------------------------------------
+
+namespace Color
+{
+    /**
+    * Clamp to [0, 1]. NaN becomes 0, like saturate() in D3D.
+    */
+    inline float Saturate(float x)
+    {
+        return (x > 0.f) ? ((x < 1.f) ? x : 1.f) : 0.f;
+    }
+
+    /**
+    * Converts from linear to sRGB color space. Matches LinearToSRGB() in Common.hlsl.
+    */
+    inline float LinearToSRGB(float x)
+    {
+        x = Saturate(x);
+        if (x < 0.0031308f) return x * 12.92f;
+        return powf(x * 1.055f, 1.f / 2.4f) - 0.055f;
+    }
+
+    /**
+    * ACES tone mapping curve fit to go from HDR to LDR. Matches ACESFilm() in Common.hlsl.
+    */
+    inline float ACESFilm(float x)
+    {
+        const float a = 2.51f;
+        const float b = 0.03f;
+        const float c = 2.43f;
+        const float d = 0.59f;
+        const float e = 0.14f;
+        return Saturate((x * (a * x + b)) / (x * (c * x + d) + e));
+    }
+
+    /**
+    * Convert a [0, 1] float to UNORM8 the way D3D does when writing to an R8G8B8A8_UNORM target.
+    */
+    inline uint8_t FloatToUNORM8(float x)
+    {
+        return (uint8_t)(Saturate(x) * 255.f + 0.5f);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Color Transfer
+// Batch sRGB encode (LinearToSRGB, the curve in Common.hlsl) and decode (SRGBToLinear,
+// the IEC 61966-2-1 curve, for reading sRGB images). Input and output may alias.
+//
+// TRANSFER_REFERENCE   powf per value, the same arithmetic as the shader
+// TRANSFER_LUT         piecewise linear table (64 segments per octave) generated at compile time
+// TRANSFER_POLYNOMIAL  degree-5 minimax polynomial of the mantissa, scaled by a table indexed by the exponent
+//
+// The LUT and polynomial modes return identical results at every SIMD level. NaN becomes 0.
+// Max error, measured over every float in [0, 1] against a double precision evaluation:
+//
+//                           LinearToSRGB                    SRGBToLinear
+//                      8-bit codes   10-bit codes      8-bit codes   10-bit codes
+// TRANSFER_REFERENCE    0.00003       0.0001            0.00006       0.0002
+// TRANSFER_LUT          0.0014        0.0058            0.0059        0.0238
+// TRANSFER_POLYNOMIAL   0.0004        0.0015            0.0002        0.0007
+//--------------------------------------------------------------------------------------
+
+namespace Color
+{
+    /**
+    * Converts from sRGB to linear color space.
+    */
+    inline float SRGBToLinear(float x)
+    {
+        x = Saturate(x);
+        if (x <= 0.04045f) return x / 12.92f;
+        return powf((x + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSRGB_LUT(float x);
+    float LinearToSRGB_Polynomial(float x);
+    float SRGBToLinear_LUT(float x);
+    float SRGBToLinear_Polynomial(float x);
+
+    void LinearToSRGB(TransferMode mode, const float* input, float* output, uint32_t count);
+    void LinearToSRGB(SimdLevel level, TransferMode mode, const float* input, float* output, uint32_t count);
+    void SRGBToLinear(TransferMode mode, const float* input, float* output, uint32_t count);
+    void SRGBToLinear(SimdLevel level, TransferMode mode, const float* input, float* output, uint32_t count);
+
+    const float* Get_SRGB8_To_Linear_Table();
+}
+
+//--------------------------------------------------------------------------------------
+// Tonemapping
+// Batch ACESFilm for offline HDR images. Planar and interleaved RGB buffers are
+// tonemapped as one span, since every component goes through the same curve;
+// ACESFilm_RGBA leaves alpha untouched. Input and output may alias.
+//
+// The result is saturated in the same pass. Unlike the per-value ACESFilm above, which
+// follows the shader, NaN becomes 0 and +/-Inf become 1 (the limit of the curve).
+// Every SIMD level uses FMA in the same places, so results are identical across levels.
+// SSE4.2 has no FMA instructions, so it runs the scalar kernel, which uses fmaf().
+//--------------------------------------------------------------------------------------
+
+namespace Color
+{
+    void ACESFilm(const float* input, float* output, uint32_t count);
+    void ACESFilm(SimdLevel level, const float* input, float* output, uint32_t count);
+    void ACESFilm_RGBA(const float* input, float* output, uint32_t pixelCount);
+    void ACESFilm_RGBA(SimdLevel level, const float* input, float* output, uint32_t pixelCount);
+}
@@ -31,6 +31,10 @@
 #define WIN32_LEAN_AND_MEAN      // Exclude rarely-used items from Windows headers.
 #endif
 
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
 #include <Windows.h>
 
 #include <dxgi1_6.h>
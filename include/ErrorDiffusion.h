@@ -0,0 +1,66 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Threading.h"
+
+//--------------------------------------------------------------------------------------
+// Error Diffusion
+// Classic error diffusion dithering to 8 bits per channel, as an alternative to adding
+// noise. Each channel is a float plane of sRGB encoded values. The planes are diffused
+// in place (they accumulate the error), and the result is written as R8G8B8A8.
+//
+// Rows run in parallel on a wavefront: each row trails the row above, reading a pixel
+// only once every error into it is final, so the output is bit-identical to the serial
+// result for any thread count. With serpentine scanning a row starts where the row
+// above ends, so rows run one after another, and only the interleaved channels and
+// vectorized error propagation speed it up.
+//--------------------------------------------------------------------------------------
+
+enum DiffusionKernel
+{
+    DIFFUSION_FLOYD_STEINBERG = 0,
+    DIFFUSION_JARVIS,               // Jarvis, Judice, and Ninke
+    DIFFUSION_SIERRA,
+    DIFFUSION_COUNT,
+};
+
+struct DiffusionSettings
+{
+    DiffusionKernel kernel = DIFFUSION_FLOYD_STEINBERG;
+    bool serpentine = false;        // alternate the scan direction every row
+};
+
+namespace ErrorDiffusion
+{
+    const char* Get_Kernel_Name(DiffusionKernel kernel);
+
+    void Diffuse_Serial(const DiffusionSettings &settings, float* const planes[3], uint32_t width, uint32_t height, uint8_t* dest, size_t destPitch);
+    void Diffuse(ThreadPool &pool, const DiffusionSettings &settings, float* const planes[3], uint32_t width, uint32_t height, uint8_t* dest, size_t destPitch);
+}
@@ -0,0 +1,68 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Noise.h"
+#include "Threading.h"
+
+//--------------------------------------------------------------------------------------
+// Fixed Point Dithering
+// Dithers 16-bit linear color (already tonemapped, laid out like PIXEL_FORMAT_RGBA16) to
+// 8-bit sRGB (PIXEL_FORMAT_RGBA8) without any float math per pixel. The noise is added
+// to the 16-bit values as integers, and the sum indexes a table that holds the sRGB
+// encoded, rounded 8-bit code of every 16-bit value, so encoding and quantizing are a
+// single lookup.
+//
+// The noise of each 8-bit texel value (or, for white noise, the top 8 bits of the hash)
+// and of each threshold of an ordered dither matrix row is computed once per frame or
+// row, with the float Finalize() of the shader path, and rounded to 16-bit steps. The
+// output is within one code value of dithering the same input in float.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t FIXED_POINT_ONE = 65535;
+
+struct FixedPointNoise
+{
+    NoiseSource         source;
+    NoiseDistribution   distribution = DISTRIBUTION_UNIFORM;
+    float               noiseScale = 0.f;
+    uint32_t            width = 0;              // constants.resolutionX, seeds the white noise
+    uint32_t            frame = 0;
+    int32_t             offsets[256] = {};      // noise in 16-bit steps, by texel value or top byte of the hash
+};
+
+namespace FixedPoint
+{
+    const uint8_t* Get_Linear16_To_SRGB8_Table();
+
+    FixedPointNoise Create_Noise(const BandingConstants &constants, const NoiseTextures &textures);
+
+    void Dither_Row(const FixedPointNoise &noise, uint32_t x, uint32_t y, uint32_t count, const uint16_t* src, uint8_t* dest);
+    void Dither_Frame(ThreadPool &pool, const BandingConstants &constants, const NoiseTextures &textures, const PixelSpan &src, SoftwareFrame &frame);
+}
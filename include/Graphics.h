@@ -28,6 +28,7 @@
 #pragma once
 
 #include "Structures.h"
+#include "Backend.h"
 
 static const D3D12_HEAP_PROPERTIES UploadHeapProperties =
 {
@@ -51,11 +52,14 @@ namespace D3DResources
     void Create_BackBuffer_RTV(D3D12Global &d3d, D3D12Resources &resources);
     void Create_Descriptor_Heaps(D3D12Global &d3d, D3D12Resources &resources);
     void Create_PSO(D3D12Global &d3d, D3D12Resources &resources);
+    void Create_Dither_Output(D3D12Global &d3d, D3D12Resources &resources);
+    void Create_Timestamp_Queries(D3D12Global &d3d, D3D12Resources &resources);
     void Create_ConstantBuffer(D3D12Global &d3d, D3D12Resources &resources, BandingConstants &constants);
     
-    void Load_Shaders(D3D12Resources &resources, D3D12ShaderCompilerInfo &shaderCompiler);
-    void Load_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources, UINT num);
-    void Load_Blue_Noise_Texture(D3D12Global &d3d, D3D12Resources &resources);
+    void Load_Shaders(D3D12Global &d3d, D3D12Resources &resources, D3D12ShaderCompilerInfo &shaderCompiler);
+    void Load_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources, std::vector<TextureInfo> &textures);
+    void Load_Spatiotemporal_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources, std::vector<TextureInfo> &textures);
+    void Load_Blue_Noise_Texture(D3D12Global &d3d, D3D12Resources &resources, const TextureInfo &texture);
 
     void Upload_Texture(D3D12Global &d3d, ID3D12Resource* destResource, ID3D12Resource* srcResource, const TextureInfo &texture, UINT subresourceIndex);
 
@@ -80,9 +84,11 @@ namespace D3D12
     void Create_Viewport(D3D12Global &d3d);
     void Create_Scissor(D3D12Global &d3d);
     void Create_SwapChain(D3D12Global &d3d, HWND &window);
+    DXGI_FORMAT Get_BackBuffer_Format(const D3D12Global &d3d);
 
     ID3D12RootSignature* Create_Root_Signature(D3D12Global &d3d, const D3D12_ROOT_SIGNATURE_DESC &desc);
     void Build_CmdList(D3D12Global &d3d, D3D12Resources &resources);
+    void Read_Pass_Time(D3D12Global &d3d, D3D12Resources &resources);
 
     void Reset_CommandList(D3D12Global &d3d);
     void Submit_CmdList(D3D12Global &d3d);
@@ -91,4 +97,6 @@ namespace D3D12
     void MoveToNextFrame(D3D12Global &d3d);
 
     void Destroy(D3D12Global &d3d);
+
+    std::unique_ptr<RenderBackend> Create_Backend(HWND window, UINT computeGroupSize = 0);
 }
@@ -0,0 +1,68 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Simd.h"
+#include "Threading.h"
+
+//--------------------------------------------------------------------------------------
+// Quality Metrics
+// Compare a quantized frame against the float reference of the same frame (see
+// Software::Render_Reference()), in the sRGB encoded values that get quantized.
+//
+// PSNR     mean squared error of every RGB value, with a peak of 1
+// SSIM     mean structural similarity of luma (Rec. 709 weights) over 8x8 windows, placed every 4 pixels
+// Banding  RMS of the mean error of each window, in quantization steps, over the windows where
+//          the reference is a smooth gradient (a standard deviation under 2 steps). Dithering
+//          noise averages out within a window, while the staircase of a band survives, so this
+//          measures the error that is seen as contours.
+//
+// Windows and rows run in parallel on the pool, with partial sums combined in a fixed
+// order, so results do not depend on the thread count. The AVX2 kernels sum in a
+// different order than the scalar kernels, so results across levels agree to rounding.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t METRICS_WINDOW_SIZE = 8;
+static const uint32_t METRICS_WINDOW_STRIDE = 4;
+static const float METRICS_SMOOTH_THRESHOLD = 2.f;     // reference standard deviation, in quantization steps
+
+struct QualityMetrics
+{
+    double psnr = 0.0;              // dB, infinite when the frames are identical
+    double ssim = 0.0;
+    double banding = 0.0;           // quantization steps
+    double smoothFraction = 0.0;    // fraction of windows the banding score covers
+    double milliseconds = 0.0;
+};
+
+namespace Metrics
+{
+    QualityMetrics Compare(ThreadPool &pool, const ReferenceFrame &reference, const SoftwareFrame &frame, const PixelLayout &layout);
+    QualityMetrics Compare(ThreadPool &pool, SimdLevel level, const ReferenceFrame &reference, const SoftwareFrame &frame, const PixelLayout &layout);
+}
@@ -0,0 +1,284 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Simd.h"
+
+#include <cassert>
+#include <cmath>
+
+//--------------------------------------------------------------------------------------
+// Scalar mirrors of the random number generation in shaders/Common.hlsl
+//--------------------------------------------------------------------------------------
+
+namespace Noise
+{
+    /*
+     * From Nathan Reed's blog at:
+     * http://www.reedbeta.com/blog/quick-and-easy-gpu-random-numbers-in-d3d11/
+    */
+    inline uint32_t WangHash(uint32_t seed)
+    {
+        seed = (seed ^ 61) ^ (seed >> 16);
+        seed *= 9;
+        seed = seed ^ (seed >> 4);
+        seed *= 0x27d4eb2d;
+        seed = seed ^ (seed >> 15);
+        return seed;
+    }
+
+    inline uint32_t Xorshift(uint32_t seed)
+    {
+        // Xorshift algorithm from George Marsaglia's paper
+        seed ^= (seed << 13);
+        seed ^= (seed >> 17);
+        seed ^= (seed << 5);
+        return seed;
+    }
+
+    inline float GenerateRandomNumber(uint32_t &seed)
+    {
+        seed = WangHash(seed);
+        return float(Xorshift(seed)) * (1.f / 4294967296.f);
+    }
+
+    /**
+    * Transform a uniformly distributed value in [0, 1] to a triangular distribution in [0, 1].
+    */
+    inline float ToTriangular(float rnd)
+    {
+        float sign;
+        rnd = rnd * 2.f - 1.f;                              // shift to [-1, 1]
+        sign = (rnd > 0.f) ? 1.f : ((rnd < 0.f) ? -1.f : 0.f);
+        rnd = sign * (1.f - sqrtf(1.f - fabsf(rnd)));       // transform from uniform to triangular
+        return (rnd * 0.5f) + 0.5f;                         // shift back to [0, 1]
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Ordered Dither Matrices
+// Bayer matrices are built at compile time and indexed with a power of two mask, matching
+// GetOrderedDither() in ColorBanding.hlsl, which computes the same rank from the position bits.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t BAYER_MIN_SIZE = 2;
+static const uint32_t BAYER_MAX_SIZE = 64;
+
+namespace Noise
+{
+    /**
+    * Rank of (x, y) in the size x size Bayer matrix. The bits of (x ^ y) and y are interleaved,
+    * least significant first, so the lowest position bits decide the most significant rank bits.
+    */
+    constexpr uint32_t BayerRank(uint32_t x, uint32_t y, uint32_t size)
+    {
+        uint32_t rank = 0;
+        for (uint32_t bit = 1; bit < size; bit <<= 1)
+        {
+            rank = (rank << 2) | (((x ^ y) & bit) ? 2 : 0) | ((y & bit) ? 1 : 0);
+        }
+        return rank;
+    }
+
+    static_assert(BayerRank(0, 0, 2) == 0 && BayerRank(1, 0, 2) == 2 && BayerRank(0, 1, 2) == 3 && BayerRank(1, 1, 2) == 1, "Unexpected 2x2 Bayer matrix");
+    static_assert(BayerRank(1, 1, 4) == 4 && BayerRank(3, 3, 4) == 5 && BayerRank(1, 0, 4) == 8 && BayerRank(2, 0, 4) == 2, "Unexpected 4x4 Bayer matrix");
+
+    /**
+    * Thresholds of a Bayer matrix, centered in each of the size * size levels.
+    */
+    template<uint32_t Size>
+    struct BayerMatrix
+    {
+        static_assert(Size >= BAYER_MIN_SIZE && Size <= BAYER_MAX_SIZE && (Size & (Size - 1)) == 0, "Bayer matrix size must be a power of two from 2 to 64");
+        static const uint32_t mask = Size - 1;
+
+        float thresholds[Size * Size];
+
+        constexpr BayerMatrix() : thresholds()
+        {
+            for (uint32_t y = 0; y < Size; y++)
+            {
+                for (uint32_t x = 0; x < Size; x++)
+                {
+                    thresholds[(y * Size) + x] = ((float)BayerRank(x, y, Size) + 0.5f) / (float)(Size * Size);
+                }
+            }
+        }
+
+        constexpr float operator()(uint32_t x, uint32_t y) const { return thresholds[((y & mask) * Size) + (x & mask)]; }
+    };
+
+    const float* GetBayerMatrix(uint32_t size);
+}
+
+//--------------------------------------------------------------------------------------
+// Row Functions
+// Each fills count pixels of a row, starting at (x, y), with planar RGB noise in the
+// range [-noiseScale/2, noiseScale/2], matching the Get*Noise() functions in ColorBanding.hlsl.
+//--------------------------------------------------------------------------------------
+
+namespace Noise
+{
+    void GetWhiteNoiseRow(const BandingConstants &constants, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b);
+    void GetBlueNoiseRow(const BandingConstants &constants, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b);
+    void GetSpatiotemporalBlueNoiseRow(const BandingConstants &constants, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b);
+    void GetLDSBlueNoiseRow(const BandingConstants &constants, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b);
+    void GetOrderedDitherRow(const BandingConstants &constants, const float* thresholds, uint32_t size, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b);
+
+    void GetNoiseRow(const BandingConstants &constants, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b);
+}
+
+//--------------------------------------------------------------------------------------
+// Batch Functions
+// Uniformly distributed [0, 1] white noise for a run of pixels, bit-identical to calling
+// GenerateRandomNumber() three times per pixel with the seed ((y * width) + x) * frame.
+// The widest instruction set the CPU supports is used unless a level is given.
+//--------------------------------------------------------------------------------------
+
+namespace Noise
+{
+    void GenerateWhiteNoiseRow(uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b);
+    void GenerateWhiteNoiseRow(SimdLevel level, uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b);
+
+    void GenerateWhiteNoiseTile(uint32_t x, uint32_t y, uint32_t tileWidth, uint32_t tileHeight, uint32_t width, uint32_t frame, float* r, float* g, float* b, uint32_t pitch);
+}
+
+//--------------------------------------------------------------------------------------
+// Noise Sources
+// The texture slice, threshold matrix, and LDS offset of a frame are looked up once,
+// then each row is generated by a kernel specialized for the noise type and distribution,
+// so the renderer's fused tile kernels do not branch on either per pixel.
+//--------------------------------------------------------------------------------------
+
+enum NoiseType
+{
+    NOISE_WHITE = 0,
+    NOISE_BLUE,
+    NOISE_LDS_BLUE,
+    NOISE_SPATIOTEMPORAL_BLUE,
+    NOISE_ORDERED,
+    NOISE_NONE,                     // unknown types, or ordered dither without a matrix: no noise
+    NOISE_TYPE_COUNT,
+};
+
+enum NoiseDistribution
+{
+    DISTRIBUTION_UNIFORM = 0,
+    DISTRIBUTION_TRIANGULAR,
+    DISTRIBUTION_COUNT,
+};
+
+struct NoiseSource
+{
+    NoiseType           type = NOISE_NONE;
+    const TextureInfo*  texture = nullptr;      // the blue noise slice of the frame, or the LDS blue noise texture
+    const float*        thresholds = nullptr;   // ordered dither matrix, size * size values
+    uint32_t            size = 0;
+    float               offset = 0.f;           // LDS offset of the frame
+};
+
+namespace Noise
+{
+    NoiseSource GetNoiseSource(const BandingConstants &constants, const NoiseTextures &textures);
+    NoiseDistribution GetDistribution(const BandingConstants &constants);
+
+    /**
+    * Apply the distribution, then shift and scale the noise the same way the shader does before it is added to the color.
+    */
+    template<NoiseDistribution Distribution>
+    inline float Finalize(float rnd, float scale)
+    {
+        if (Distribution == DISTRIBUTION_TRIANGULAR) rnd = ToTriangular(rnd);
+
+        // D3D rounds when converting from FLOAT to UNORM
+        // Shift the random values from [0, 1] to [-0.5, 0.5] and scale
+        return (rnd - 0.5f) * scale;
+    }
+
+    /**
+    * Generate a row of noise from a source of the given type. Matches the Get*Noise() functions in ColorBanding.hlsl.
+    */
+    template<NoiseType Type, NoiseDistribution Distribution>
+    void GetNoiseRow(const BandingConstants &constants, const NoiseSource &source, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+    {
+        const float scale = constants.noiseScale;
+
+        if (Type == NOISE_WHITE)
+        {
+            GenerateWhiteNoiseRow(x, y, count, constants.resolutionX, constants.frameNumber, r, g, b);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                r[i] = Finalize<Distribution>(r[i], scale);
+                g[i] = Finalize<Distribution>(g[i], scale);
+                b[i] = Finalize<Distribution>(b[i], scale);
+            }
+        }
+        else if (Type == NOISE_BLUE || Type == NOISE_LDS_BLUE || Type == NOISE_SPATIOTEMPORAL_BLUE)
+        {
+            const TextureInfo &texture = *source.texture;
+            const uint8_t* row = &texture.Get_Pixels()[(y % texture.height) * texture.width * texture.stride];
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const uint8_t* texel = &row[((x + i) % texture.width) * texture.stride];
+                float rnd[3];
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    rnd[c] = texel[c] / 255.f;
+                    if (Type == NOISE_LDS_BLUE)
+                    {
+                        // Generate a low discrepancy sequence
+                        rnd[c] += source.offset;
+                        rnd[c] -= floorf(rnd[c]);
+                    }
+                }
+
+                r[i] = Finalize<Distribution>(rnd[0], scale);
+                g[i] = Finalize<Distribution>(rnd[1], scale);
+                b[i] = Finalize<Distribution>(rnd[2], scale);
+            }
+        }
+        else if (Type == NOISE_ORDERED)
+        {
+            // The matrix is at most 64 wide, so its row is finalized once and then tiled,
+            // and every channel gets the same threshold
+            const uint32_t mask = source.size - 1;
+            const float* row = &source.thresholds[(y & mask) * source.size];
+
+            float noise[BAYER_MAX_SIZE];
+            assert(source.size <= BAYER_MAX_SIZE);
+            for (uint32_t i = 0; i < source.size; i++) noise[i] = Finalize<Distribution>(row[i], scale);
+            for (uint32_t i = 0; i < count; i++) r[i] = g[i] = b[i] = noise[(x + i) & mask];
+        }
+        else
+        {
+            for (uint32_t i = 0; i < count; i++) r[i] = g[i] = b[i] = 0.f;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Simd.h"
+
+//--------------------------------------------------------------------------------------
+// Quantization
+// Converts [0, 1] floats (sRGB encoded, with the dither noise already added) to UNORM
+// values of any bit depth, and packs them into the pixel layout of the target, the same
+// way D3D converts FLOAT to UNORM when writing to a render target: saturate, scale by
+// the largest value, and round. Every SIMD level returns identical results.
+//
+// The noise that hides the quantization is sized to its step: 1 / (2^bits - 1) with a
+// uniform distribution, and twice that with a triangular distribution, whose error is
+// then independent of the signal. Layouts with different depths per channel use the
+// coarsest step, so every channel gets at least enough noise.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t QUANTIZE_MAX_BITS = 16;
+
+namespace Quantize
+{
+    const char* Get_Format_Name(PixelFormat format);
+    PixelLayout Get_Layout(PixelFormat format);
+    PixelLayout Create_Layout(uint32_t redBits, uint32_t greenBits, uint32_t blueBits, uint32_t alphaBits);
+
+    uint32_t Get_Color_Bits(const PixelLayout &layout);
+    float Get_Noise_Scale(uint32_t bits, int distribution);
+    float Get_Noise_Scale(const PixelLayout &layout, int distribution);
+
+    void Pack_Row(const PixelLayout &layout, const float* r, const float* g, const float* b, const float* a, uint32_t count, void* dest);
+    void Pack_Row(SimdLevel level, const PixelLayout &layout, const float* r, const float* g, const float* b, const float* a, uint32_t count, void* dest);
+    void Unpack_Row(const PixelLayout &layout, const void* src, uint32_t count, float* r, float* g, float* b, float* a);
+    void Unpack_Row(SimdLevel level, const PixelLayout &layout, const void* src, uint32_t count, float* r, float* g, float* b, float* a);
+}
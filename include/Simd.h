@@ -0,0 +1,90 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+//--------------------------------------------------------------------------------------
+// SIMD Support
+// Kernels for wider instruction sets are compiled into the same translation units and
+// selected at runtime, so the build does not need any /arch or -m flags. Kernels that
+// promise identical results at every level rely on mul and add not being contracted
+// into FMA, which is the MSVC default and needs -ffp-contract=off with GCC.
+//
+// The CPU is probed once, and each module binds the kernels of the widest level to
+// function pointers the first time they are called. Set COLORBANDING_SIMD to scalar,
+// sse4.2, avx2, or avx512 to use a lower level, for A/B comparisons. A level the CPU
+// does not support falls back to the widest one it does.
+//--------------------------------------------------------------------------------------
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma")))
+#else
+#define SIMD_TARGET_SSE42
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#endif
+
+// GCC's avx512fintrin.h fills the unused lanes of its unmasked intrinsics with self-initialized
+// _mm512_undefined_*() values, which -Wmaybe-uninitialized reports wherever they are inlined.
+// Wrap the AVX-512 kernels in SIMD_AVX512_BEGIN and SIMD_AVX512_END to silence only those.
+#if SIMD_X86 && defined(__GNUC__) && !defined(__clang__)
+#define SIMD_AVX512_BEGIN _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define SIMD_AVX512_END _Pragma("GCC diagnostic pop")
+#else
+#define SIMD_AVX512_BEGIN
+#define SIMD_AVX512_END
+#endif
+
+static const char* const SIMD_LEVEL_VARIABLE = "COLORBANDING_SIMD";
+
+enum SimdLevel
+{
+    SIMD_SCALAR = 0,
+    SIMD_SSE42,
+    SIMD_AVX2,
+    SIMD_AVX512,
+    SIMD_LEVEL_COUNT,
+};
+
+namespace Simd
+{
+    SimdLevel Get_Level();
+    SimdLevel Get_CPU_Level();
+    const char* Get_Level_Name(SimdLevel level);
+    bool Parse_Level(const char* name, SimdLevel &level);
+}
@@ -0,0 +1,51 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Threading.h"
+
+//--------------------------------------------------------------------------------------
+// Software Renderer
+// Evaluates the VS()/PS() fullscreen pass from shaders/ColorBanding.hlsl on the CPU.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t SOFTWARE_TILE_SIZE = 64;
+
+namespace Software
+{
+    void Create_Frame(SoftwareFrame &frame, uint32_t width, uint32_t height, const PixelLayout &layout = PixelLayout());
+    void Create_Reference(ReferenceFrame &frame, uint32_t width, uint32_t height);
+
+    void Shade_Row(const BandingConstants &constants, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b);
+    void Resolve_Row(const BandingConstants &constants, const SoftwareSettings &settings, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b, uint8_t* dest);
+
+    void Render_Tile(const BandingConstants &constants, const SoftwareSettings &settings, const NoiseTextures &textures, SoftwareFrame &frame, uint32_t tileIndex);
+    void Render_Frame(ThreadPool &pool, const BandingConstants &constants, const SoftwareSettings &settings, const NoiseTextures &textures, SoftwareFrame &frame);
+    void Render_Reference(ThreadPool &pool, const BandingConstants &constants, const SoftwareSettings &settings, ReferenceFrame &frame);
+}
@@ -0,0 +1,74 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Threading.h"
+
+#include <complex>
+
+//--------------------------------------------------------------------------------------
+// Noise Spectrum
+// Capture frames of noise with the CPU equivalent of showNoise (Noise::GetNoiseRow(),
+// with a noise scale of 1), and average their power spectra, to check the spectral
+// claims of each noise type: white noise is flat, and blue noise has little power at
+// low frequencies.
+//
+// Each channel of each frame has its mean removed, and goes through a 2D FFT (radix-2,
+// rows then columns, each split across the pool). Power is |F|^2 / size^2, so white noise
+// has a flat spectrum at its variance. The radial profile averages the power over rings
+// of integer radius (in cycles per size pixels, up to the Nyquist frequency of size / 2),
+// relative to the mean power, so white noise is 1 at every radius.
+//
+// Blueness is 1 - (the mean power below a quarter of the Nyquist frequency) / (the mean
+// power): about 0 for white noise, approaching 1 for blue noise, and negative when the
+// noise is clumped into low frequencies.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t SPECTRUM_MIN_SIZE = 8;
+static const uint32_t SPECTRUM_MAX_SIZE = 4096;
+
+struct NoiseSpectrum
+{
+    uint32_t size = 0;
+    uint32_t frames = 0;
+    std::vector<float> power;       // size * size, averaged over frames and channels, with DC at the center
+    std::vector<float> radial;      // size / 2 + 1 rings, relative to the mean power
+    double meanPower = 0.0;         // over every frequency except DC
+    double blueness = 0.0;
+    double milliseconds = 0.0;
+};
+
+namespace Spectrum
+{
+    void FFT(std::complex<float>* data, uint32_t size, bool inverse = false);
+    void FFT_2D(ThreadPool &pool, std::complex<float>* data, uint32_t size, bool inverse = false);
+
+    NoiseSpectrum Analyze_Noise(ThreadPool &pool, const BandingConstants &constants, const NoiseTextures &textures, uint32_t size, uint32_t frames);
+    void Write_Spectrum(const std::string &filepath, const NoiseSpectrum &spectrum);
+}
@@ -28,6 +28,7 @@
 #pragma once
 
 #include "Common.h"
+#include "Types.h"
 
 //--------------------------------------------------------------------------------------
 // Global
@@ -38,33 +39,13 @@ struct ConfigInfo
     int          width = 640;
     int          height = 360;
     bool         vsync = false;
+    int          blueNoiseSize = 0;         // 0 loads the textures in data/blue-noise, otherwise generates them
+    int          blueNoiseSlices = 64;
+    PixelFormat  backBufferFormat = PIXEL_FORMAT_RGBA8;     // RGBA8 or RGB10A2
+    int          computeGroupSize = 0;      // 0 dithers with the graphics PSO, 8 or 16 with the compute shader
     HINSTANCE    instance = NULL;
 };
 
-struct BandingConstants
-{
-    DirectX::XMFLOAT3    lightPosition;
-    float                noiseScale;
-    DirectX::XMFLOAT3    color;
-    UINT32               resolutionX;
-    UINT32               frameNumber = 0;
-    int                  useDithering = 0;
-    int                  showNoise = 0;
-    int                  noiseType = 0;          // 0: white noise, 1: blue noise
-    int                  distributionType = 0;   // 0: uniform, 1: triangular
-    int                  useTonemapping = 1;
-    DirectX::XMINT2      pad;
-};
-
-struct TextureInfo
-{
-    std::vector<UINT8> pixels;
-    int width = 0;
-    int height = 0;
-    int stride = 0;
-    int offset = 0;
-};
-
 //--------------------------------------------------------------------------------------
 // D3D12
 //--------------------------------------------------------------------------------------
@@ -133,12 +114,21 @@ struct D3D12Resources
 
     ID3D12RootSignature*                       rs = nullptr;
     ID3D12PipelineState*                       pso = nullptr;
+
+    ID3D12RootSignature*                       computeRS = nullptr;
+    ID3D12PipelineState*                       computePSO = nullptr;
+    ID3D12Resource*                            ditherOutput = nullptr;      // written by the compute shader, then copied to the back buffer
+
+    ID3D12QueryHeap*                           timestampHeap = nullptr;          // a begin and end timestamp per frame in flight
+    ID3D12Resource*                            timestampReadback = nullptr;
+    UINT64                                     timestampFences[2] = { 0, 0 };    // the fence value each frame's timestamps are ready at, 0 once read
     
     ID3D12Resource*                            bandingCB = nullptr;
     UINT8*                                     bandingCBStart = 0;
 
     IDxcBlob*                                  vsBytecode = nullptr;
     IDxcBlob*                                  psBytecode = nullptr;
+    IDxcBlob*                                  csBytecode = nullptr;
 
     ID3D12Resource*                            blueNoise = nullptr;
     ID3D12Resource*                            blueNoiseUploadResource = nullptr;
@@ -146,6 +136,9 @@ struct D3D12Resources
     ID3D12Resource*                            blueNoiseArray = nullptr;
     ID3D12Resource*                            blueNoiseArrayUploadResource = nullptr;
 
+    ID3D12Resource*                            spatiotemporalBlueNoiseArray = nullptr;
+    ID3D12Resource*                            spatiotemporalBlueNoiseArrayUploadResource = nullptr;
+
     UINT                                       rtvDescSize = 0;
     UINT                                       cbvSrvUavDescSize = 0;
 };
@@ -174,4 +167,9 @@ struct D3D12Global
     int                                        width = 640;
     int                                        height = 360;
     bool                                       vsync = false;
+    PixelFormat                                backBufferFormat = PIXEL_FORMAT_RGBA8;
+
+    bool                                       useCompute = false;         // dither with the compute PSO instead of the graphics PSO
+    UINT                                       computeGroupSize = 8;
+    float                                      passTime = 0.f;             // GPU milliseconds of the dither pass, averaged over frames
 };
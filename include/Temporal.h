@@ -0,0 +1,105 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "Simd.h"
+#include "Threading.h"
+
+//--------------------------------------------------------------------------------------
+// Temporal Statistics
+// Temporal dithering works when the mean of each pixel over frames converges to its
+// true value. The accumulator streams frames in, keeping a running mean and variance per
+// pixel and channel (Welford's method), so no frame is stored, and compares them against
+// the float reference of the frame (see Software::Render_Reference()).
+//
+// Bias         error of the per-pixel mean against the reference, once the frames are averaged
+// Deviation    per-pixel standard deviation over the frames
+// Flicker      RMS change of each value from one frame to the next
+// Convergence  RMS error of the running mean after each frame
+// Eye          RMS error of an exponential filter of the frames, y += alpha * (x - y) with
+//              alpha = 1 - exp(-1 / (rate * timeConstant)), as a model of the eye's temporal
+//              integration at each refresh rate. The same frame sequence is filtered at every
+//              rate, so faster displays average more frames within the time constant.
+//
+// Errors are in quantization steps of the frame's layout. Rows run in parallel on the pool,
+// with partial sums combined in a fixed order. The AVX2 kernel sums in a different order
+// than the scalar kernel, so statistics across levels agree to rounding.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t TEMPORAL_MAX_RATES = 4;
+static const float TEMPORAL_EYE_TIME_CONSTANT = 0.04f;         // seconds
+static const float TEMPORAL_WARM_UP = 3.f;                     // time constants before the eye filter is measured
+
+struct TemporalSettings
+{
+    float refreshRates[TEMPORAL_MAX_RATES] = { 60.f, 120.f, 240.f, 0.f };
+    uint32_t numRates = 3;
+    float eyeTimeConstant = TEMPORAL_EYE_TIME_CONSTANT;
+};
+
+struct TemporalAccumulator
+{
+    TemporalSettings settings;
+    const ReferenceFrame* reference = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t frames = 0;
+    double maxCode = 0.0;
+
+    std::vector<float> mean[3];
+    std::vector<float> m2[3];                               // sum of squared differences from the mean
+    std::vector<float> previous[3];
+    std::vector<float> eye[TEMPORAL_MAX_RATES][3];
+
+    double flicker = 0.0;                                   // sum of squared frame to frame changes
+    std::vector<double> convergence;                        // RMS error of the running mean after each frame, in steps
+    std::vector<double> eyeError[TEMPORAL_MAX_RATES];       // RMS error of each eye filter after each frame, in steps
+};
+
+struct TemporalStats
+{
+    uint32_t frames = 0;
+    double bias = 0.0;                                      // RMS, in steps
+    double maxBias = 0.0;
+    double meanBias = 0.0;                                  // signed
+    double deviation = 0.0;                                 // RMS of the per-pixel standard deviation, in steps
+    double flicker = 0.0;                                   // in steps
+    double eyeError[TEMPORAL_MAX_RATES] = {};               // mean after the warm up, in steps
+};
+
+namespace Temporal
+{
+    void Create_Accumulator(TemporalAccumulator &accumulator, const ReferenceFrame &reference, const TemporalSettings &settings = TemporalSettings());
+    void Accumulate(ThreadPool &pool, TemporalAccumulator &accumulator, const SoftwareFrame &frame, const PixelLayout &layout);
+    void Accumulate(ThreadPool &pool, SimdLevel level, TemporalAccumulator &accumulator, const SoftwareFrame &frame, const PixelLayout &layout);
+
+    float Get_Bias(const TemporalAccumulator &accumulator, uint32_t channel, size_t index);
+    float Get_Variance(const TemporalAccumulator &accumulator, uint32_t channel, size_t index);
+    TemporalStats Get_Stats(ThreadPool &pool, const TemporalAccumulator &accumulator);
+}
@@ -0,0 +1,176 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// Portable Types
+// Shared by the D3D12 application and the software renderer, so no Windows headers here.
+//--------------------------------------------------------------------------------------
+
+struct Float3
+{
+    float x = 0.f;
+    float y = 0.f;
+    float z = 0.f;
+
+    Float3() {}
+    Float3(float inX, float inY, float inZ) : x(inX), y(inY), z(inZ) {}
+};
+
+struct Int2
+{
+    int x = 0;
+    int y = 0;
+};
+
+// Layout matches the BandingConstants cbuffer in shaders/ColorBanding.hlsl
+struct BandingConstants
+{
+    Float3               lightPosition;
+    float                noiseScale;
+    Float3               color;
+    uint32_t             resolutionX;
+    uint32_t             frameNumber = 0;
+    int                  useDithering = 0;
+    int                  showNoise = 0;
+    int                  noiseType = 0;          // 0: white noise, 1: blue noise, 2: LDS blue noise, 3: spatiotemporal blue noise, 4: ordered dither
+    int                  distributionType = 0;   // 0: uniform, 1: triangular
+    int                  useTonemapping = 1;
+    uint32_t             ditherMatrixSize = 8;   // size of the ordered dither Bayer matrix, a power of two from 2 to 64
+    int                  pad = 0;
+};
+
+static_assert(sizeof(BandingConstants) == 64, "BandingConstants must match the HLSL cbuffer layout");
+
+struct TextureInfo
+{
+    std::vector<uint8_t> pixels;
+    const uint8_t* mappedPixels = nullptr;      // set instead of pixels when the texture lives in a memory-mapped file
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    int offset = 0;
+
+    const uint8_t* Get_Pixels() const { return mappedPixels ? mappedPixels : pixels.data(); }
+};
+
+struct PixelSpan
+{
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t rowPitch = 0;            // bytes from the start of one row to the next
+};
+
+struct MappedFile
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+struct ImageInfo
+{
+    std::vector<float> pixels;      // linear color (alpha is left as is), stride floats per pixel
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+};
+
+//--------------------------------------------------------------------------------------
+// Pixel Formats
+//--------------------------------------------------------------------------------------
+
+enum PixelFormat
+{
+    PIXEL_FORMAT_RGBA8 = 0,         // DXGI_FORMAT_R8G8B8A8_UNORM
+    PIXEL_FORMAT_RGB565,            // DXGI_FORMAT_B5G6R5_UNORM, red in the high bits
+    PIXEL_FORMAT_RGB10A2,           // DXGI_FORMAT_R10G10B10A2_UNORM
+    PIXEL_FORMAT_RGBA16,            // DXGI_FORMAT_R16G16B16A16_UNORM
+    PIXEL_FORMAT_COUNT,
+};
+
+// Bit layout of a packed UNORM pixel, see Quantize::Get_Layout() and Quantize::Create_Layout()
+struct PixelLayout
+{
+    uint8_t bits[4] = { 8, 8, 8, 8 };       // RGBA, 0 leaves the channel out
+    uint8_t shift[4] = { 0, 8, 16, 24 };    // position of each channel's least significant bit
+    uint32_t bytesPerPixel = 4;             // 1, 2, 4, or 8, pixels are little endian words
+};
+
+//--------------------------------------------------------------------------------------
+// Software Renderer
+//--------------------------------------------------------------------------------------
+
+enum TransferMode
+{
+    TRANSFER_REFERENCE = 0,
+    TRANSFER_LUT,
+    TRANSFER_POLYNOMIAL,
+};
+
+struct SoftwareSettings
+{
+    TransferMode transferMode = TRANSFER_POLYNOMIAL;
+    PixelLayout  layout;            // of the frame pixels, R8G8B8A8 by default
+};
+
+struct ThresholdMatrix
+{
+    std::vector<float> thresholds;  // size * size values in [0, 1], row major
+    uint32_t size = 0;              // a power of two
+};
+
+struct NoiseTextures
+{
+    TextureInfo                 blueNoise;          // rgb-256.png, used by the LDS blue noise
+    std::vector<TextureInfo>    blueNoiseArray;     // LDR_RGB1_*.png, one slice per frame
+    std::vector<TextureInfo>    spatiotemporalArray;    // generated, blue over space and time, one slice per frame
+    std::shared_ptr<MappedFile> cache;              // keeps mapped pixels alive, see BlueNoise::Load_Textures()
+    std::shared_ptr<MappedFile> spatiotemporalCache;    // the same for spatiotemporalArray, see BlueNoise::Load_Spatiotemporal_Textures()
+    ThresholdMatrix             thresholdMatrix;    // custom ordered dither matrix, the Bayer matrix is used when empty
+};
+
+struct SoftwareFrame
+{
+    std::vector<uint8_t> pixels;    // packed with SoftwareSettings::layout, R8G8B8A8 matches the swap chain format
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t rowPitch = 0;
+    uint32_t bytesPerPixel = 4;
+};
+
+struct ReferenceFrame
+{
+    std::vector<float> planes[3];   // RGB, sRGB encoded like the frame, but before dithering and quantization
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
@@ -27,7 +27,13 @@
 
 #pragma once
 
+#include "Types.h"
+
+#include <functional>
+
+#ifdef _WIN32
 #include "Structures.h"
+#endif
 
 //--------------------------------------------------------------------------------------
 // Functions
@@ -35,11 +41,24 @@
 
 namespace Utils
 {
+#ifdef _WIN32
     HRESULT ParseCommandLine(LPWSTR lpCmdLine, ConfigInfo &config);
 
-    std::vector<char> ReadFile(const std::string &filename);
-
     void Validate(HRESULT hr, LPWSTR message);
+#endif
 
+    std::vector<char> ReadFile(const std::string &filename);
+
+    void ExpandToRGBA(const uint8_t* src, int srcStride, uint8_t* dest, uint32_t count);
+    TextureInfo DecodeTexture(const std::string &filepath, const std::function<PixelSpan(const TextureInfo&)> &getDest);
+    void CopyTexture(const TextureInfo &texture, const PixelSpan &dest);
     TextureInfo LoadTexture(std::string filepath);
+    ImageInfo LoadLinearImage(std::string filepath);
+
+    ThresholdMatrix LoadThresholdMatrix(const std::string &filepath);
+
+    void WritePNG(const std::string &filepath, const uint8_t* pixels, int width, int height, int stride);
+
+    bool MapFile(const std::string &filepath, MappedFile &file);
+    void UnmapFile(MappedFile &file);
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Backend.h"
+
+//--------------------------------------------------------------------------------------
+// Vulkan Backend
+// Renders the fullscreen pass of shaders/ColorBanding.hlsl offscreen with Vulkan, from
+// SPIR-V that DXC compiles from the same HLSL, and reads the frames back. It needs no
+// window or GPU, so it runs on Mesa's lavapipe driver. Build the shaders with:
+//
+//   dxc -spirv -fvk-use-dx-layout -fvk-t-shift 1 0 -T vs_6_0 -E VS -Fo bin/ColorBanding.vs.spv shaders/ColorBanding.hlsl
+//   dxc -spirv -fvk-use-dx-layout -fvk-t-shift 1 0 -T ps_6_0 -E PS -Fo bin/ColorBanding.ps.spv shaders/ColorBanding.hlsl
+//
+// The t register shift moves the textures to bindings 1-3, after the constant buffer at 0.
+//
+// Experimental: this backend has not been compiled or run yet. The binding layout, the
+// TRANSFER_SRC final layout, the tightly packed readback copy, and the A2B10G10R10 mapping
+// of RGB10A2 are unverified until a -soak 100 -backend 1 run on lavapipe matches software.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t VULKAN_CONSTANTS_BINDING = 0;
+static const uint32_t VULKAN_TEXTURE_BINDING = 1;     // blueNoise, then blueNoiseArray and spatiotemporalBlueNoiseArray at 2 and 3
+
+namespace Vulkan
+{
+    std::unique_ptr<RenderBackend> Create_Backend(const std::string &shaderPrefix = "bin/ColorBanding");
+}
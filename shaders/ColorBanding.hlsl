@@ -49,11 +49,13 @@ cbuffer BandingConstants : register(b0)
     int     noiseType;
     int     distributionType;
     int     useTonemapping;
-    int2    pad;
+    uint    ditherMatrixSize;
+    int     pad;
 };
 
 Texture2D<float4> blueNoise : register(t0);
 Texture2DArray<float4> blueNoiseArray : register(t1);
+Texture2DArray<float4> spatiotemporalBlueNoiseArray : register(t2);
 
 // ---[ Vertex Shader ]---
 
@@ -121,17 +123,21 @@ float3 GetWhiteNoise(uint2 position, uint width, uint frame, uint distribution,
 */
 float3 GetBlueNoise(uint2 position, uint width, uint frame, uint distribution, float scale)
 {
+    // The textures are either the pre-baked 64x64x64 set or generated, with power of two sizes
+    uint textureWidth, textureHeight, numSlices;
+    blueNoiseArray.GetDimensions(textureWidth, textureHeight, numSlices);
+
     // Load a blue noise value from texture based on:
     // space - this thread's (x, y) position in the image
     // time  - the current frame number, used to select the texture array slice
-    float3 rnd = blueNoiseArray.Load(int4(position.xy % 64, frame % 64, 0)).rgb;
+    float3 rnd = blueNoiseArray.Load(int4(position.xy & (uint2(textureWidth, textureHeight) - 1), frame % numSlices, 0)).rgb;
 
     if (distribution == 1)
     {
         // Use a triangular distribution instead of a uniform distribution
 
         // Option 1: Load a second set of blue noise samples
-        //float3 rnd1 = blueNoiseArray.Load(int4(position.xy % 64, (frame + 1) % 64, 0)).rgb;
+        //float3 rnd1 = blueNoiseArray.Load(int4(position.xy & (uint2(textureWidth, textureHeight) - 1), (frame + 1) % numSlices, 0)).rgb;
         //rnd = (rnd + rnd1) / 2.f;
 
         // Option 2: Transform the uniform distribution of the first sample to be triangular
@@ -149,6 +155,39 @@ float3 GetBlueNoise(uint2 position, uint width, uint frame, uint distribution, f
     return (rnd * scale);
 }
 
+/**
+* Generate three components of spatiotemporal blue noise in image-space.
+* The slices are ranked together over space and time (Wolfe et al. 2022), so each pixel's
+* sequence is also blue over time and averages out faster than independent slices.
+*/
+float3 GetSpatiotemporalBlueNoise(uint2 position, uint width, uint frame, uint distribution, float scale)
+{
+    // The textures are generated at startup, with power of two sizes
+    uint textureWidth, textureHeight, numSlices;
+    spatiotemporalBlueNoiseArray.GetDimensions(textureWidth, textureHeight, numSlices);
+
+    // Load a blue noise value from texture based on:
+    // space - this thread's (x, y) position in the image
+    // time  - the current frame number, consecutive frames use consecutive slices
+    float3 rnd = spatiotemporalBlueNoiseArray.Load(int4(position.xy & (uint2(textureWidth, textureHeight) - 1), frame % numSlices, 0)).rgb;
+
+    if (distribution == 1)
+    {
+        // Transform the uniform distribution of the first sample to be triangular
+        rnd = mad(rnd, 2.f, -1.f);                      // shift to [-1, 1]
+        rnd = sign(rnd) * (1.f - sqrt(1.f - abs(rnd))); // transform from uniform to triangular
+        rnd = (rnd * 0.5f) + 0.5f;                      // shift back to [0, 1]
+    }
+
+    // D3D rounds when converting from FLOAT to UNORM
+    // Shift the random values from [0, 1] to [-0.5, 0.5]
+    rnd -= 0.5f;
+
+    // Scale the noise magnitude, values are in the range [-scale/2, scale/2]
+    // The scale should be determined by the precision (and therefore quantization amount) of the target image's format
+    return (rnd * scale);
+}
+
 /**
 * Generate three components of low discrepancy blue noise in image-space.
 * Blue noise texture from Christoph Peters at: http://momentsingraphics.de/BlueNoise.html
@@ -158,7 +197,9 @@ float3 GetLDSBlueNoise(uint2 position, uint width, uint frame, uint distribution
     static const float goldenRatioConjugate = 0.61803398875f;
 
     // Load a blue noise value from texture
-    float3 rnd = blueNoise.Load(int3(position % 256, 0)).rgb;
+    uint textureWidth, textureHeight;
+    blueNoise.GetDimensions(textureWidth, textureHeight);
+    float3 rnd = blueNoise.Load(int3(position & (uint2(textureWidth, textureHeight) - 1), 0)).rgb;
 
     // Generate a low discrepancy sequence
     rnd = frac(rnd + goldenRatioConjugate * ((frame - 1) % 16));
@@ -181,11 +222,49 @@ float3 GetLDSBlueNoise(uint2 position, uint width, uint frame, uint distribution
     return (rnd * scale);
 }
 
-// ---[ Pixel Shader ]---
+/**
+* Generate three components of ordered dither noise in image-space, from a Bayer matrix.
+* The rank is computed from the bits of the position, so there is no texture fetch or hash.
+* This is the cheapest dither, but the pattern is visible and does not change over time.
+*/
+float3 GetOrderedDither(uint2 position, uint matrixSize, uint distribution, float scale)
+{
+    // Wrap the position to the matrix, which is a power of two from 2x2 to 64x64
+    uint2 p = position & (matrixSize - 1);
 
-float4 PS(PSInput input) : SV_TARGET
+    // Interleave the bits of (x ^ y) and y, least significant first, to get the rank in the matrix
+    uint rank = 0;
+    for (uint bit = 1; bit < matrixSize; bit <<= 1)
+    {
+        rank = (rank << 2) | (((p.x ^ p.y) & bit) ? 2 : 0) | ((p.y & bit) ? 1 : 0);
+    }
+
+    // Center the threshold in its level, every channel uses the same threshold
+    float3 rnd = ((float)rank + 0.5f) / (float)(matrixSize * matrixSize);
+
+    if (distribution == 1)
+    {
+        // Transform the uniform distribution of the thresholds to be triangular
+        rnd = mad(rnd, 2.f, -1.f);                      // shift to [-1, 1]
+        rnd = sign(rnd) * (1.f - sqrt(1.f - abs(rnd))); // transform from uniform to triangular
+        rnd = (rnd * 0.5f) + 0.5f;                      // shift back to [0, 1]
+    }
+
+    // D3D rounds when converting from FLOAT to UNORM
+    // Shift the random values from [0, 1] to [-0.5, 0.5]
+    rnd -= 0.5f;
+
+    // Scale the noise magnitude, values are in the range [-scale/2, scale/2]
+    // The scale should be determined by the precision (and therefore quantization amount) of the target image's format
+    return (rnd * scale);
+}
+
+/**
+* Light the plane at a pixel position (pixel centers are at +0.5), and tonemap it.
+*/
+float3 Shade(float2 position)
 {
-    float3 worldPosition = float3(input.position.x, 0.f, input.position.y);
+    float3 worldPosition = float3(position.x, 0.f, position.y);
     float3 normal = float3(0.f, 1.f, 0.f);
     float3 lightVector = float3(lightPosition - worldPosition);
     float3 lightDirection = normalize(lightVector);
@@ -198,23 +277,38 @@ float4 PS(PSInput input) : SV_TARGET
     {
         result = ACESFilm(result);
     }
+    return result;
+}
 
-    // Dither
+/**
+* Dither a shaded color at a pixel position with the selected noise, and gamma correct it.
+* Shared by PS() and CS(), so a new noise type only needs adding here.
+*/
+float4 Dither(uint2 pixel, float3 result)
+{
     if (useDithering > 0)
     {
         // Compute the noise
         float3 noise = 0;
         if (noiseType == 0)
         {
-            noise = GetWhiteNoise(uint2(input.position.xy), resolutionX, frameNumber, distributionType, noiseScale);
+            noise = GetWhiteNoise(pixel, resolutionX, frameNumber, distributionType, noiseScale);
         }
         else if(noiseType == 1)
         {
-            noise =  GetBlueNoise(uint2(input.position.xy), resolutionX, frameNumber, distributionType, noiseScale);
+            noise =  GetBlueNoise(pixel, resolutionX, frameNumber, distributionType, noiseScale);
         }
         else if (noiseType == 2)
         {
-            noise = GetLDSBlueNoise(uint2(input.position.xy), resolutionX, frameNumber, distributionType, noiseScale);
+            noise = GetLDSBlueNoise(pixel, resolutionX, frameNumber, distributionType, noiseScale);
+        }
+        else if (noiseType == 3)
+        {
+            noise = GetSpatiotemporalBlueNoise(pixel, resolutionX, frameNumber, distributionType, noiseScale);
+        }
+        else if (noiseType == 4)
+        {
+            noise = GetOrderedDither(pixel, ditherMatrixSize, distributionType, noiseScale);
         }
 
         if (showNoise)
@@ -231,3 +325,36 @@ float4 PS(PSInput input) : SV_TARGET
 
     return float4(result, 1.f);
 }
+
+// ---[ Pixel Shader ]---
+
+float4 PS(PSInput input) : SV_TARGET
+{
+    return Dither(uint2(input.position.xy), Shade(input.position.xy));
+}
+
+// ---[ Compute Shader ]---
+
+// 8x8 or 16x16, set with a define when the shader is compiled
+#ifndef DITHER_GROUP_SIZE
+#define DITHER_GROUP_SIZE 8
+#endif
+
+RWTexture2D<float4> output : register(u0);
+
+/**
+* The dither pass of PS() as a compute shader that writes a UAV. Each thread shades, dithers,
+* and writes one pixel with the same Dither() as PS(), so the two paths differ only in
+* how the work is launched and written: thread groups and a UAV instead of rasterization and
+* a render target.
+*/
+[numthreads(DITHER_GROUP_SIZE, DITHER_GROUP_SIZE, 1)]
+void CS(uint3 pixel : SV_DispatchThreadID)
+{
+    // Groups on the right and bottom edges run past the image
+    uint width, height;
+    output.GetDimensions(width, height);
+    if (pixel.x >= width || pixel.y >= height) return;
+
+    output[pixel.xy] = Dither(pixel.xy, Shade(float2(pixel.xy) + 0.5f));
+}
@@ -0,0 +1,198 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Application.h"
+#include "BlueNoise.h"
+#include "Quantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <future>
+
+using namespace std;
+
+/**
+* Load or generate the blue noise textures on a thread pool of their own. The spatiotemporal
+* blue noise is mapped from its cache, and only generated when the cache is missing.
+*/
+static NoiseTextures Load_Blue_Noise(ApplicationConfig config, BlueNoiseLoadStats* stats)
+{
+    ThreadPool pool;
+    Threading::Create(pool);
+
+    NoiseTextures textures;
+    try
+    {
+        if (config.blueNoiseSize > 0)
+        {
+            BlueNoise::Generate_Textures(pool, textures, (uint32_t)config.blueNoiseSize, (uint32_t)max(config.blueNoiseSlices, 1), 0);
+        }
+        else
+        {
+            BlueNoise::Load_Textures(pool, textures, 64, stats);
+        }
+
+        // The spatiotemporal blue noise has no pre-baked textures, so the first run generates and caches it
+        BlueNoise::Load_Spatiotemporal_Textures(pool, textures, BLUE_NOISE_SPATIOTEMPORAL_SIZE, BLUE_NOISE_SPATIOTEMPORAL_SLICES, 0);
+    }
+    catch (...)
+    {
+        Threading::Destroy(pool);
+        throw;
+    }
+
+    Threading::Destroy(pool);
+    return textures;
+}
+
+/**
+* Report how the blue noise textures were loaded, with the decode time of each slice when the PNGs were decoded.
+*/
+static void Log_Load_Stats(RenderBackend &backend, const BlueNoiseLoadStats &stats)
+{
+    char message[256];
+    if (stats.cacheHit)
+    {
+        snprintf(message, sizeof(message), "Blue noise: mapped cache in %.3f ms\n", stats.milliseconds);
+        backend.Log(message);
+        return;
+    }
+
+    snprintf(message, sizeof(message), "Blue noise: decoded %zu PNGs in %.3f ms (%.3f ms total)\n", stats.sliceMilliseconds.size(), stats.decodeMilliseconds, stats.milliseconds);
+    backend.Log(message);
+    for (size_t i = 0; i < stats.sliceMilliseconds.size(); i++)
+    {
+        snprintf(message, sizeof(message), "  slice %zu: %.3f ms\n", i, stats.sliceMilliseconds[i]);
+        backend.Log(message);
+    }
+}
+
+/**
+* Create the constants of the first frame: the light centered over a frame of this size, dithered
+* with uniform white noise and tonemapped, with the noise scale of the pixel layout.
+*/
+BandingConstants Application::Create_Constants(const PixelLayout &layout, uint32_t width, uint32_t height)
+{
+    BandingConstants constants = {};
+    constants.lightPosition = Float3((float)width / 2.f, 50.f, (float)height / 2.f);
+    constants.color = Float3(0.04f, 0.3f, 1.f);
+    constants.resolutionX = width;
+    constants.frameNumber = 1;
+    constants.useDithering = 1;
+    constants.showNoise = 0;
+    constants.noiseType = 0;
+    constants.distributionType = 0;
+    constants.useTonemapping = 1;
+    constants.ditherMatrixSize = 8;
+
+    // 8-bits provides 256 possible values (per channel), so the maximum difference between
+    // any two colors is 1/255 (again, per channel). We insert noise into each channel in the range [0, 1/255]
+    // to approximate values between the range representable by the 8-bit format, and 1/1023 with 10-bits.
+    constants.noiseScale = Quantize::Get_Noise_Scale(layout, constants.distributionType);
+    return constants;
+}
+
+/**
+* Initialize the constants and the backend, and upload the blue noise textures once they are loaded.
+*/
+void Application::Init(RenderBackend &renderBackend, const ApplicationConfig &config)
+{
+    backend = &renderBackend;
+
+    // Start loading (or generating) the blue noise textures, it overlaps with the backend initialization
+    BlueNoiseLoadStats stats;
+    future<NoiseTextures> blueNoise = async(launch::async, Load_Blue_Noise, config, &stats);
+
+    const BackendConfig &backendConfig = config.backend;
+    width = backendConfig.width;
+    height = backendConfig.height;
+
+    BandingConstants &constants = state.constants;
+    constants = Create_Constants(Backend::Get_Layout(backendConfig), width, height);
+
+    state.vsync = backendConfig.vsync;
+
+    try
+    {
+        backend->Init(backendConfig, constants);
+    }
+    catch (...)
+    {
+        // Let the loader finish before its stats go out of scope
+        blueNoise.wait();
+        throw;
+    }
+
+    // Wait for the blue noise textures
+    NoiseTextures textures = blueNoise.get();
+    if (config.blueNoiseSize == 0) Log_Load_Stats(*backend, stats);
+
+    backend->Upload_Noise_Textures(move(textures));
+}
+
+/**
+* Animate the light and send the constants of the next frame to the backend.
+*/
+void Application::Update()
+{
+    BandingConstants &constants = state.constants;
+    if (state.animateLight)
+    {
+        constants.lightPosition.x = (width / 2) + 200.f * cos(angle);
+        constants.lightPosition.y = 50.f + 30.f * sin(angle);
+        constants.lightPosition.z = (height / 2) + 200.f * sin(angle);
+
+        if (state.vsync) angle += 0.01f;
+        else angle += 0.001f;
+    }
+
+    backend->Update_Constants(constants);
+
+    constants.frameNumber++;
+}
+
+/**
+* Render and present a frame. When readback is given, the frame is copied to it before it is
+* presented, and false is returned if the backend does not support readback.
+*/
+bool Application::Render(SoftwareFrame* readback)
+{
+    backend->Render(state);
+    const bool copied = readback && backend->Readback(*readback);
+    backend->Present();
+    return copied;
+}
+
+/**
+* Release the backend.
+*/
+void Application::Cleanup()
+{
+    if (backend) backend->Destroy();
+    backend = nullptr;
+}
@@ -0,0 +1,148 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Backend.h"
+#include "Quantize.h"
+#include "Software.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------
+// Software Backend
+// Renders with the software renderer into a frame in memory. There is no window or UI,
+// so Present() only finishes the frame, and vsync is ignored.
+//--------------------------------------------------------------------------------------
+
+class SoftwareBackend : public RenderBackend
+{
+public:
+
+    SoftwareBackend(uint32_t numThreads, TransferMode transferMode) : numThreads(numThreads)
+    {
+        settings.transferMode = transferMode;
+    }
+
+    ~SoftwareBackend() override
+    {
+        Destroy();
+    }
+
+    const char* Get_Name() const override { return "Software"; }
+
+    void Init(const BackendConfig &config, const BandingConstants &initialConstants) override
+    {
+        if (config.width == 0 || config.height == 0) throw runtime_error("Error: backend resolution must not be zero!");
+
+        Threading::Create(pool, numThreads);
+        created = true;
+
+        settings.layout = Backend::Get_Layout(config);
+        Software::Create_Frame(frame, config.width, config.height, settings.layout);
+        constants = initialConstants;
+    }
+
+    void Upload_Noise_Textures(NoiseTextures noiseTextures) override
+    {
+        textures = move(noiseTextures);
+    }
+
+    void Update_Constants(const BandingConstants &newConstants) override
+    {
+        constants = newConstants;
+    }
+
+    void Render(FrameState & /*state*/) override
+    {
+        Software::Render_Frame(pool, constants, settings, textures, frame);
+        rendered = true;
+    }
+
+    bool Readback(SoftwareFrame &dest) override
+    {
+        if (!rendered) return false;
+        dest = frame;
+        return true;
+    }
+
+    void Present() override
+    {
+        rendered = false;
+    }
+
+    void Destroy() override
+    {
+        if (created) Threading::Destroy(pool);
+        created = false;
+        textures = NoiseTextures();
+        frame = SoftwareFrame();
+    }
+
+    void Log(const char* message) override
+    {
+        fputs(message, stderr);
+    }
+
+private:
+
+    ThreadPool pool;
+    uint32_t numThreads = 0;
+    bool created = false;
+    bool rendered = false;
+
+    SoftwareSettings settings;
+    SoftwareFrame frame;
+    NoiseTextures textures;
+    BandingConstants constants = {};
+};
+
+//--------------------------------------------------------------------------------------
+// Public Functions
+//--------------------------------------------------------------------------------------
+
+namespace Backend
+{
+
+/**
+* Create a backend that renders on the CPU, on a pool of numThreads threads (0 uses every hardware thread).
+*/
+unique_ptr<RenderBackend> Create_Software(uint32_t numThreads, TransferMode transferMode)
+{
+    return unique_ptr<RenderBackend>(new SoftwareBackend(numThreads, transferMode));
+}
+
+/**
+* Get the layout frames are packed with: the custom layout when one is set, otherwise the back buffer format's.
+*/
+PixelLayout Get_Layout(const BackendConfig &config)
+{
+    return config.customLayout ? config.layout : Quantize::Get_Layout(config.backBufferFormat);
+}
+
+}
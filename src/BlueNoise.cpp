@@ -0,0 +1,1001 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BlueNoise.h"
+#include "Noise.h"
+#include "Utils.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+
+using namespace std;
+
+namespace BlueNoise
+{
+
+//--------------------------------------------------------------------------------------
+// Loading
+//--------------------------------------------------------------------------------------
+
+static string Get_Slice_Path(uint32_t index)
+{
+    string filepath = "data/blue-noise/LDR_RGB1_";
+    filepath.append(to_string(index));
+    filepath.append(".png");
+    return filepath;
+}
+
+static const char* TEXTURE_PATH = "data/blue-noise/rgb-256.png";
+
+/**
+* Decode count PNGs across the pool. Each slice is timed separately, and an exception
+* thrown by any slice is rethrown on the calling thread once the others have finished.
+*/
+static vector<TextureInfo> Load_Parallel(ThreadPool &pool, uint32_t count, const function<string(uint32_t)> &getPath, vector<double>* sliceMilliseconds)
+{
+    vector<TextureInfo> textures(count);
+    vector<double> times(count, 0.0);
+    vector<exception_ptr> errors(count);
+
+    Threading::Parallel_For(pool, count, [&](uint32_t i)
+    {
+        auto start = chrono::high_resolution_clock::now();
+        try
+        {
+            textures[i] = Utils::LoadTexture(getPath(i));
+        }
+        catch (...)
+        {
+            errors[i] = current_exception();
+        }
+        chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+        times[i] = elapsed.count();
+    });
+
+    for (const exception_ptr &error : errors)
+    {
+        if (error) rethrow_exception(error);
+    }
+
+    if (sliceMilliseconds) *sliceMilliseconds = move(times);
+    return textures;
+}
+
+/**
+* Load the LDR_RGB1_*.png slices, one per frame, decoding them in parallel.
+*/
+vector<TextureInfo> Load_Texture_Array(ThreadPool &pool, uint32_t num, vector<double>* sliceMilliseconds)
+{
+    return Load_Parallel(pool, num, Get_Slice_Path, sliceMilliseconds);
+}
+
+/**
+* Load rgb-256.png, used by the LDS blue noise.
+*/
+TextureInfo Load_Texture()
+{
+    return Utils::LoadTexture(TEXTURE_PATH);
+}
+
+//--------------------------------------------------------------------------------------
+// Cache
+// The decoded textures packed into one file that is memory-mapped at startup, so the
+// PNGs are only decoded when the cache is missing or out of date. The layout is a
+// header, one entry per texture (the array slices, then rgb-256.png), and the pixels
+// of each texture at a 64 byte aligned offset. Pixels are R8G8B8A8_UNORM, tightly
+// packed, ready to be copied into an upload buffer. The spatiotemporal blue noise
+// slices are cached the same way in a file of their own, since they are generated.
+//--------------------------------------------------------------------------------------
+
+static const char* CACHE_PATH = "data/blue-noise/blue-noise.cache";
+static const char* SPATIOTEMPORAL_CACHE_PATH = "data/blue-noise/spatiotemporal.cache";
+static const uint32_t CACHE_MAGIC = 0x4E424C42;             // "BLBN"
+static const uint32_t CACHE_VERSION = 1;
+static const uint32_t CACHE_FORMAT_R8G8B8A8_UNORM = 28;     // DXGI_FORMAT_R8G8B8A8_UNORM
+static const uint64_t CACHE_ALIGNMENT = 64;
+
+struct CacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t numEntries;
+    uint64_t sourceStamp;       // hash of the source PNG names, sizes, and modification times, or of the generator settings
+    uint64_t checksum;          // hash of every byte after the header
+};
+
+struct CacheEntry
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t pad;
+    uint64_t offset;            // from the start of the file
+    uint64_t size;
+};
+
+static_assert(sizeof(CacheHeader) == 32, "CacheHeader must be packed");
+static_assert(sizeof(CacheEntry) == 32, "CacheEntry must be packed");
+
+static uint64_t Hash_Combine(uint64_t hash, uint64_t value)
+{
+    // The 64 bit finalizer from MurmurHash3
+    hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB93FE1A85B53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+* Hash a block of bytes, eight at a time. Four independent lanes keep the multiplies
+* from serializing, so checking the whole cache stays well under a millisecond per MB.
+*/
+static uint64_t Hash_Bytes(const uint8_t* data, size_t size)
+{
+    uint64_t lanes[4] = { 1, 2, 3, 4 };
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        for (uint32_t lane = 0; lane < 4; lane++)
+        {
+            uint64_t value;
+            memcpy(&value, data + i + (lane * 8), sizeof(value));
+            lanes[lane] = (lanes[lane] ^ value) * 0x9E3779B97F4A7C15ull;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+
+    uint64_t hash = Hash_Combine(Hash_Combine(lanes[0], lanes[1]), Hash_Combine(lanes[2], lanes[3]));
+    for (; i < size; i++)
+    {
+        hash = Hash_Combine(hash, data[i]);
+    }
+    return Hash_Combine(hash, size);
+}
+
+static uint64_t Hash_Source(uint64_t hash, const string &filepath)
+{
+    hash = Hash_Bytes((const uint8_t*)filepath.data(), filepath.size()) ^ hash;
+
+    struct stat info = {};
+    if (stat(filepath.c_str(), &info) != 0) return Hash_Combine(hash, UINT64_MAX);
+    hash = Hash_Combine(hash, (uint64_t)info.st_size);
+    return Hash_Combine(hash, (uint64_t)info.st_mtime);
+}
+
+/**
+* Stamp the cache with the state of the source PNGs, so editing, replacing, adding, or
+* removing any of them rebuilds it.
+*/
+static uint64_t Get_Source_Stamp(uint32_t num)
+{
+    uint64_t hash = Hash_Combine(CACHE_VERSION, num);
+    for (uint32_t i = 0; i < num; i++)
+    {
+        hash = Hash_Source(hash, Get_Slice_Path(i));
+    }
+    return Hash_Source(hash, TEXTURE_PATH);
+}
+
+static uint64_t Align(uint64_t value)
+{
+    return (value + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1);
+}
+
+/**
+* Write the textures to a cache file. Returns false if the file can't be written, which is
+* not an error: the next run decodes (or generates) the textures again.
+*/
+static bool Write_Cache(const char* path, const vector<const TextureInfo*> &sources, uint64_t sourceStamp)
+{
+    const uint32_t numEntries = (uint32_t)sources.size();
+    vector<CacheEntry> entries(numEntries);
+
+    uint64_t offset = Align(sizeof(CacheHeader) + (sizeof(CacheEntry) * numEntries));
+    for (uint32_t i = 0; i < numEntries; i++)
+    {
+        const TextureInfo &texture = *sources[i];
+        entries[i] = {};
+        entries[i].width = (uint32_t)texture.width;
+        entries[i].height = (uint32_t)texture.height;
+        entries[i].stride = (uint32_t)texture.stride;
+        entries[i].offset = offset;
+        entries[i].size = (uint64_t)texture.width * texture.height * texture.stride;
+        offset = Align(offset + entries[i].size);
+    }
+
+    vector<uint8_t> file((size_t)offset, 0);
+    memcpy(file.data() + sizeof(CacheHeader), entries.data(), sizeof(CacheEntry) * numEntries);
+    for (uint32_t i = 0; i < numEntries; i++)
+    {
+        memcpy(file.data() + entries[i].offset, sources[i]->Get_Pixels(), (size_t)entries[i].size);
+    }
+
+    CacheHeader header = {};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.format = CACHE_FORMAT_R8G8B8A8_UNORM;
+    header.numEntries = numEntries;
+    header.sourceStamp = sourceStamp;
+    header.checksum = Hash_Bytes(file.data() + sizeof(CacheHeader), file.size() - sizeof(CacheHeader));
+    memcpy(file.data(), &header, sizeof(CacheHeader));
+
+    // Write to a temporary file first, so a crash never leaves a half written cache behind
+    const string temp = string(path) + ".tmp";
+    {
+        ofstream out(temp, ios::binary | ios::trunc);
+        if (!out) return false;
+        out.write((const char*)file.data(), (streamsize)file.size());
+        if (!out) return false;
+    }
+    remove(path);
+    return rename(temp.c_str(), path) == 0;
+}
+
+/**
+* Map a cache file of numEntries textures, and point textures at its pixels. Returns null,
+* leaving textures untouched, if the cache is missing, stale, or fails validation.
+*/
+static shared_ptr<MappedFile> Map_Cache(const char* path, uint32_t numEntries, uint64_t sourceStamp, vector<TextureInfo> &textures)
+{
+    shared_ptr<MappedFile> cache(new MappedFile(), [](MappedFile* file) { Utils::UnmapFile(*file); delete file; });
+    if (!Utils::MapFile(path, *cache)) return nullptr;
+
+    const uint8_t* data = cache->data;
+    const size_t size = cache->size;
+    if (size < sizeof(CacheHeader)) return nullptr;
+
+    CacheHeader header;
+    memcpy(&header, data, sizeof(CacheHeader));
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) return nullptr;
+    if (header.format != CACHE_FORMAT_R8G8B8A8_UNORM) return nullptr;
+    if (header.numEntries != numEntries || header.sourceStamp != sourceStamp) return nullptr;
+    if (size < sizeof(CacheHeader) + (sizeof(CacheEntry) * (size_t)header.numEntries)) return nullptr;
+    if (Hash_Bytes(data + sizeof(CacheHeader), size - sizeof(CacheHeader)) != header.checksum) return nullptr;
+
+    vector<TextureInfo> mapped(header.numEntries);
+    for (uint32_t i = 0; i < header.numEntries; i++)
+    {
+        CacheEntry entry;
+        memcpy(&entry, data + sizeof(CacheHeader) + (sizeof(CacheEntry) * i), sizeof(CacheEntry));
+        if (entry.stride != 4 || entry.size != (uint64_t)entry.width * entry.height * entry.stride) return nullptr;
+        if ((entry.offset % CACHE_ALIGNMENT) != 0 || entry.offset > size || entry.size > size - entry.offset) return nullptr;
+
+        mapped[i].mappedPixels = data + entry.offset;
+        mapped[i].width = (int)entry.width;
+        mapped[i].height = (int)entry.height;
+        mapped[i].stride = (int)entry.stride;
+    }
+
+    textures = move(mapped);
+    return cache;
+}
+
+/**
+* Decode the PNGs in parallel, with no cache involved. rgb-256.png is decoded alongside
+* the array slices, and its time is the last entry of stats->sliceMilliseconds.
+* Only the timing fields of stats are written.
+*/
+void Load_Textures_From_PNG(ThreadPool &pool, NoiseTextures &textures, uint32_t num, BlueNoiseLoadStats* stats)
+{
+    auto start = chrono::high_resolution_clock::now();
+
+    vector<double> sliceMilliseconds;
+    vector<TextureInfo> loaded = Load_Parallel(pool, num + 1, [num](uint32_t i) { return (i < num) ? Get_Slice_Path(i) : string(TEXTURE_PATH); }, &sliceMilliseconds);
+
+    textures.blueNoise = move(loaded.back());
+    loaded.pop_back();
+    textures.blueNoiseArray = move(loaded);
+    textures.cache.reset();
+
+    if (stats)
+    {
+        chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+        stats->milliseconds = elapsed.count();
+        stats->decodeMilliseconds = elapsed.count();
+        stats->sliceMilliseconds = move(sliceMilliseconds);
+    }
+}
+
+/**
+* Load the blue noise textures from the cache when it is up to date, otherwise decode
+* the PNGs and rebuild it. Mapped textures reference textures.cache, which must outlive
+* any copies of them.
+*/
+void Load_Textures(ThreadPool &pool, NoiseTextures &textures, uint32_t num, BlueNoiseLoadStats* stats)
+{
+    auto start = chrono::high_resolution_clock::now();
+
+    BlueNoiseLoadStats result = {};
+    const uint64_t sourceStamp = Get_Source_Stamp(num);
+    vector<TextureInfo> mapped;
+    shared_ptr<MappedFile> cache = Map_Cache(CACHE_PATH, num + 1, sourceStamp, mapped);
+    result.cacheHit = (cache != nullptr);
+    if (result.cacheHit)
+    {
+        textures.blueNoise = mapped.back();
+        mapped.pop_back();
+        textures.blueNoiseArray = move(mapped);
+        textures.cache = cache;
+    }
+    else
+    {
+        Load_Textures_From_PNG(pool, textures, num, &result);
+
+        vector<const TextureInfo*> sources;
+        for (const TextureInfo &texture : textures.blueNoiseArray) sources.push_back(&texture);
+        sources.push_back(&textures.blueNoise);
+        result.cacheWritten = Write_Cache(CACHE_PATH, sources, sourceStamp);
+    }
+
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    result.milliseconds = elapsed.count();
+    if (stats) *stats = move(result);
+}
+
+//--------------------------------------------------------------------------------------
+// Void and Cluster
+//--------------------------------------------------------------------------------------
+
+static const float SIGMA = 1.5f;
+static const int RADIUS = 6;                    // the Gaussian is below 0.0004 past 4 sigma
+static const uint32_t INVALID = UINT32_MAX;
+
+/**
+* A binary pattern and its energy: each set pixel adds a Gaussian centered on itself,
+* with toroidal wrap. The Gaussian is separable, so it is stored as 1D weights.
+*
+* The energy is kept in two fields, one holding set pixels (empty pixels are -Inf) and
+* one holding empty pixels (set pixels are +Inf), so finding the tightest cluster (the set
+* pixel with the most energy) or largest void (the empty pixel with the least) does not
+* branch on the pattern. Pixels are grouped into square tiles that cache both candidates,
+* so each search only scans the tiles rather than every pixel.
+*/
+struct VoidAndCluster
+{
+    uint32_t size = 0;
+    uint32_t mask = 0;
+    uint32_t shift = 0;
+    uint32_t tileSize = 0;
+    uint32_t tileShift = 0;
+    uint32_t tilesPerSide = 0;
+    bool trackBoth = true;
+
+    float weights[(RADIUS * 2) + 1];
+
+    vector<uint8_t> pattern;
+    vector<float> clusterField;
+    vector<float> voidField;
+
+    vector<uint32_t> clusters;
+    vector<uint32_t> voids;
+    vector<float> clusterEnergies;
+    vector<float> voidEnergies;
+};
+
+static void Validate_Size(uint32_t size)
+{
+    if (size < BLUE_NOISE_MIN_SIZE || size > BLUE_NOISE_MAX_SIZE || (size & (size - 1)) != 0)
+    {
+        throw runtime_error("Error: blue noise size must be a power of two between 4 and 4096!");
+    }
+}
+
+static uint32_t Log2(uint32_t value)
+{
+    uint32_t result = 0;
+    while ((1u << result) < value) result++;
+    return result;
+}
+
+/**
+* Find the extreme value of a field within one tile. Ties go to the lowest index.
+*/
+template <bool Max>
+static void Search_Tile(const VoidAndCluster &vc, const vector<float> &field, uint32_t tileX, uint32_t tileY, uint32_t &result, float &energy)
+{
+    result = INVALID;
+    energy = Max ? -INFINITY : INFINITY;
+
+    const uint32_t x0 = (tileX << vc.tileShift);
+    const uint32_t y0 = (tileY << vc.tileShift);
+    for (uint32_t y = y0; y < (y0 + vc.tileSize); y++)
+    {
+        const float* row = &field[y << vc.shift];
+        for (uint32_t x = x0; x < (x0 + vc.tileSize); x++)
+        {
+            if (Max ? (row[x] > energy) : (row[x] < energy))
+            {
+                energy = row[x];
+                result = (y << vc.shift) + x;
+            }
+        }
+    }
+}
+
+static void Update_Tile(VoidAndCluster &vc, uint32_t tileX, uint32_t tileY, bool clusters, bool voids)
+{
+    const uint32_t tile = (tileY * vc.tilesPerSide) + tileX;
+    if (clusters) Search_Tile<true>(vc, vc.clusterField, tileX, tileY, vc.clusters[tile], vc.clusterEnergies[tile]);
+    if (voids) Search_Tile<false>(vc, vc.voidField, tileX, tileY, vc.voids[tile], vc.voidEnergies[tile]);
+}
+
+static void Update_Tiles(VoidAndCluster &vc)
+{
+    for (uint32_t tileY = 0; tileY < vc.tilesPerSide; tileY++)
+    {
+        for (uint32_t tileX = 0; tileX < vc.tilesPerSide; tileX++) Update_Tile(vc, tileX, tileY, true, true);
+    }
+}
+
+/**
+* Get the tiles touched by the RADIUS neighborhood of a coordinate, without duplicates.
+*/
+static uint32_t Get_Tile_Range(const VoidAndCluster &vc, uint32_t center, uint32_t tiles[4])
+{
+    uint32_t count = 0;
+    for (int d = -RADIUS; d <= RADIUS; d++)
+    {
+        const uint32_t tile = (((center + d) & vc.mask) >> vc.tileShift);
+        bool found = false;
+        for (uint32_t i = 0; i < count; i++) found |= (tiles[i] == tile);
+        if (!found) tiles[count++] = tile;
+    }
+    return count;
+}
+
+static bool Is_Near(const VoidAndCluster &vc, uint32_t index, uint32_t x, uint32_t y)
+{
+    if (index == INVALID) return false;
+    if (vc.size <= (RADIUS * 2 + 1)) return true;
+
+    const uint32_t dx = (((index & vc.mask) - x + RADIUS) & vc.mask);
+    const uint32_t dy = (((index >> vc.shift) - y + RADIUS) & vc.mask);
+    return (dx <= (RADIUS * 2)) && (dy <= (RADIUS * 2));
+}
+
+/**
+* Set or clear one pixel, update the energy around it, then the affected tiles.
+* Unless trackBoth is set, only the tile candidates for the current phase are kept valid:
+* largest voids while setting pixels, tightest clusters while clearing them.
+*/
+static void Toggle(VoidAndCluster &vc, uint32_t index)
+{
+    // Move the pixel's energy to the other field, the infinities absorb the updates below
+    const bool set = (vc.pattern[index] == 0);
+    vc.pattern[index] = set ? 1 : 0;
+    if (set)
+    {
+        vc.clusterField[index] = vc.voidField[index];
+        vc.voidField[index] = INFINITY;
+    }
+    else
+    {
+        vc.voidField[index] = vc.clusterField[index];
+        vc.clusterField[index] = -INFINITY;
+    }
+
+    const float sign = set ? 1.f : -1.f;
+    const uint32_t x = (index & vc.mask);
+    const uint32_t y = (index >> vc.shift);
+    for (int dy = -RADIUS; dy <= RADIUS; dy++)
+    {
+        const float wy = sign * vc.weights[dy + RADIUS];
+        const uint32_t row = (((y + dy) & vc.mask) << vc.shift);
+        for (int dx = -RADIUS; dx <= RADIUS; dx++)
+        {
+            const uint32_t i = row + ((x + dx) & vc.mask);
+            const float w = wy * vc.weights[dx + RADIUS];
+            vc.clusterField[i] += w;
+            vc.voidField[i] += w;
+        }
+    }
+
+    uint32_t tilesX[4];
+    uint32_t tilesY[4];
+    const uint32_t countX = Get_Tile_Range(vc, x, tilesX);
+    const uint32_t countY = Get_Tile_Range(vc, y, tilesY);
+    for (uint32_t j = 0; j < countY; j++)
+    {
+        for (uint32_t i = 0; i < countX; i++)
+        {
+            if (vc.trackBoth)
+            {
+                Update_Tile(vc, tilesX[i], tilesY[j], true, true);
+                continue;
+            }
+
+            // Setting a pixel only raises energy, so a tile's largest void can only change if it
+            // is in the neighborhood. Likewise for the tightest cluster when clearing a pixel.
+            const uint32_t tile = (tilesY[j] * vc.tilesPerSide) + tilesX[i];
+            const uint32_t candidate = set ? vc.voids[tile] : vc.clusters[tile];
+            if (Is_Near(vc, candidate, x, y)) Update_Tile(vc, tilesX[i], tilesY[j], !set, set);
+        }
+    }
+}
+
+/**
+* Compute the energy of the whole pattern with a separable blur, rows then columns.
+*/
+static void Compute_Energy(VoidAndCluster &vc)
+{
+    vector<float> rows(vc.pattern.size());
+    for (uint32_t y = 0; y < vc.size; y++)
+    {
+        const uint32_t row = (y << vc.shift);
+        for (uint32_t x = 0; x < vc.size; x++)
+        {
+            float sum = 0.f;
+            for (int d = -RADIUS; d <= RADIUS; d++) sum += vc.weights[d + RADIUS] * vc.pattern[row + ((x + d) & vc.mask)];
+            rows[row + x] = sum;
+        }
+    }
+
+    for (uint32_t y = 0; y < vc.size; y++)
+    {
+        for (uint32_t x = 0; x < vc.size; x++)
+        {
+            float sum = 0.f;
+            for (int d = -RADIUS; d <= RADIUS; d++) sum += vc.weights[d + RADIUS] * rows[(((y + d) & vc.mask) << vc.shift) + x];
+
+            const uint32_t index = (y << vc.shift) + x;
+            vc.clusterField[index] = vc.pattern[index] ? sum : -INFINITY;
+            vc.voidField[index] = vc.pattern[index] ? INFINITY : sum;
+        }
+    }
+}
+
+/**
+* The cached energies stay valid between updates, since a candidate outside the
+* neighborhood of a toggled pixel keeps its energy.
+*/
+static uint32_t Find_Tightest_Cluster(const VoidAndCluster &vc)
+{
+    uint32_t result = 0;
+    for (uint32_t tile = 1; tile < vc.clusterEnergies.size(); tile++)
+    {
+        if (vc.clusterEnergies[tile] > vc.clusterEnergies[result]) result = tile;
+    }
+    return vc.clusters[result];
+}
+
+static uint32_t Find_Largest_Void(const VoidAndCluster &vc)
+{
+    uint32_t result = 0;
+    for (uint32_t tile = 1; tile < vc.voidEnergies.size(); tile++)
+    {
+        if (vc.voidEnergies[tile] < vc.voidEnergies[result]) result = tile;
+    }
+    return vc.voids[result];
+}
+
+static void Init_Void_And_Cluster(VoidAndCluster &vc, uint32_t size)
+{
+    vc.size = size;
+    vc.mask = (size - 1);
+    vc.shift = Log2(size);
+
+    // Balance the cost of updating the tiles around a pixel against scanning every tile
+    vc.tileSize = 1;
+    while ((vc.tileSize * vc.tileSize * 2) < size) vc.tileSize *= 2;
+    vc.tileShift = Log2(vc.tileSize);
+    vc.tilesPerSide = (size >> vc.tileShift);
+
+    for (int d = -RADIUS; d <= RADIUS; d++)
+    {
+        vc.weights[d + RADIUS] = expf(-(float)(d * d) / (2.f * SIGMA * SIGMA));
+    }
+
+    const uint32_t numPixels = (size * size);
+    const uint32_t numTiles = (vc.tilesPerSide * vc.tilesPerSide);
+    vc.pattern.resize(numPixels, 0);
+    vc.clusterField.resize(numPixels);
+    vc.voidField.resize(numPixels);
+    vc.clusters.resize(numTiles);
+    vc.voids.resize(numTiles);
+    vc.clusterEnergies.resize(numTiles);
+    vc.voidEnergies.resize(numTiles);
+}
+
+/**
+* Seed a random pattern with 10% of the pixels set, returns the number of pixels set.
+*/
+static uint32_t Seed_Pattern(VoidAndCluster &vc, uint32_t seed)
+{
+    const uint32_t numPixels = (uint32_t)vc.pattern.size();
+    const uint32_t numInitial = max(numPixels / 10, 1u);
+    uint32_t state = Noise::WangHash(seed);
+    for (uint32_t count = 0; count < numInitial;)
+    {
+        state = Noise::Xorshift(state);
+        const uint32_t index = (state & (numPixels - 1));
+        if (vc.pattern[index]) continue;
+        vc.pattern[index] = 1;
+        count++;
+    }
+    return numInitial;
+}
+
+/**
+* Generate one size x size blue noise mask and write it to every destStride'th byte of dest.
+*/
+void Generate_Mask(uint32_t size, uint32_t seed, uint8_t* dest, uint32_t destStride)
+{
+    Validate_Size(size);
+
+    VoidAndCluster vc;
+    Init_Void_And_Cluster(vc, size);
+
+    const uint32_t numPixels = (size * size);
+    const uint32_t numInitial = Seed_Pattern(vc, seed);
+
+    Compute_Energy(vc);
+    Update_Tiles(vc);
+
+    // Move the tightest cluster into the largest void until the pattern stops changing
+    for (uint32_t i = 0; i < numPixels; i++)
+    {
+        const uint32_t cluster = Find_Tightest_Cluster(vc);
+        Toggle(vc, cluster);
+
+        const uint32_t largestVoid = Find_Largest_Void(vc);
+        Toggle(vc, largestVoid);
+        if (largestVoid == cluster) break;
+    }
+
+    const vector<uint8_t> initialPattern = vc.pattern;
+    const vector<float> initialClusterField = vc.clusterField;
+    const vector<float> initialVoidField = vc.voidField;
+    vector<uint32_t> ranks(numPixels);
+
+    // Phase 1: rank the initial pixels by removing the tightest cluster
+    vc.trackBoth = false;
+    for (uint32_t rank = numInitial; rank-- > 0;)
+    {
+        const uint32_t cluster = Find_Tightest_Cluster(vc);
+        Toggle(vc, cluster);
+        ranks[cluster] = rank;
+    }
+
+    // Phases 2 and 3: rank the remaining pixels by filling the largest void. With a linear
+    // energy, the tightest cluster of empty pixels is the largest void, so one loop does both.
+    vc.pattern = initialPattern;
+    vc.clusterField = initialClusterField;
+    vc.voidField = initialVoidField;
+    Update_Tiles(vc);
+    for (uint32_t rank = numInitial; rank < numPixels; rank++)
+    {
+        const uint32_t largestVoid = Find_Largest_Void(vc);
+        Toggle(vc, largestVoid);
+        ranks[largestVoid] = rank;
+    }
+
+    for (uint32_t i = 0; i < numPixels; i++)
+    {
+        dest[(size_t)i * destStride] = (uint8_t)(((uint64_t)ranks[i] * 256) / numPixels);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Spatiotemporal Void and Cluster
+// Ranks a stack of masks jointly over x, y, and t (Wolfe et al. 2022). Each slice keeps
+// its own spatial energy, and a set pixel also adds a Gaussian over time (wrapping around
+// the stack) to the same pixel in nearby slices. Ranking runs in lock-step, one pixel per
+// slice per rank, so every slice is a complete blue noise mask, and every pixel's values
+// over time are blue as well.
+//--------------------------------------------------------------------------------------
+
+struct SpatiotemporalVolume
+{
+    vector<VoidAndCluster> slices;
+    int temporalRadius = 0;
+};
+
+/**
+* Add energy to a single pixel and keep the tile candidates valid, see Toggle().
+*/
+static void Add_Energy(VoidAndCluster &vc, uint32_t index, float energy)
+{
+    vc.clusterField[index] += energy;
+    vc.voidField[index] += energy;
+
+    const uint32_t tileX = ((index & vc.mask) >> vc.tileShift);
+    const uint32_t tileY = ((index >> vc.shift) >> vc.tileShift);
+    if (vc.trackBoth)
+    {
+        Update_Tile(vc, tileX, tileY, true, true);
+        return;
+    }
+
+    // Only a candidate moving away from the extreme can change a tile's result
+    const uint32_t tile = (tileY * vc.tilesPerSide) + tileX;
+    const bool raised = (energy > 0.f);
+    const uint32_t candidate = raised ? vc.voids[tile] : vc.clusters[tile];
+    if (candidate == index) Update_Tile(vc, tileX, tileY, !raised, raised);
+}
+
+static void Toggle(SpatiotemporalVolume &volume, uint32_t slice, uint32_t index)
+{
+    VoidAndCluster &vc = volume.slices[slice];
+    const float sign = vc.pattern[index] ? -1.f : 1.f;
+    Toggle(vc, index);
+
+    const uint32_t numSlices = (uint32_t)volume.slices.size();
+    for (int d = 1; d <= volume.temporalRadius; d++)
+    {
+        const float energy = sign * vc.weights[d + RADIUS];
+        Add_Energy(volume.slices[(slice + d) % numSlices], index, energy);
+        Add_Energy(volume.slices[(slice + numSlices - d) % numSlices], index, energy);
+    }
+}
+
+/**
+* Compute the spatial energy of every slice, then add the temporal energy.
+*/
+static void Compute_Energy(SpatiotemporalVolume &volume)
+{
+    const uint32_t numSlices = (uint32_t)volume.slices.size();
+    for (VoidAndCluster &vc : volume.slices) Compute_Energy(vc);
+
+    for (uint32_t t = 0; t < numSlices; t++)
+    {
+        VoidAndCluster &vc = volume.slices[t];
+        for (int d = -volume.temporalRadius; d <= volume.temporalRadius; d++)
+        {
+            if (d == 0) continue;
+            const vector<uint8_t> &pattern = volume.slices[(t + numSlices + d) % numSlices].pattern;
+            const float weight = vc.weights[d + RADIUS];
+            for (uint32_t i = 0; i < (uint32_t)pattern.size(); i++)
+            {
+                if (!pattern[i]) continue;
+                vc.clusterField[i] += weight;
+                vc.voidField[i] += weight;
+            }
+        }
+    }
+
+    for (VoidAndCluster &vc : volume.slices) Update_Tiles(vc);
+}
+
+static void Set_Track_Both(SpatiotemporalVolume &volume, bool trackBoth)
+{
+    for (VoidAndCluster &vc : volume.slices) vc.trackBoth = trackBoth;
+}
+
+/**
+* Generate numSlices size x size masks ranked jointly over space and time. Slice t is
+* written to every destStride'th byte of dest[t].
+*/
+void Generate_Spatiotemporal_Mask(uint32_t size, uint32_t numSlices, uint32_t seed, uint8_t* const* dest, uint32_t destStride)
+{
+    Validate_Size(size);
+
+    SpatiotemporalVolume volume;
+    volume.slices.resize(numSlices);
+    volume.temporalRadius = min(RADIUS, (int)(numSlices - 1) / 2);      // keep both sides of the wrap distinct
+
+    const uint32_t numPixels = (size * size);
+    uint32_t numInitial = 0;
+    for (uint32_t t = 0; t < numSlices; t++)
+    {
+        Init_Void_And_Cluster(volume.slices[t], size);
+        numInitial = Seed_Pattern(volume.slices[t], Noise::WangHash(seed ^ Noise::WangHash(t + 1)));
+    }
+
+    Compute_Energy(volume);
+
+    // Move the tightest cluster into the largest void, slice by slice, until no slice changes
+    for (uint32_t i = 0; i < numPixels; i++)
+    {
+        bool changed = false;
+        for (uint32_t t = 0; t < numSlices; t++)
+        {
+            const uint32_t cluster = Find_Tightest_Cluster(volume.slices[t]);
+            Toggle(volume, t, cluster);
+
+            const uint32_t largestVoid = Find_Largest_Void(volume.slices[t]);
+            Toggle(volume, t, largestVoid);
+            changed |= (largestVoid != cluster);
+        }
+        if (!changed) break;
+    }
+
+    const SpatiotemporalVolume initial = volume;
+    vector<vector<uint32_t>> ranks(numSlices, vector<uint32_t>(numPixels));
+
+    // Phase 1: rank the initial pixels by removing the tightest cluster. The first slice
+    // rotates with the rank, so no slice always goes first.
+    Set_Track_Both(volume, false);
+    for (uint32_t rank = numInitial; rank-- > 0;)
+    {
+        for (uint32_t i = 0; i < numSlices; i++)
+        {
+            const uint32_t t = (rank + i) % numSlices;
+            const uint32_t cluster = Find_Tightest_Cluster(volume.slices[t]);
+            Toggle(volume, t, cluster);
+            ranks[t][cluster] = rank;
+        }
+    }
+
+    // Phases 2 and 3: rank the remaining pixels by filling the largest void
+    volume = initial;
+    for (VoidAndCluster &vc : volume.slices) Update_Tiles(vc);
+    Set_Track_Both(volume, false);
+    for (uint32_t rank = numInitial; rank < numPixels; rank++)
+    {
+        for (uint32_t i = 0; i < numSlices; i++)
+        {
+            const uint32_t t = (rank + i) % numSlices;
+            const uint32_t largestVoid = Find_Largest_Void(volume.slices[t]);
+            Toggle(volume, t, largestVoid);
+            ranks[t][largestVoid] = rank;
+        }
+    }
+
+    for (uint32_t t = 0; t < numSlices; t++)
+    {
+        for (uint32_t i = 0; i < numPixels; i++)
+        {
+            dest[t][(size_t)i * destStride] = (uint8_t)(((uint64_t)ranks[t][i] * 256) / numPixels);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------------
+
+static TextureInfo Create_Texture(uint32_t size)
+{
+    TextureInfo texture = {};
+    texture.width = (int)size;
+    texture.height = (int)size;
+    texture.stride = 4;
+    texture.pixels.resize((size_t)size * size * 4, 0xFF);
+    return texture;
+}
+
+/**
+* Each slice and channel gets its own seed, so results do not depend on the thread count.
+*/
+static uint32_t Get_Mask_Seed(uint32_t seed, uint32_t slice, uint32_t channel)
+{
+    return Noise::WangHash(seed ^ Noise::WangHash((slice * 3) + channel + 1));
+}
+
+TextureInfo Generate_Texture(ThreadPool &pool, uint32_t size, uint32_t seed)
+{
+    vector<TextureInfo> textures = Generate_Texture_Array(pool, size, 1, seed);
+    return textures[0];
+}
+
+/**
+* Generate slices of RGB blue noise, distributing every channel of every slice across the thread pool.
+*/
+vector<TextureInfo> Generate_Texture_Array(ThreadPool &pool, uint32_t size, uint32_t slices, uint32_t seed)
+{
+    // Parallel_For() does not propagate exceptions, so check the size first
+    Validate_Size(size);
+
+    vector<TextureInfo> textures;
+    for (uint32_t i = 0; i < slices; i++) textures.push_back(Create_Texture(size));
+
+    Threading::Parallel_For(pool, slices * 3, [&](uint32_t job)
+    {
+        const uint32_t slice = (job / 3);
+        const uint32_t channel = (job % 3);
+        Generate_Mask(size, Get_Mask_Seed(seed, slice, channel), &textures[slice].pixels[channel], 4);
+    });
+
+    return textures;
+}
+
+/**
+* Generate slices of RGB spatiotemporal blue noise. The slices of each channel are ranked
+* together, so the three channels are the parallel jobs.
+*/
+vector<TextureInfo> Generate_Spatiotemporal_Texture_Array(ThreadPool &pool, uint32_t size, uint32_t slices, uint32_t seed)
+{
+    // Parallel_For() does not propagate exceptions, so check the size first
+    Validate_Size(size);
+    if (slices == 0) throw runtime_error("Error: spatiotemporal blue noise needs at least one slice!");
+
+    vector<TextureInfo> textures;
+    for (uint32_t i = 0; i < slices; i++) textures.push_back(Create_Texture(size));
+
+    Threading::Parallel_For(pool, 3, [&](uint32_t channel)
+    {
+        vector<uint8_t*> dest(slices);
+        for (uint32_t t = 0; t < slices; t++) dest[t] = &textures[t].pixels[channel];
+        Generate_Spatiotemporal_Mask(size, slices, Get_Mask_Seed(seed, UINT32_MAX, channel), dest.data(), 4);
+    });
+
+    return textures;
+}
+
+/**
+* Generate replacements for the pre-baked textures: an array of slices for the blue noise,
+* and a single texture (of the same size) for the LDS blue noise.
+*/
+void Generate_Textures(ThreadPool &pool, NoiseTextures &textures, uint32_t size, uint32_t slices, uint32_t seed)
+{
+    textures.blueNoiseArray = Generate_Texture_Array(pool, size, slices + 1, seed);
+    textures.blueNoise = textures.blueNoiseArray.back();
+    textures.cache.reset();
+    textures.blueNoiseArray.pop_back();
+}
+
+/**
+* Generate the spatiotemporal blue noise, one slice per frame.
+*/
+void Generate_Spatiotemporal_Textures(ThreadPool &pool, NoiseTextures &textures, uint32_t size, uint32_t slices, uint32_t seed)
+{
+    textures.spatiotemporalArray = Generate_Spatiotemporal_Texture_Array(pool, size, slices, seed);
+    textures.spatiotemporalCache.reset();
+}
+
+/**
+* Map the spatiotemporal blue noise from its cache, or generate it and write the cache when the
+* cache is missing or was generated with other settings. Returns true on a cache hit. Mapped
+* textures reference textures.spatiotemporalCache, which must outlive any copies of them.
+*/
+bool Load_Spatiotemporal_Textures(ThreadPool &pool, NoiseTextures &textures, uint32_t size, uint32_t slices, uint32_t seed)
+{
+    // Bump CACHE_VERSION when the generator changes, so stale caches are rebuilt
+    const uint64_t stamp = Hash_Combine(Hash_Combine(Hash_Combine(CACHE_VERSION, size), slices), seed);
+
+    vector<TextureInfo> mapped;
+    shared_ptr<MappedFile> cache = Map_Cache(SPATIOTEMPORAL_CACHE_PATH, slices, stamp, mapped);
+    if (cache)
+    {
+        textures.spatiotemporalArray = move(mapped);
+        textures.spatiotemporalCache = cache;
+        return true;
+    }
+
+    Generate_Spatiotemporal_Textures(pool, textures, size, slices, seed);
+
+    vector<const TextureInfo*> sources;
+    for (const TextureInfo &texture : textures.spatiotemporalArray) sources.push_back(&texture);
+    Write_Cache(SPATIOTEMPORAL_CACHE_PATH, sources, stamp);
+    return false;
+}
+
+}
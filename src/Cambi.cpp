@@ -0,0 +1,688 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Cambi.h"
+#include "Quantize.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Cambi
+{
+
+static const uint32_t TILE_WIDTH = 128;
+static const uint32_t TILE_HEIGHT = 256;
+static const uint32_t ROW_BAND_SIZE = 16;
+static const uint32_t NUM_DIFFS = 3;            // steps of 1 to 3 codes
+static const uint32_t EXTRA_BITS = 2;           // kept below the frame's codes, so the means of coarser scales are not requantized
+static const uint32_t PAD_CODES = (NUM_DIFFS << EXTRA_BITS);
+static const uint32_t POOL_BINS = 1024;
+static const float MAX_C_VALUE = 0.75f;         // NUM_DIFFS * (0.5 * 0.5) / (0.5 + 0.5)
+static const float BLACK_LEVEL = 0.001f;
+static const float HEATMAP_WHITE = 0.25f;       // one visible step between two equal flat areas
+
+static const float LUMA_R = 0.2126f;
+static const float LUMA_G = 0.7152f;
+static const float LUMA_B = 0.0722f;
+
+/**
+* Luma of one scale, in codes with EXTRA_BITS of fraction, and which pixels are in flat areas.
+*/
+struct Plane
+{
+    vector<uint16_t> codes;
+    vector<uint8_t> mask;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+/**
+* Counts and sums of the c-values of one tile, binned for pooling.
+*/
+struct TileBins
+{
+    vector<uint32_t> counts;
+    vector<double> sums;
+};
+
+//--------------------------------------------------------------------------------------
+// Row Kernels
+// Convert a row to luma codes, find the zero derivatives of a row, and sum rows of counts
+// for the spatial mask.
+//--------------------------------------------------------------------------------------
+
+static void Luma_Codes_Row_Scalar(const float* r, const float* g, const float* b, uint32_t start, uint32_t count, float maxCode, uint16_t* codes)
+{
+    for (uint32_t i = start; i < count; i++)
+    {
+        const float luma = (LUMA_R * r[i]) + (LUMA_G * g[i]) + (LUMA_B * b[i]);
+        codes[i] = (uint16_t)(min(luma, 1.f) * maxCode + 0.5f);
+    }
+}
+
+static void Zero_Derivatives_Row_Scalar(const uint16_t* codes, const uint16_t* below, uint32_t start, uint32_t count, uint8_t* zero)
+{
+    for (uint32_t i = start; i < count; i++)
+    {
+        const uint16_t right = ((i + 1) < count) ? codes[i + 1] : codes[i];
+        zero[i] = (codes[i] == right && codes[i] == below[i]) ? 1 : 0;
+    }
+}
+
+static void Sum_Rows_Scalar(const uint8_t* const* rows, uint32_t numRows, uint32_t start, uint32_t count, uint8_t* sums)
+{
+    for (uint32_t i = start; i < count; i++)
+    {
+        uint32_t sum = 0;
+        for (uint32_t row = 0; row < numRows; row++) sum += rows[row][i];
+        sums[i] = (uint8_t)sum;
+    }
+}
+
+static void Threshold_Row_Scalar(const uint8_t* sums, uint32_t start, uint32_t count, uint8_t threshold, uint8_t* mask)
+{
+    for (uint32_t i = start; i < count; i++) mask[i] = (sums[i] > threshold) ? 1 : 0;
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_AVX2 static void Luma_Codes_Row_AVX2(const float* r, const float* g, const float* b, uint32_t count, float maxCode, uint16_t* codes)
+{
+    const __m256 vMaxCode = _mm256_set1_ps(maxCode);
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
+    {
+        const __m256 luma = _mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(_mm256_set1_ps(LUMA_R), _mm256_loadu_ps(r + i)),
+            _mm256_mul_ps(_mm256_set1_ps(LUMA_G), _mm256_loadu_ps(g + i))),
+            _mm256_mul_ps(_mm256_set1_ps(LUMA_B), _mm256_loadu_ps(b + i)));
+        const __m256 code = _mm256_add_ps(_mm256_mul_ps(_mm256_min_ps(luma, _mm256_set1_ps(1.f)), vMaxCode), _mm256_set1_ps(0.5f));
+        const __m256i value = _mm256_cvttps_epi32(code);
+        const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+        _mm_storeu_si128((__m128i*)(codes + i), packed);
+    }
+    Luma_Codes_Row_Scalar(r, g, b, i, count, maxCode, codes);
+}
+
+SIMD_TARGET_AVX2 static void Zero_Derivatives_Row_AVX2(const uint16_t* codes, const uint16_t* below, uint32_t count, uint8_t* zero)
+{
+    const __m256i vOne = _mm256_set1_epi16(1);
+    uint32_t i = 0;
+    for (; (i + 17) <= count; i += 16)
+    {
+        const __m256i value = _mm256_loadu_si256((const __m256i*)(codes + i));
+        const __m256i right = _mm256_loadu_si256((const __m256i*)(codes + i + 1));
+        const __m256i down = _mm256_loadu_si256((const __m256i*)(below + i));
+        const __m256i flat = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi16(value, right), _mm256_cmpeq_epi16(value, down)), vOne);
+        const __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(flat), _mm256_extracti128_si256(flat, 1));
+        _mm_storeu_si128((__m128i*)(zero + i), packed);
+    }
+    Zero_Derivatives_Row_Scalar(codes, below, i, count, zero);
+}
+
+SIMD_TARGET_AVX2 static void Sum_Rows_AVX2(const uint8_t* const* rows, uint32_t numRows, uint32_t count, uint8_t* sums)
+{
+    uint32_t i = 0;
+    for (; (i + 32) <= count; i += 32)
+    {
+        __m256i sum = _mm256_setzero_si256();
+        for (uint32_t row = 0; row < numRows; row++) sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(rows[row] + i)));
+        _mm256_storeu_si256((__m256i*)(sums + i), sum);
+    }
+    Sum_Rows_Scalar(rows, numRows, i, count, sums);
+}
+
+SIMD_TARGET_AVX2 static void Threshold_Row_AVX2(const uint8_t* sums, uint32_t count, uint8_t threshold, uint8_t* mask)
+{
+    const __m256i vThreshold = _mm256_set1_epi8((char)threshold);
+    const __m256i vOne = _mm256_set1_epi8(1);
+    uint32_t i = 0;
+    for (; (i + 32) <= count; i += 32)
+    {
+        // The sums are at most CAMBI_MASK_SIZE^2, so a signed compare works
+        const __m256i above = _mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)(sums + i)), vThreshold);
+        _mm256_storeu_si256((__m256i*)(mask + i), _mm256_and_si256(above, vOne));
+    }
+    Threshold_Row_Scalar(sums, i, count, threshold, mask);
+}
+
+#endif
+
+//--------------------------------------------------------------------------------------
+// Histogram Kernels
+// Add (or subtract) a run of pixels with the same code, from first to last, to the window
+// counts of columns start to end: each column gets the number of the run's pixels within
+// radius of it. Flat areas are long runs, so this is much less work than adding each pixel.
+//--------------------------------------------------------------------------------------
+
+static void Add_Run_Scalar(uint16_t* counts, int start, int end, int first, int last, int radius, bool subtract)
+{
+    for (int j = start; j <= end; j++)
+    {
+        const int pixels = min(j + radius, last) - max(j - radius, first) + 1;
+        counts[j] = (uint16_t)(subtract ? (counts[j] - pixels) : (counts[j] + pixels));
+    }
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_AVX2 static void Add_Run_AVX2(uint16_t* counts, int start, int end, int first, int last, int radius, bool subtract)
+{
+    const __m256i vFirst = _mm256_set1_epi16((short)first);
+    const __m256i vLast = _mm256_set1_epi16((short)last);
+    const __m256i vRadius = _mm256_set1_epi16((short)radius);
+    const __m256i vOne = _mm256_set1_epi16(1);
+    __m256i j = _mm256_add_epi16(_mm256_set1_epi16((short)start), _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+    int i = start;
+    for (; (i + 16) <= (end + 1); i += 16)
+    {
+        const __m256i upper = _mm256_min_epi16(_mm256_add_epi16(j, vRadius), vLast);
+        const __m256i lower = _mm256_max_epi16(_mm256_sub_epi16(j, vRadius), vFirst);
+        const __m256i pixels = _mm256_add_epi16(_mm256_sub_epi16(upper, lower), vOne);
+
+        __m256i* p = (__m256i*)(counts + i);
+        const __m256i value = _mm256_loadu_si256(p);
+        _mm256_storeu_si256(p, subtract ? _mm256_sub_epi16(value, pixels) : _mm256_add_epi16(value, pixels));
+        j = _mm256_add_epi16(j, _mm256_set1_epi16(16));
+    }
+    Add_Run_Scalar(counts, i, end, first, last, radius, subtract);
+}
+
+#endif
+
+//--------------------------------------------------------------------------------------
+// Plane Functions
+//--------------------------------------------------------------------------------------
+
+/**
+* Convert a packed frame to luma codes with the given number of bits, plus EXTRA_BITS of fraction.
+*/
+static void To_Codes(ThreadPool &pool, SimdLevel level, const SoftwareFrame &frame, const PixelLayout &layout, uint32_t bits, Plane &plane)
+{
+    plane.width = frame.width;
+    plane.height = frame.height;
+    plane.codes.resize((size_t)frame.width * frame.height);
+
+    const float maxCode = (float)(((1u << bits) - 1) << EXTRA_BITS);
+    const uint32_t numBands = (frame.height + ROW_BAND_SIZE - 1) / ROW_BAND_SIZE;
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        vector<float> r(frame.width), g(frame.width), b(frame.width);
+        const uint32_t end = min(frame.height, (band + 1) * ROW_BAND_SIZE);
+        for (uint32_t y = band * ROW_BAND_SIZE; y < end; y++)
+        {
+            Quantize::Unpack_Row(level, layout, &frame.pixels[(size_t)y * frame.rowPitch], frame.width, r.data(), g.data(), b.data(), nullptr);
+
+            uint16_t* codes = &plane.codes[(size_t)y * frame.width];
+#if SIMD_X86
+            if (level >= SIMD_AVX2)
+            {
+                Luma_Codes_Row_AVX2(r.data(), g.data(), b.data(), frame.width, maxCode, codes);
+                continue;
+            }
+#endif
+            Luma_Codes_Row_Scalar(r.data(), g.data(), b.data(), 0, frame.width, maxCode, codes);
+        }
+    });
+}
+
+/**
+* Halve the resolution with the rounded mean of each 2x2 block.
+*/
+static void Downscale(ThreadPool &pool, const Plane &src, Plane &dest)
+{
+    dest.width = src.width / 2;
+    dest.height = src.height / 2;
+    dest.codes.resize((size_t)dest.width * dest.height);
+
+    const uint32_t numBands = (dest.height + ROW_BAND_SIZE - 1) / ROW_BAND_SIZE;
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        const uint32_t end = min(dest.height, (band + 1) * ROW_BAND_SIZE);
+        for (uint32_t y = band * ROW_BAND_SIZE; y < end; y++)
+        {
+            const uint16_t* top = &src.codes[(size_t)(y * 2) * src.width];
+            const uint16_t* bottom = top + src.width;
+            uint16_t* codes = &dest.codes[(size_t)y * dest.width];
+            for (uint32_t x = 0; x < dest.width; x++)
+            {
+                codes[x] = (uint16_t)((top[x * 2] + top[x * 2 + 1] + bottom[x * 2] + bottom[x * 2 + 1] + 2) >> 2);
+            }
+        }
+    });
+}
+
+/**
+* Mark the pixels where more than half of the surrounding area has a zero derivative,
+* that is, equals its right and lower neighbors.
+*/
+static void Compute_Mask(ThreadPool &pool, SimdLevel level, Plane &plane)
+{
+    const uint32_t width = plane.width;
+    const uint32_t height = plane.height;
+    const uint32_t radius = CAMBI_MASK_SIZE / 2;
+    const uint8_t threshold = (uint8_t)((CAMBI_MASK_SIZE * CAMBI_MASK_SIZE) / 2);
+
+    auto sumRows = [level](const uint8_t* const* rows, uint32_t numRows, uint32_t count, uint8_t* sums)
+    {
+#if SIMD_X86
+        if (level >= SIMD_AVX2)
+        {
+            Sum_Rows_AVX2(rows, numRows, count, sums);
+            return;
+        }
+#endif
+        Sum_Rows_Scalar(rows, numRows, 0, count, sums);
+    };
+
+    // Count the zero derivatives of each row over the width of the area, as the sum of
+    // the shifted row (padded with zeros on either side)
+    vector<uint8_t> rowCounts((size_t)width * height);
+    const uint32_t numBands = (height + ROW_BAND_SIZE - 1) / ROW_BAND_SIZE;
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        vector<uint8_t> padded(width + radius * 2, 0);
+        uint8_t* zero = &padded[radius];
+
+        const uint8_t* shifted[CAMBI_MASK_SIZE];
+        for (uint32_t i = 0; i < CAMBI_MASK_SIZE; i++) shifted[i] = &padded[i];
+
+        const uint32_t end = min(height, (band + 1) * ROW_BAND_SIZE);
+        for (uint32_t y = band * ROW_BAND_SIZE; y < end; y++)
+        {
+            const uint16_t* codes = &plane.codes[(size_t)y * width];
+            const uint16_t* below = ((y + 1) < height) ? codes + width : codes;
+#if SIMD_X86
+            if (level >= SIMD_AVX2) Zero_Derivatives_Row_AVX2(codes, below, width, zero);
+            else
+#endif
+            Zero_Derivatives_Row_Scalar(codes, below, 0, width, zero);
+
+            sumRows(shifted, CAMBI_MASK_SIZE, width, &rowCounts[(size_t)y * width]);
+        }
+    });
+
+    // Sum the row counts over the height of the area
+    plane.mask.resize((size_t)width * height);
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        vector<uint8_t> sums(width);
+        const uint8_t* rows[CAMBI_MASK_SIZE];
+
+        const uint32_t end = min(height, (band + 1) * ROW_BAND_SIZE);
+        for (uint32_t y = band * ROW_BAND_SIZE; y < end; y++)
+        {
+            uint32_t numRows = 0;
+            for (uint32_t row = (y > radius) ? (y - radius) : 0; row <= min(height - 1, y + radius); row++)
+            {
+                rows[numRows++] = &rowCounts[(size_t)row * width];
+            }
+            sumRows(rows, numRows, width, sums.data());
+
+            uint8_t* mask = &plane.mask[(size_t)y * width];
+#if SIMD_X86
+            if (level >= SIMD_AVX2)
+            {
+                Threshold_Row_AVX2(sums.data(), width, threshold, mask);
+                continue;
+            }
+#endif
+            Threshold_Row_Scalar(sums.data(), 0, width, threshold, mask);
+        }
+    });
+}
+
+/**
+* The weight of steps of 1 to NUM_DIFFS codes up from each code (with fraction): the size
+* of the step when it is visible, by its luminance contrast on an sRGB display, or zero.
+*/
+static vector<float> Get_Step_Weights(uint32_t bits)
+{
+    const uint32_t levels = (1u << (bits + EXTRA_BITS));
+    const float maxCode = (float)(((1u << bits) - 1) << EXTRA_BITS);
+
+    auto luminance = [](float x)
+    {
+        const float linear = (x <= 0.04045f) ? (x / 12.92f) : powf((x + 0.055f) / 1.055f, 2.4f);
+        return linear + BLACK_LEVEL;
+    };
+
+    vector<float> weights((NUM_DIFFS + 1) * levels, 0.f);
+    for (uint32_t d = 1; d <= NUM_DIFFS; d++)
+    {
+        for (uint32_t v = 0; v < levels; v++)
+        {
+            const float base = luminance((float)v / maxCode);
+            const float step = luminance((float)(v + (d << EXTRA_BITS)) / maxCode);
+            if (((step - base) / base) >= CAMBI_VISIBILITY_THRESHOLD) weights[d * levels + v] = (float)d;
+        }
+    }
+    return weights;
+}
+
+//--------------------------------------------------------------------------------------
+// C-Values
+// For each flat pixel, with p(v) the fraction of the window's flat pixels with code v:
+// c = max over steps d of d * p(v) * p(v +- d) / (p(v) + p(v +- d)), with the larger of
+// the neighboring codes. It is largest when the window is split evenly between two flat
+// areas with a visible step between them, as at the edge of a band.
+//
+// The kernels compute a row of a tile from its window counts (see Tile_C_Values()), with
+// the same operations in the same order, so every level gives identical values.
+//--------------------------------------------------------------------------------------
+
+static void C_Values_Row_Scalar(const uint16_t* counts, uint32_t columns, const uint16_t* codes, const uint8_t* mask, const float* weights, uint32_t levels, float inverseArea, uint32_t start, uint32_t count, float* values)
+{
+    for (uint32_t i = start; i < count; i++)
+    {
+        if (!mask[i])
+        {
+            values[i] = 0.f;
+            continue;
+        }
+
+        const ptrdiff_t index = (ptrdiff_t)codes[i] * (ptrdiff_t)columns + (ptrdiff_t)i;
+        const float p0 = (float)counts[index];
+
+        float c = 0.f;
+        for (uint32_t d = 1; d <= NUM_DIFFS; d++)
+        {
+            const ptrdiff_t step = (ptrdiff_t)((d << EXTRA_BITS) * columns);
+            const float p1 = (float)max(counts[index + step], counts[index - step]);
+            c = max(c, (weights[d * levels + codes[i]] * (p0 * p1)) / max(p0 + p1, 1.f));
+        }
+        values[i] = c * inverseArea;
+    }
+}
+
+#if SIMD_X86
+
+/**
+* Eight pixels at a time, with the counts gathered as 32-bit values (the histogram is
+* padded, so the upper half is always readable) and masked to 16 bits. Groups without
+* flat pixels are skipped.
+*/
+SIMD_TARGET_AVX2 static void C_Values_Row_AVX2(const uint16_t* counts, uint32_t columns, const uint16_t* codes, const uint8_t* mask, const float* weights, uint32_t levels, float inverseArea, uint32_t count, float* values)
+{
+    const __m256i vColumns = _mm256_set1_epi32((int)columns);
+    const __m256i vLow = _mm256_set1_epi32(0xFFFF);
+    const __m256 vOne = _mm256_set1_ps(1.f);
+    const __m256 vInverseArea = _mm256_set1_ps(inverseArea);
+    const int* base = (const int*)counts;
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
+    {
+        // Most of a dithered frame is not flat
+        const __m128i flat8 = _mm_loadl_epi64((const __m128i*)(mask + i));
+        if (_mm_testz_si128(flat8, flat8))
+        {
+            _mm256_storeu_ps(values + i, _mm256_setzero_ps());
+            continue;
+        }
+
+        const __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(codes + i)));
+        const __m256i flat = _mm256_cvtepu8_epi32(flat8);
+        const __m256i column = _mm256_add_epi32(_mm256_set1_epi32((int)i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(v, vColumns), column);
+        const __m256 p0 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_i32gather_epi32(base, index, 2), vLow));
+
+        __m256 c = _mm256_setzero_ps();
+        for (uint32_t d = 1; d <= NUM_DIFFS; d++)
+        {
+            const __m256i step = _mm256_set1_epi32((int)((d << EXTRA_BITS) * columns));
+            const __m256i up = _mm256_and_si256(_mm256_i32gather_epi32(base, _mm256_add_epi32(index, step), 2), vLow);
+            const __m256i down = _mm256_and_si256(_mm256_i32gather_epi32(base, _mm256_sub_epi32(index, step), 2), vLow);
+            const __m256 p1 = _mm256_cvtepi32_ps(_mm256_max_epi32(up, down));
+            const __m256 weight = _mm256_i32gather_ps(weights + d * levels, v, 4);
+            const __m256 value = _mm256_div_ps(_mm256_mul_ps(weight, _mm256_mul_ps(p0, p1)), _mm256_max_ps(_mm256_add_ps(p0, p1), vOne));
+            c = _mm256_max_ps(c, value);
+        }
+
+        const __m256 isFlat = _mm256_castsi256_ps(_mm256_cmpgt_epi32(flat, _mm256_setzero_si256()));
+        _mm256_storeu_ps(values + i, _mm256_and_ps(_mm256_mul_ps(c, vInverseArea), isFlat));
+    }
+    C_Values_Row_Scalar(counts, columns, codes, mask, weights, levels, inverseArea, i, count, values);
+}
+
+#endif
+
+/**
+* Compute the c-values of one tile. The window counts of each column of the tile are kept
+* in a histogram (one row of counts per code), updated as the window slides down.
+*/
+static void Tile_C_Values(SimdLevel level, const Plane &plane, uint32_t levels, const vector<float> &weights, uint32_t window, uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1, uint32_t scale, TileBins &bins, float* heatmap, uint32_t heatmapWidth, uint32_t heatmapHeight)
+{
+    const int width = (int)plane.width;
+    const int height = (int)plane.height;
+    const int radius = (int)(window / 2);
+    const uint32_t columns = x1 - x0;
+    const float inverseArea = 1.f / (float)(window * window);
+
+    // Pad on either side, so steps past the range read zero, plus one count for the gathers
+    vector<uint16_t> histogram((size_t)(levels + PAD_CODES * 2) * columns + 1, 0);
+    uint16_t* counts = &histogram[(size_t)PAD_CODES * columns];
+    vector<float> values(columns);
+
+    auto update = [&](int y, bool subtract)
+    {
+        const uint16_t* codes = &plane.codes[(size_t)y * width];
+        const uint8_t* mask = &plane.mask[(size_t)y * width];
+        const int start = max(0, (int)x0 - radius);
+        const int end = min(width, (int)x1 + radius);
+        for (int x = start; x < end; x++)
+        {
+            if (!mask[x]) continue;
+
+            // Find the run of flat pixels with this code, in tile columns
+            int last = x;
+            while ((last + 1) < end && mask[last + 1] && codes[last + 1] == codes[x]) last++;
+
+            const int first = x - (int)x0;
+            const int runEnd = last - (int)x0;
+            uint16_t* row = counts + (size_t)codes[x] * columns;
+            x = last;
+#if SIMD_X86
+            if (level >= SIMD_AVX2)
+            {
+                Add_Run_AVX2(row, max(first - radius, 0), min(runEnd + radius, (int)columns - 1), first, runEnd, radius, subtract);
+                continue;
+            }
+#endif
+            Add_Run_Scalar(row, max(first - radius, 0), min(runEnd + radius, (int)columns - 1), first, runEnd, radius, subtract);
+        }
+    };
+
+    for (int y = max(0, (int)y0 - radius); y < min(height, (int)y0 + radius); y++) update(y, false);
+
+    const uint32_t blockSize = (1u << scale);
+    for (int y = (int)y0; y < (int)y1; y++)
+    {
+        if (y + radius < height) update(y + radius, false);
+
+        const uint16_t* codes = &plane.codes[(size_t)y * width + x0];
+        const uint8_t* mask = &plane.mask[(size_t)y * width + x0];
+#if SIMD_X86
+        if (level >= SIMD_AVX2) C_Values_Row_AVX2(counts, columns, codes, mask, weights.data(), levels, inverseArea, columns, values.data());
+        else
+#endif
+        C_Values_Row_Scalar(counts, columns, codes, mask, weights.data(), levels, inverseArea, 0, columns, values.data());
+
+        for (uint32_t x = x0; x < x1; x++)
+        {
+            const float c = values[x - x0];
+            if (c <= 0.f) continue;
+
+            const uint32_t bin = min(POOL_BINS - 1, (uint32_t)(c * ((float)POOL_BINS / MAX_C_VALUE)));
+            bins.counts[bin]++;
+            bins.sums[bin] += (double)c;
+
+            if (heatmap)
+            {
+                // Each pixel covers a block of the full resolution heatmap
+                const uint32_t bx = x * blockSize;
+                const uint32_t by = (uint32_t)y * blockSize;
+                for (uint32_t hy = by; hy < min(by + blockSize, heatmapHeight); hy++)
+                {
+                    float* values = &heatmap[(size_t)hy * heatmapWidth];
+                    for (uint32_t hx = bx; hx < min(bx + blockSize, heatmapWidth); hx++) values[hx] = max(values[hx], c);
+                }
+            }
+        }
+
+        if (y - radius >= 0) update(y - radius, true);
+    }
+}
+
+/**
+* Score one scale: the mean of its highest CAMBI_TOPK fraction of c-values, where pixels
+* outside the mask count as zero.
+*/
+static double Score_Scale(ThreadPool &pool, SimdLevel level, const Plane &plane, uint32_t levels, const vector<float> &weights, uint32_t window, uint32_t scale, float* heatmap, uint32_t heatmapWidth, uint32_t heatmapHeight)
+{
+    const uint32_t tilesX = (plane.width + TILE_WIDTH - 1) / TILE_WIDTH;
+    const uint32_t tilesY = (plane.height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+
+    vector<TileBins> tiles(tilesX * tilesY);
+    Threading::Parallel_For(pool, tilesX * tilesY, [&](uint32_t tile)
+    {
+        const uint32_t x0 = (tile % tilesX) * TILE_WIDTH;
+        const uint32_t y0 = (tile / tilesX) * TILE_HEIGHT;
+
+        TileBins &bins = tiles[tile];
+        bins.counts.assign(POOL_BINS, 0);
+        bins.sums.assign(POOL_BINS, 0.0);
+        Tile_C_Values(level, plane, levels, weights, window, x0, min(plane.width, x0 + TILE_WIDTH), y0, min(plane.height, y0 + TILE_HEIGHT), scale, bins, heatmap, heatmapWidth, heatmapHeight);
+    });
+
+    // Combine the bins in order
+    vector<uint64_t> counts(POOL_BINS, 0);
+    vector<double> sums(POOL_BINS, 0.0);
+    for (const TileBins &bins : tiles)
+    {
+        for (uint32_t bin = 0; bin < POOL_BINS; bin++)
+        {
+            counts[bin] += bins.counts[bin];
+            sums[bin] += bins.sums[bin];
+        }
+    }
+
+    // Take the highest values, with the mean of the last bin for any part of it
+    const double k = max(1.0, floor((double)CAMBI_TOPK * plane.width * plane.height));
+    double taken = 0.0;
+    double total = 0.0;
+    for (uint32_t bin = POOL_BINS; bin-- > 0 && taken < k;)
+    {
+        if (counts[bin] == 0) continue;
+        const double count = min((double)counts[bin], k - taken);
+        total += count * (sums[bin] / (double)counts[bin]);
+        taken += count;
+    }
+    return total / k;
+}
+
+//--------------------------------------------------------------------------------------
+// Public Functions
+//--------------------------------------------------------------------------------------
+
+/**
+* Score the banding of a frame, packed with layout, with the given instruction set.
+*/
+CambiResult Score(ThreadPool &pool, SimdLevel level, const SoftwareFrame &frame, const PixelLayout &layout, bool heatmap)
+{
+    if (frame.bytesPerPixel != layout.bytesPerPixel) throw runtime_error("Error: frame was not created for the pixel layout!");
+    if (frame.width < CAMBI_MASK_SIZE || frame.height < CAMBI_MASK_SIZE) throw runtime_error("Error: frame is too small to score banding!");
+
+    auto start = chrono::high_resolution_clock::now();
+
+    CambiResult result;
+    result.width = frame.width;
+    result.height = frame.height;
+    if (heatmap) result.heatmap.assign((size_t)frame.width * frame.height, 0.f);
+
+    const uint32_t bits = min(Quantize::Get_Color_Bits(layout), CAMBI_MAX_BITS);
+    const uint32_t levels = (1u << (bits + EXTRA_BITS));
+    const vector<float> weights = Get_Step_Weights(bits);
+
+    // The window covers the same fraction of the frame at any resolution
+    const uint32_t window = max(3u, ((CAMBI_WINDOW_SIZE * frame.width) / 3840u) | 1u);
+
+    Plane planes[2];
+    To_Codes(pool, level, frame, layout, bits, planes[0]);
+
+    uint32_t numScales = 0;
+    double total = 0.0;
+    for (uint32_t scale = 0; scale < CAMBI_NUM_SCALES; scale++)
+    {
+        Plane &plane = planes[scale & 1];
+        if (scale > 0) Downscale(pool, planes[(scale - 1) & 1], plane);
+        if (plane.width < CAMBI_MASK_SIZE || plane.height < CAMBI_MASK_SIZE) break;
+
+        Compute_Mask(pool, level, plane);
+        result.scaleScores[scale] = Score_Scale(pool, level, plane, levels, weights, window, scale, heatmap ? result.heatmap.data() : nullptr, frame.width, frame.height);
+        total += result.scaleScores[scale];
+        numScales++;
+    }
+    result.score = total / (double)numScales;
+
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    result.milliseconds = elapsed.count();
+    return result;
+}
+
+/**
+* Score the banding of a frame, packed with layout.
+*/
+CambiResult Score(ThreadPool &pool, const SoftwareFrame &frame, const PixelLayout &layout, bool heatmap)
+{
+    return Score(pool, Simd::Get_Level(), frame, layout, heatmap);
+}
+
+/**
+* Write the heatmap of a result as a grayscale PNG, with white at a one code step between
+* two flat areas of equal size (or anything larger).
+*/
+void Write_Heatmap(const string &filepath, const CambiResult &result)
+{
+    if (result.heatmap.empty()) throw runtime_error("Error: result has no heatmap!");
+
+    vector<uint8_t> pixels(result.heatmap.size());
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        const float value = min(result.heatmap[i] / HEATMAP_WHITE, 1.f);
+        pixels[i] = (uint8_t)(value * 255.f + 0.5f);
+    }
+    Utils::WritePNG(filepath, pixels.data(), (int)result.width, (int)result.height, 1);
+}
+
+}
@@ -0,0 +1,759 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Color.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace Color
+{
+
+//--------------------------------------------------------------------------------------
+// Compile Time Math
+// std::pow is not constexpr, so the tables are generated with these instead.
+//--------------------------------------------------------------------------------------
+
+static constexpr double LN2 = 0.69314718055994530942;
+
+static constexpr double ConstLog(double x)
+{
+    // Reduce to [1, 2), then ln(m) = 2 * atanh((m - 1) / (m + 1))
+    int k = 0;
+    while (x >= 2.0) { x *= 0.5; k++; }
+    while (x < 1.0) { x *= 2.0; k--; }
+
+    const double z = (x - 1.0) / (x + 1.0);
+    const double z2 = z * z;
+    double term = z;
+    double sum = 0.0;
+    for (int n = 1; n < 40; n += 2)
+    {
+        sum += term / n;
+        term *= z2;
+    }
+    return 2.0 * sum + k * LN2;
+}
+
+static constexpr double ConstExp(double y)
+{
+    // Reduce to [0, ln 2), then a Taylor series
+    int k = (int)(y / LN2);
+    if ((k * LN2) > y) k--;
+
+    const double r = y - k * LN2;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 24; n++)
+    {
+        term *= r / n;
+        sum += term;
+    }
+
+    while (k > 0) { sum *= 2.0; k--; }
+    while (k < 0) { sum *= 0.5; k++; }
+    return sum;
+}
+
+static constexpr double ConstPow(double x, double p)
+{
+    return (x <= 0.0) ? 0.0 : ConstExp(p * ConstLog(x));
+}
+
+static constexpr double ConstExp2(int e)
+{
+    double result = 1.0;
+    while (e > 0) { result *= 2.0; e--; }
+    while (e < 0) { result *= 0.5; e++; }
+    return result;
+}
+
+// The power segment of LinearToSRGB() in Common.hlsl
+static constexpr double EncodeCurve(double x)
+{
+    return ConstPow(x * 1.055, 1.0 / 2.4) - 0.055;
+}
+
+// The power segment of the IEC 61966-2-1 sRGB decode
+static constexpr double DecodeCurve(double x)
+{
+    return ConstPow((x + 0.055) / 1.055, 2.4);
+}
+
+//--------------------------------------------------------------------------------------
+// Tables
+//--------------------------------------------------------------------------------------
+
+static const int SEGMENT_SHIFT = 6;                     // 64 segments per octave
+static const int SEGMENTS = (1 << SEGMENT_SHIFT);
+
+static const int ENCODE_MIN_EXPONENT = -9;              // 2^-9 < 0.0031308, the encode threshold
+static const int DECODE_MIN_EXPONENT = -5;              // 2^-5 < 0.04045, the decode threshold
+
+template <int Size>
+struct SegmentTable
+{
+    float c0[Size];
+    float c1[Size];
+};
+
+/**
+* Build secant lines for each segment, from 2^minExponent up to and including 1.
+* Segment i covers [2^(minExponent + i / SEGMENTS) * (1 + (i % SEGMENTS) / SEGMENTS), ...).
+*/
+template <int Size>
+static constexpr SegmentTable<Size> Build_Segment_Table(double (*curve)(double), int minExponent)
+{
+    SegmentTable<Size> table = {};
+    double start = ConstExp2(minExponent);
+    double startValue = curve(start);
+    for (int i = 0; i < Size; i++)
+    {
+        const double octave = ConstExp2(minExponent + (i / SEGMENTS));
+        const double end = octave * (1.0 + (double)((i % SEGMENTS) + 1) / SEGMENTS);
+        const double endValue = curve(end);
+        const double slope = (endValue - startValue) / (end - start);
+
+        table.c1[i] = (float)slope;
+        table.c0[i] = (float)(startValue - slope * start);
+
+        start = end;
+        startValue = endValue;
+    }
+    return table;
+}
+
+static const int ENCODE_TABLE_SIZE = (-ENCODE_MIN_EXPONENT * SEGMENTS) + 1;
+static const int DECODE_TABLE_SIZE = (-DECODE_MIN_EXPONENT * SEGMENTS) + 1;
+
+static constexpr SegmentTable<ENCODE_TABLE_SIZE> EncodeTable = Build_Segment_Table<ENCODE_TABLE_SIZE>(EncodeCurve, ENCODE_MIN_EXPONENT);
+static constexpr SegmentTable<DECODE_TABLE_SIZE> DecodeTable = Build_Segment_Table<DECODE_TABLE_SIZE>(DecodeCurve, DECODE_MIN_EXPONENT);
+
+struct ExponentTable
+{
+    float values[16];
+};
+
+/**
+* 2^(e * power) for e in [minExponent, minExponent + 15].
+*/
+static constexpr ExponentTable Build_Exponent_Table(double power, int minExponent)
+{
+    ExponentTable table = {};
+    for (int i = 0; i < 16; i++)
+    {
+        table.values[i] = (float)ConstExp((minExponent + i) * power * LN2);
+    }
+    return table;
+}
+
+static constexpr ExponentTable EncodeExponents = Build_Exponent_Table(1.0 / 2.4, ENCODE_MIN_EXPONENT);
+static constexpr ExponentTable DecodeExponents = Build_Exponent_Table(2.4, DECODE_MIN_EXPONENT);
+
+struct ByteTable
+{
+    float values[256];
+};
+
+static constexpr ByteTable Build_SRGB8_Table()
+{
+    ByteTable table = {};
+    for (int i = 0; i < 256; i++)
+    {
+        const double x = i / 255.0;
+        table.values[i] = (float)((x <= 0.04045) ? (x / 12.92) : DecodeCurve(x));
+    }
+    return table;
+}
+
+static constexpr ByteTable SRGB8ToLinearTable = Build_SRGB8_Table();
+
+// Minimax fits of m^p for the mantissa m in [1, 2), in terms of t = m - 1.5
+static const float EncodePolynomial[6] = { 1.184052272e+00f, 3.289081455e-01f, -6.386020400e-02f, 2.239355195e-02f, -1.065484817e-02f, 5.333131604e-03f };
+static const float DecodePolynomial[6] = { 2.646177239e+00f, 4.233885669e+00f, 1.975852886e+00f, 1.755979997e-01f, -1.798510910e-02f, 3.943586177e-03f };
+
+// ACESFilm() coefficients, and a clamp well past the point where the curve saturates
+static const float ACES_A = 2.51f;
+static const float ACES_B = 0.03f;
+static const float ACES_C = 2.43f;
+static const float ACES_D = 0.59f;
+static const float ACES_E = 0.14f;
+static const float ACES_LIMIT = 65504.f;
+
+const float* Get_SRGB8_To_Linear_Table()
+{
+    return SRGB8ToLinearTable.values;
+}
+
+//--------------------------------------------------------------------------------------
+// Scalar Kernels
+//--------------------------------------------------------------------------------------
+
+static inline uint32_t FloatBits(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+static inline float BitsFloat(uint32_t bits)
+{
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+static inline int SegmentIndex(float x, int minExponent, int size)
+{
+    int index = (int)(FloatBits(x) >> (23 - SEGMENT_SHIFT)) - ((127 + minExponent) << SEGMENT_SHIFT);
+    return (index < 0) ? 0 : ((index >= size) ? (size - 1) : index);
+}
+
+/**
+* Evaluate y^p as polynomial(mantissa) * 2^(exponent * p), for y > 0.
+*/
+static inline float PowPolynomial(float y, const float* coefficients, const ExponentTable &exponents, int minExponent)
+{
+    const uint32_t bits = FloatBits(y);
+    int e = (int)(bits >> 23) - 127 - minExponent;
+    e = (e < 0) ? 0 : ((e > 15) ? 15 : e);
+
+    const float t = BitsFloat((bits & 0x007FFFFF) | 0x3F800000) - 1.5f;
+    float p = coefficients[5];
+    for (int i = 4; i >= 0; i--) p = p * t + coefficients[i];
+    return p * exponents.values[e];
+}
+
+float LinearToSRGB_LUT(float x)
+{
+    x = Saturate(x);
+    const int i = SegmentIndex(x, ENCODE_MIN_EXPONENT, ENCODE_TABLE_SIZE);
+    const float value = EncodeTable.c0[i] + EncodeTable.c1[i] * x;
+    return (x < 0.0031308f) ? (x * 12.92f) : value;
+}
+
+float LinearToSRGB_Polynomial(float x)
+{
+    x = Saturate(x);
+    const float value = PowPolynomial(x * 1.055f, EncodePolynomial, EncodeExponents, ENCODE_MIN_EXPONENT) - 0.055f;
+    return (x < 0.0031308f) ? (x * 12.92f) : value;
+}
+
+float SRGBToLinear_LUT(float x)
+{
+    x = Saturate(x);
+    const int i = SegmentIndex(x, DECODE_MIN_EXPONENT, DECODE_TABLE_SIZE);
+    const float value = DecodeTable.c0[i] + DecodeTable.c1[i] * x;
+    return (x <= 0.04045f) ? (x / 12.92f) : value;
+}
+
+float SRGBToLinear_Polynomial(float x)
+{
+    x = Saturate(x);
+    const float value = PowPolynomial((x + 0.055f) / 1.055f, DecodePolynomial, DecodeExponents, DECODE_MIN_EXPONENT);
+    return (x <= 0.04045f) ? (x / 12.92f) : value;
+}
+
+/**
+* ACESFilm() with the input clamped to a finite range, so infinities reach the limit of
+* the curve instead of Inf / Inf. Every finite input gives the same result as before.
+*/
+static inline float ACESFilm_FMA(float x)
+{
+    x = (x > ACES_LIMIT) ? ACES_LIMIT : ((x < -ACES_LIMIT) ? -ACES_LIMIT : x);
+    const float numerator = x * fmaf(ACES_A, x, ACES_B);
+    const float denominator = fmaf(x, fmaf(ACES_C, x, ACES_D), ACES_E);
+    return Saturate(numerator / denominator);
+}
+
+/**
+* Scalar batch kernels, with the same signatures as the SIMD kernels below.
+*/
+static void LinearToSRGB_Scalar(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    if (mode == TRANSFER_LUT)
+    {
+        for (uint32_t i = 0; i < count; i++) output[i] = LinearToSRGB_LUT(input[i]);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < count; i++) output[i] = LinearToSRGB_Polynomial(input[i]);
+    }
+}
+
+static void SRGBToLinear_Scalar(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    if (mode == TRANSFER_LUT)
+    {
+        for (uint32_t i = 0; i < count; i++) output[i] = SRGBToLinear_LUT(input[i]);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < count; i++) output[i] = SRGBToLinear_Polynomial(input[i]);
+    }
+}
+
+static void ACESFilm_Scalar(const float* input, float* output, uint32_t count, bool rgba)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        output[i] = (rgba && (i & 3) == 3) ? input[i] : ACESFilm_FMA(input[i]);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// SIMD Kernels
+// Same operations, in the same order, as the scalar kernels above. SSE4.2 has no FMA,
+// so ACESFilm runs the scalar kernel (with fmaf) at that level.
+//--------------------------------------------------------------------------------------
+
+#if SIMD_X86
+
+SIMD_TARGET_SSE42 static inline __m128 Saturate_SSE42(__m128 x)
+{
+    // max(x, 0) returns the second operand for NaN, so NaN becomes 0
+    return _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.f));
+}
+
+SIMD_TARGET_SSE42 static inline __m128i SegmentIndex_SSE42(__m128 x, int minExponent, int size)
+{
+    __m128i index = _mm_srli_epi32(_mm_castps_si128(x), 23 - SEGMENT_SHIFT);
+    index = _mm_sub_epi32(index, _mm_set1_epi32((127 + minExponent) << SEGMENT_SHIFT));
+    return _mm_min_epi32(_mm_max_epi32(index, _mm_setzero_si128()), _mm_set1_epi32(size - 1));
+}
+
+/**
+* SSE has no gather, so the 4 entries are loaded one at a time.
+*/
+SIMD_TARGET_SSE42 static inline __m128 Lookup_SSE42(const float* table, __m128i index)
+{
+    return _mm_setr_ps(table[_mm_extract_epi32(index, 0)], table[_mm_extract_epi32(index, 1)], table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 3)]);
+}
+
+SIMD_TARGET_SSE42 static inline __m128 PowPolynomial_SSE42(__m128 y, const float* coefficients, const ExponentTable &exponents, int minExponent)
+{
+    const __m128i bits = _mm_castps_si128(y);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127 + minExponent));
+    e = _mm_min_epi32(_mm_max_epi32(e, _mm_setzero_si128()), _mm_set1_epi32(15));
+
+    const __m128i mantissa = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000));
+    const __m128 t = _mm_sub_ps(_mm_castsi128_ps(mantissa), _mm_set1_ps(1.5f));
+
+    __m128 p = _mm_set1_ps(coefficients[5]);
+    for (int i = 4; i >= 0; i--) p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(coefficients[i]));
+    return _mm_mul_ps(p, Lookup_SSE42(exponents.values, e));
+}
+
+SIMD_TARGET_SSE42 static void LinearToSRGB_SSE42(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    const __m128 threshold = _mm_set1_ps(0.0031308f);
+    uint32_t i = 0;
+    for (; (i + 4) <= count; i += 4)
+    {
+        const __m128 x = Saturate_SSE42(_mm_loadu_ps(input + i));
+        __m128 value;
+        if (mode == TRANSFER_LUT)
+        {
+            const __m128i index = SegmentIndex_SSE42(x, ENCODE_MIN_EXPONENT, ENCODE_TABLE_SIZE);
+            value = _mm_add_ps(Lookup_SSE42(EncodeTable.c0, index), _mm_mul_ps(Lookup_SSE42(EncodeTable.c1, index), x));
+        }
+        else
+        {
+            value = PowPolynomial_SSE42(_mm_mul_ps(x, _mm_set1_ps(1.055f)), EncodePolynomial, EncodeExponents, ENCODE_MIN_EXPONENT);
+            value = _mm_sub_ps(value, _mm_set1_ps(0.055f));
+        }
+        const __m128 linear = _mm_mul_ps(x, _mm_set1_ps(12.92f));
+        _mm_storeu_ps(output + i, _mm_blendv_ps(value, linear, _mm_cmplt_ps(x, threshold)));
+    }
+
+    LinearToSRGB_Scalar(mode, input + i, output + i, count - i);
+}
+
+SIMD_TARGET_SSE42 static void SRGBToLinear_SSE42(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    const __m128 threshold = _mm_set1_ps(0.04045f);
+    uint32_t i = 0;
+    for (; (i + 4) <= count; i += 4)
+    {
+        const __m128 x = Saturate_SSE42(_mm_loadu_ps(input + i));
+        __m128 value;
+        if (mode == TRANSFER_LUT)
+        {
+            const __m128i index = SegmentIndex_SSE42(x, DECODE_MIN_EXPONENT, DECODE_TABLE_SIZE);
+            value = _mm_add_ps(Lookup_SSE42(DecodeTable.c0, index), _mm_mul_ps(Lookup_SSE42(DecodeTable.c1, index), x));
+        }
+        else
+        {
+            const __m128 y = _mm_div_ps(_mm_add_ps(x, _mm_set1_ps(0.055f)), _mm_set1_ps(1.055f));
+            value = PowPolynomial_SSE42(y, DecodePolynomial, DecodeExponents, DECODE_MIN_EXPONENT);
+        }
+        const __m128 linear = _mm_div_ps(x, _mm_set1_ps(12.92f));
+        _mm_storeu_ps(output + i, _mm_blendv_ps(value, linear, _mm_cmple_ps(x, threshold)));
+    }
+
+    SRGBToLinear_Scalar(mode, input + i, output + i, count - i);
+}
+
+SIMD_TARGET_AVX2 static inline __m256 Saturate_AVX2(__m256 x)
+{
+    // max(x, 0) returns the second operand for NaN, so NaN becomes 0
+    return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+}
+
+SIMD_TARGET_AVX2 static inline __m256i SegmentIndex_AVX2(__m256 x, int minExponent, int size)
+{
+    __m256i index = _mm256_srli_epi32(_mm256_castps_si256(x), 23 - SEGMENT_SHIFT);
+    index = _mm256_sub_epi32(index, _mm256_set1_epi32((127 + minExponent) << SEGMENT_SHIFT));
+    return _mm256_min_epi32(_mm256_max_epi32(index, _mm256_setzero_si256()), _mm256_set1_epi32(size - 1));
+}
+
+/**
+* Look up 16 entries with two in-register permutes instead of a gather.
+*/
+SIMD_TARGET_AVX2 static inline __m256 Lookup16_AVX2(const float* table, __m256i index)
+{
+    const __m256 lo = _mm256_permutevar8x32_ps(_mm256_loadu_ps(table), index);
+    const __m256 hi = _mm256_permutevar8x32_ps(_mm256_loadu_ps(table + 8), index);
+    const __m256 useHi = _mm256_castsi256_ps(_mm256_cmpgt_epi32(index, _mm256_set1_epi32(7)));
+    return _mm256_blendv_ps(lo, hi, useHi);
+}
+
+SIMD_TARGET_AVX2 static inline __m256 PowPolynomial_AVX2(__m256 y, const float* coefficients, const ExponentTable &exponents, int minExponent)
+{
+    const __m256i bits = _mm256_castps_si256(y);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127 + minExponent));
+    e = _mm256_min_epi32(_mm256_max_epi32(e, _mm256_setzero_si256()), _mm256_set1_epi32(15));
+
+    const __m256i mantissa = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000));
+    const __m256 t = _mm256_sub_ps(_mm256_castsi256_ps(mantissa), _mm256_set1_ps(1.5f));
+
+    __m256 p = _mm256_set1_ps(coefficients[5]);
+    for (int i = 4; i >= 0; i--) p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(coefficients[i]));
+    return _mm256_mul_ps(p, Lookup16_AVX2(exponents.values, e));
+}
+
+SIMD_TARGET_AVX2 static void LinearToSRGB_AVX2(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    const __m256 threshold = _mm256_set1_ps(0.0031308f);
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
+    {
+        const __m256 x = Saturate_AVX2(_mm256_loadu_ps(input + i));
+        __m256 value;
+        if (mode == TRANSFER_LUT)
+        {
+            const __m256i index = SegmentIndex_AVX2(x, ENCODE_MIN_EXPONENT, ENCODE_TABLE_SIZE);
+            const __m256 c0 = _mm256_i32gather_ps(EncodeTable.c0, index, 4);
+            const __m256 c1 = _mm256_i32gather_ps(EncodeTable.c1, index, 4);
+            value = _mm256_add_ps(c0, _mm256_mul_ps(c1, x));
+        }
+        else
+        {
+            value = PowPolynomial_AVX2(_mm256_mul_ps(x, _mm256_set1_ps(1.055f)), EncodePolynomial, EncodeExponents, ENCODE_MIN_EXPONENT);
+            value = _mm256_sub_ps(value, _mm256_set1_ps(0.055f));
+        }
+        const __m256 linear = _mm256_mul_ps(x, _mm256_set1_ps(12.92f));
+        _mm256_storeu_ps(output + i, _mm256_blendv_ps(value, linear, _mm256_cmp_ps(x, threshold, _CMP_LT_OQ)));
+    }
+
+    for (; i < count; i++)
+    {
+        output[i] = (mode == TRANSFER_LUT) ? LinearToSRGB_LUT(input[i]) : LinearToSRGB_Polynomial(input[i]);
+    }
+}
+
+SIMD_TARGET_AVX2 static void SRGBToLinear_AVX2(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    const __m256 threshold = _mm256_set1_ps(0.04045f);
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
+    {
+        const __m256 x = Saturate_AVX2(_mm256_loadu_ps(input + i));
+        __m256 value;
+        if (mode == TRANSFER_LUT)
+        {
+            const __m256i index = SegmentIndex_AVX2(x, DECODE_MIN_EXPONENT, DECODE_TABLE_SIZE);
+            const __m256 c0 = _mm256_i32gather_ps(DecodeTable.c0, index, 4);
+            const __m256 c1 = _mm256_i32gather_ps(DecodeTable.c1, index, 4);
+            value = _mm256_add_ps(c0, _mm256_mul_ps(c1, x));
+        }
+        else
+        {
+            const __m256 y = _mm256_div_ps(_mm256_add_ps(x, _mm256_set1_ps(0.055f)), _mm256_set1_ps(1.055f));
+            value = PowPolynomial_AVX2(y, DecodePolynomial, DecodeExponents, DECODE_MIN_EXPONENT);
+        }
+        const __m256 linear = _mm256_div_ps(x, _mm256_set1_ps(12.92f));
+        _mm256_storeu_ps(output + i, _mm256_blendv_ps(value, linear, _mm256_cmp_ps(x, threshold, _CMP_LE_OQ)));
+    }
+
+    for (; i < count; i++)
+    {
+        output[i] = (mode == TRANSFER_LUT) ? SRGBToLinear_LUT(input[i]) : SRGBToLinear_Polynomial(input[i]);
+    }
+}
+
+SIMD_TARGET_AVX2 static inline __m256 ACESFilm_AVX2(__m256 x)
+{
+    // min/max return the second operand for NaN, so NaN passes through to Saturate_AVX2()
+    x = _mm256_max_ps(_mm256_set1_ps(-ACES_LIMIT), _mm256_min_ps(_mm256_set1_ps(ACES_LIMIT), x));
+    const __m256 numerator = _mm256_mul_ps(x, _mm256_fmadd_ps(_mm256_set1_ps(ACES_A), x, _mm256_set1_ps(ACES_B)));
+    const __m256 denominator = _mm256_fmadd_ps(x, _mm256_fmadd_ps(_mm256_set1_ps(ACES_C), x, _mm256_set1_ps(ACES_D)), _mm256_set1_ps(ACES_E));
+    return Saturate_AVX2(_mm256_div_ps(numerator, denominator));
+}
+
+SIMD_TARGET_AVX2 static void ACESFilm_AVX2(const float* input, float* output, uint32_t count, bool rgba)
+{
+    // Lanes 3 and 7 hold alpha when the span is RGBA
+    const __m256 alpha = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, rgba ? -1 : 0, 0, 0, 0, rgba ? -1 : 0));
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(input + i);
+        _mm256_storeu_ps(output + i, _mm256_blendv_ps(ACESFilm_AVX2(x), x, alpha));
+    }
+
+    // Run the tail through the same kernel so it matches the other SIMD levels
+    if (i < count)
+    {
+        float tail[8] = {};
+        memcpy(tail, input + i, (count - i) * sizeof(float));
+        const __m256 x = _mm256_loadu_ps(tail);
+        _mm256_storeu_ps(tail, _mm256_blendv_ps(ACESFilm_AVX2(x), x, alpha));
+        memcpy(output + i, tail, (count - i) * sizeof(float));
+    }
+}
+
+SIMD_AVX512_BEGIN
+SIMD_TARGET_AVX512 static inline __m512 Saturate_AVX512(__m512 x)
+{
+    return _mm512_min_ps(_mm512_max_ps(x, _mm512_setzero_ps()), _mm512_set1_ps(1.f));
+}
+
+SIMD_TARGET_AVX512 static inline __m512i SegmentIndex_AVX512(__m512 x, int minExponent, int size)
+{
+    __m512i index = _mm512_srli_epi32(_mm512_castps_si512(x), 23 - SEGMENT_SHIFT);
+    index = _mm512_sub_epi32(index, _mm512_set1_epi32((127 + minExponent) << SEGMENT_SHIFT));
+    return _mm512_min_epi32(_mm512_max_epi32(index, _mm512_setzero_si512()), _mm512_set1_epi32(size - 1));
+}
+
+SIMD_TARGET_AVX512 static inline __m512 PowPolynomial_AVX512(__m512 y, const float* coefficients, const ExponentTable &exponents, int minExponent)
+{
+    const __m512i bits = _mm512_castps_si512(y);
+    __m512i e = _mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127 + minExponent));
+    e = _mm512_min_epi32(_mm512_max_epi32(e, _mm512_setzero_si512()), _mm512_set1_epi32(15));
+
+    const __m512i mantissa = _mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F800000));
+    const __m512 t = _mm512_sub_ps(_mm512_castsi512_ps(mantissa), _mm512_set1_ps(1.5f));
+
+    __m512 p = _mm512_set1_ps(coefficients[5]);
+    for (int i = 4; i >= 0; i--) p = _mm512_add_ps(_mm512_mul_ps(p, t), _mm512_set1_ps(coefficients[i]));
+
+    // The whole exponent table fits in one register
+    return _mm512_mul_ps(p, _mm512_permutexvar_ps(e, _mm512_loadu_ps(exponents.values)));
+}
+
+SIMD_TARGET_AVX512 static void LinearToSRGB_AVX512(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    const __m512 threshold = _mm512_set1_ps(0.0031308f);
+    for (uint32_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = (count - i) >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+        const __m512 x = Saturate_AVX512(_mm512_maskz_loadu_ps(mask, input + i));
+        __m512 value;
+        if (mode == TRANSFER_LUT)
+        {
+            const __m512i index = SegmentIndex_AVX512(x, ENCODE_MIN_EXPONENT, ENCODE_TABLE_SIZE);
+            const __m512 c0 = _mm512_i32gather_ps(index, EncodeTable.c0, 4);
+            const __m512 c1 = _mm512_i32gather_ps(index, EncodeTable.c1, 4);
+            value = _mm512_add_ps(c0, _mm512_mul_ps(c1, x));
+        }
+        else
+        {
+            value = PowPolynomial_AVX512(_mm512_mul_ps(x, _mm512_set1_ps(1.055f)), EncodePolynomial, EncodeExponents, ENCODE_MIN_EXPONENT);
+            value = _mm512_sub_ps(value, _mm512_set1_ps(0.055f));
+        }
+        const __mmask16 below = _mm512_cmp_ps_mask(x, threshold, _CMP_LT_OQ);
+        value = _mm512_mask_mul_ps(value, below, x, _mm512_set1_ps(12.92f));
+        _mm512_mask_storeu_ps(output + i, mask, value);
+    }
+}
+
+SIMD_TARGET_AVX512 static void SRGBToLinear_AVX512(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    const __m512 threshold = _mm512_set1_ps(0.04045f);
+    for (uint32_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = (count - i) >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+        const __m512 x = Saturate_AVX512(_mm512_maskz_loadu_ps(mask, input + i));
+        __m512 value;
+        if (mode == TRANSFER_LUT)
+        {
+            const __m512i index = SegmentIndex_AVX512(x, DECODE_MIN_EXPONENT, DECODE_TABLE_SIZE);
+            const __m512 c0 = _mm512_i32gather_ps(index, DecodeTable.c0, 4);
+            const __m512 c1 = _mm512_i32gather_ps(index, DecodeTable.c1, 4);
+            value = _mm512_add_ps(c0, _mm512_mul_ps(c1, x));
+        }
+        else
+        {
+            const __m512 y = _mm512_div_ps(_mm512_add_ps(x, _mm512_set1_ps(0.055f)), _mm512_set1_ps(1.055f));
+            value = PowPolynomial_AVX512(y, DecodePolynomial, DecodeExponents, DECODE_MIN_EXPONENT);
+        }
+        const __mmask16 below = _mm512_cmp_ps_mask(x, threshold, _CMP_LE_OQ);
+        value = _mm512_mask_div_ps(value, below, x, _mm512_set1_ps(12.92f));
+        _mm512_mask_storeu_ps(output + i, mask, value);
+    }
+}
+
+SIMD_TARGET_AVX512 static inline __m512 ACESFilm_AVX512(__m512 x)
+{
+    x = _mm512_max_ps(_mm512_set1_ps(-ACES_LIMIT), _mm512_min_ps(_mm512_set1_ps(ACES_LIMIT), x));
+    const __m512 numerator = _mm512_mul_ps(x, _mm512_fmadd_ps(_mm512_set1_ps(ACES_A), x, _mm512_set1_ps(ACES_B)));
+    const __m512 denominator = _mm512_fmadd_ps(x, _mm512_fmadd_ps(_mm512_set1_ps(ACES_C), x, _mm512_set1_ps(ACES_D)), _mm512_set1_ps(ACES_E));
+    return Saturate_AVX512(_mm512_div_ps(numerator, denominator));
+}
+
+SIMD_TARGET_AVX512 static void ACESFilm_AVX512(const float* input, float* output, uint32_t count, bool rgba)
+{
+    // Skip every fourth lane when the span is RGBA, so alpha is never written
+    const __mmask16 color = rgba ? (__mmask16)0x7777 : (__mmask16)0xFFFF;
+    for (uint32_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = (count - i) >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+        const __m512 x = _mm512_maskz_loadu_ps(mask, input + i);
+        _mm512_mask_storeu_ps(output + i, mask & color, ACESFilm_AVX512(x));
+        if (rgba && (input != output)) _mm512_mask_storeu_ps(output + i, mask & ~color, x);
+    }
+}
+SIMD_AVX512_END
+
+#endif
+
+//--------------------------------------------------------------------------------------
+// Batch Functions
+// Each function binds the kernels of Simd::Get_Level() the first time it is called.
+//--------------------------------------------------------------------------------------
+
+typedef void (*TransferKernel)(TransferMode mode, const float* input, float* output, uint32_t count);
+typedef void (*ACESFilmKernel)(const float* input, float* output, uint32_t count, bool rgba);
+
+static TransferKernel Get_LinearToSRGB_Kernel(SimdLevel level)
+{
+#if SIMD_X86
+    if (level >= SIMD_AVX512) return LinearToSRGB_AVX512;
+    if (level >= SIMD_AVX2) return LinearToSRGB_AVX2;
+    if (level >= SIMD_SSE42) return LinearToSRGB_SSE42;
+#endif
+    return LinearToSRGB_Scalar;
+}
+
+static TransferKernel Get_SRGBToLinear_Kernel(SimdLevel level)
+{
+#if SIMD_X86
+    if (level >= SIMD_AVX512) return SRGBToLinear_AVX512;
+    if (level >= SIMD_AVX2) return SRGBToLinear_AVX2;
+    if (level >= SIMD_SSE42) return SRGBToLinear_SSE42;
+#endif
+    return SRGBToLinear_Scalar;
+}
+
+static ACESFilmKernel Get_ACESFilm_Kernel(SimdLevel level)
+{
+#if SIMD_X86
+    if (level >= SIMD_AVX512) return ACESFilm_AVX512;
+    if (level >= SIMD_AVX2) return ACESFilm_AVX2;
+#endif
+    return ACESFilm_Scalar;
+}
+
+/**
+* The reference mode is powf per value at every level, the other modes run the kernel.
+*/
+static void Run_LinearToSRGB(TransferKernel kernel, TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    if (mode == TRANSFER_REFERENCE)
+    {
+        for (uint32_t i = 0; i < count; i++) output[i] = LinearToSRGB(input[i]);
+        return;
+    }
+    kernel(mode, input, output, count);
+}
+
+static void Run_SRGBToLinear(TransferKernel kernel, TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    if (mode == TRANSFER_REFERENCE)
+    {
+        for (uint32_t i = 0; i < count; i++) output[i] = SRGBToLinear(input[i]);
+        return;
+    }
+    kernel(mode, input, output, count);
+}
+
+void LinearToSRGB(SimdLevel level, TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    Run_LinearToSRGB(Get_LinearToSRGB_Kernel(level), mode, input, output, count);
+}
+
+void LinearToSRGB(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    static const TransferKernel kernel = Get_LinearToSRGB_Kernel(Simd::Get_Level());
+    Run_LinearToSRGB(kernel, mode, input, output, count);
+}
+
+void SRGBToLinear(SimdLevel level, TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    Run_SRGBToLinear(Get_SRGBToLinear_Kernel(level), mode, input, output, count);
+}
+
+void SRGBToLinear(TransferMode mode, const float* input, float* output, uint32_t count)
+{
+    static const TransferKernel kernel = Get_SRGBToLinear_Kernel(Simd::Get_Level());
+    Run_SRGBToLinear(kernel, mode, input, output, count);
+}
+
+void ACESFilm(SimdLevel level, const float* input, float* output, uint32_t count)
+{
+    Get_ACESFilm_Kernel(level)(input, output, count, false);
+}
+
+void ACESFilm(const float* input, float* output, uint32_t count)
+{
+    static const ACESFilmKernel kernel = Get_ACESFilm_Kernel(Simd::Get_Level());
+    kernel(input, output, count, false);
+}
+
+void ACESFilm_RGBA(SimdLevel level, const float* input, float* output, uint32_t pixelCount)
+{
+    Get_ACESFilm_Kernel(level)(input, output, pixelCount * 4, true);
+}
+
+void ACESFilm_RGBA(const float* input, float* output, uint32_t pixelCount)
+{
+    static const ACESFilmKernel kernel = Get_ACESFilm_Kernel(Simd::Get_Level());
+    kernel(input, output, pixelCount * 4, true);
+}
+
+}
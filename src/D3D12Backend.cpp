@@ -0,0 +1,245 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Graphics.h"
+#include "Quantize.h"
+#include "Software.h"
+#include "UI.h"
+#include "Utils.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------
+// D3D12 Backend
+// Draws the fullscreen pass of ColorBanding.hlsl and the debug UI into a swap chain. The
+// dither pass runs with the graphics PSO, or with the compute shader in groups of
+// computeGroupSize, and the UI switches between them to compare their GPU time.
+//--------------------------------------------------------------------------------------
+
+class D3D12Backend : public RenderBackend
+{
+public:
+
+    D3D12Backend(HWND window, UINT computeGroupSize) : window(window), computeGroupSize(computeGroupSize) {}
+
+    const char* Get_Name() const override { return "D3D12"; }
+
+    void Init(const BackendConfig &config, const BandingConstants &constants) override
+    {
+        // Initialize command line settings
+        d3d.width = (int)config.width;
+        d3d.height = (int)config.height;
+        d3d.vsync = config.vsync;
+        d3d.backBufferFormat = config.backBufferFormat;
+        d3d.useCompute = (computeGroupSize > 0);
+        d3d.computeGroupSize = d3d.useCompute ? computeGroupSize : 8;
+        if (d3d.computeGroupSize != 8 && d3d.computeGroupSize != 16)
+        {
+            throw runtime_error("Error: the compute shader group size must be 8 or 16!");
+        }
+
+        // Initialize the dxc shader compiler
+        D3DShaders::Init_Shader_Compiler(shaderCompiler);
+
+        // Initialize D3D12
+        D3D12::Create_Device(d3d);
+        D3D12::Create_Command_Queue(d3d);
+        D3D12::Create_Command_Allocator(d3d);
+        D3D12::Create_CommandList(d3d);
+        D3D12::Create_Viewport(d3d);
+        D3D12::Create_Scissor(d3d);
+        D3D12::Create_SwapChain(d3d, window);
+        D3D12::Create_Fence(d3d);
+        D3D12::Reset_CommandList(d3d);
+
+        // Create common resources
+        BandingConstants initialConstants = constants;
+        D3DResources::Create_Descriptor_Heaps(d3d, resources);
+        D3DResources::Create_BackBuffer_RTV(d3d, resources);
+        D3DResources::Load_Shaders(d3d, resources, shaderCompiler);
+        D3DResources::Create_PSO(d3d, resources);
+        D3DResources::Create_Dither_Output(d3d, resources);
+        D3DResources::Create_Timestamp_Queries(d3d, resources);
+        D3DResources::Create_ConstantBuffer(d3d, resources, initialConstants);
+
+        // Initialize the UI
+        UI::Init(window, d3d, resources);
+    }
+
+    void Upload_Noise_Textures(NoiseTextures textures) override
+    {
+        // Record the uploads on the command list left open by Init()
+        D3DResources::Load_Blue_Noise_Texture_Array(d3d, resources, textures.blueNoiseArray);
+        D3DResources::Load_Blue_Noise_Texture(d3d, resources, textures.blueNoise);
+        D3DResources::Load_Spatiotemporal_Blue_Noise_Texture_Array(d3d, resources, textures.spatiotemporalArray);
+
+        d3d.cmdList->Close();
+        ID3D12CommandList* pGraphicsList = { d3d.cmdList };
+        d3d.cmdQueue->ExecuteCommandLists(1, &pGraphicsList);
+
+        D3D12::WaitForGPU(d3d);
+        D3D12::Reset_CommandList(d3d);
+    }
+
+    void Update_Constants(const BandingConstants &constants) override
+    {
+        memcpy(resources.bandingCBStart, &constants, sizeof(BandingConstants));
+    }
+
+    void Render(FrameState &state) override
+    {
+        // The UI can toggle vsync, and change the constants of the next frame
+        d3d.vsync = state.vsync;
+
+        D3D12::Build_CmdList(d3d, resources);
+        UI::Build_CmdList(d3d, resources, state.constants, state.animateLight);
+
+        D3D12::Submit_CmdList(d3d);
+        D3D12::WaitForGPU(d3d);
+        D3D12::Read_Pass_Time(d3d, resources);
+
+        state.vsync = d3d.vsync;
+    }
+
+    bool Readback(SoftwareFrame &frame) override
+    {
+        // The back buffer that was just rendered, with the UI, before Present() moves to the next one
+        ID3D12Resource* backBuffer = d3d.backBuffer[d3d.frameIndex];
+        D3D12_RESOURCE_DESC desc = backBuffer->GetDesc();
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+        UINT64 size = 0;
+        d3d.device->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, nullptr, nullptr, &size);
+
+        if (!readbackBuffer)
+        {
+            D3D12BufferCreateInfo info = D3D12BufferCreateInfo(size, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
+            D3DResources::Create_Buffer(d3d, info, &readbackBuffer);
+#if NAME_D3D_RESOURCES
+            readbackBuffer->SetName(L"Readback Buffer");
+#endif
+        }
+
+        // The command list was closed by Render(), and the GPU is idle
+        D3D12::Reset_CommandList(d3d);
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource = backBuffer;
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        d3d.cmdList->ResourceBarrier(1, &barrier);
+
+        D3D12_TEXTURE_COPY_LOCATION source = {};
+        source.pResource = backBuffer;
+        source.SubresourceIndex = 0;
+        source.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+
+        D3D12_TEXTURE_COPY_LOCATION destination = {};
+        destination.pResource = readbackBuffer;
+        destination.PlacedFootprint = footprint;
+        destination.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+
+        d3d.cmdList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+        d3d.cmdList->ResourceBarrier(1, &barrier);
+
+        D3D12::Submit_CmdList(d3d);
+        D3D12::WaitForGPU(d3d);
+
+        // Copy the rows out of the pitch aligned buffer
+        Software::Create_Frame(frame, (uint32_t)d3d.width, (uint32_t)d3d.height, Quantize::Get_Layout(d3d.backBufferFormat));
+
+        UINT8* pData;
+        D3D12_RANGE range = { 0, (SIZE_T)size };
+        HRESULT hr = readbackBuffer->Map(0, &range, reinterpret_cast<void**>(&pData));
+        Utils::Validate(hr, L"Error: failed to map the readback buffer!");
+
+        for (uint32_t y = 0; y < frame.height; y++)
+        {
+            memcpy(&frame.pixels[(size_t)y * frame.rowPitch], pData + footprint.Offset + (size_t)y * footprint.Footprint.RowPitch, (size_t)frame.width * frame.bytesPerPixel);
+        }
+
+        D3D12_RANGE written = { 0, 0 };
+        readbackBuffer->Unmap(0, &written);
+        return true;
+    }
+
+    void Present() override
+    {
+        D3D12::Present(d3d);
+        D3D12::MoveToNextFrame(d3d);
+        D3D12::Reset_CommandList(d3d);
+    }
+
+    void Destroy() override
+    {
+        D3D12::WaitForGPU(d3d);
+        CloseHandle(d3d.fenceEvent);
+
+        SAFE_RELEASE(readbackBuffer);
+        UI::Destroy();
+        D3DResources::Destroy(resources);
+        D3DShaders::Destroy(shaderCompiler);
+        D3D12::Destroy(d3d);
+    }
+
+    void Log(const char* message) override
+    {
+        OutputDebugStringA(message);
+    }
+
+private:
+
+    HWND window;
+    UINT computeGroupSize;
+    D3D12Global d3d = {};
+    D3D12Resources resources = {};
+    D3D12ShaderCompilerInfo shaderCompiler;
+    ID3D12Resource* readbackBuffer = nullptr;
+};
+
+//--------------------------------------------------------------------------------------
+// Public Functions
+//--------------------------------------------------------------------------------------
+
+namespace D3D12
+{
+
+/**
+* Create a backend that renders with D3D12 into a swap chain for the window. The dither pass
+* starts on the compute shader when computeGroupSize is 8 or 16, and on the graphics PSO when 0.
+*/
+unique_ptr<RenderBackend> Create_Backend(HWND window, UINT computeGroupSize)
+{
+    return unique_ptr<RenderBackend>(new D3D12Backend(window, computeGroupSize));
+}
+
+}
@@ -0,0 +1,382 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ErrorDiffusion.h"
+#include "Color.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace ErrorDiffusion
+{
+
+//--------------------------------------------------------------------------------------
+// Kernels
+//--------------------------------------------------------------------------------------
+
+static const int KERNEL_RADIUS = 2;
+static const int KERNEL_WIDTH = (KERNEL_RADIUS * 2) + 1;
+static const int KERNEL_ROWS = 3;
+
+/**
+* Weights for a left to right scan, indexed by [dy][dx + KERNEL_RADIUS]. The current
+* row only diffuses forward. Right to left scans mirror dx.
+*/
+struct Kernel
+{
+    const char* name;
+    int radius;
+    int rows;
+    float weights[KERNEL_ROWS][KERNEL_WIDTH];
+};
+
+static const Kernel kernels[DIFFUSION_COUNT] =
+{
+    { "Floyd-Steinberg", 1, 2,
+    {
+        { 0.f,        0.f,        0.f,        7.f / 16.f, 0.f        },
+        { 0.f,        3.f / 16.f, 5.f / 16.f, 1.f / 16.f, 0.f        },
+        { 0.f,        0.f,        0.f,        0.f,        0.f        },
+    } },
+    { "Jarvis", 2, 3,
+    {
+        { 0.f,        0.f,        0.f,        7.f / 48.f, 5.f / 48.f },
+        { 3.f / 48.f, 5.f / 48.f, 7.f / 48.f, 5.f / 48.f, 3.f / 48.f },
+        { 1.f / 48.f, 3.f / 48.f, 5.f / 48.f, 3.f / 48.f, 1.f / 48.f },
+    } },
+    { "Sierra", 2, 3,
+    {
+        { 0.f,        0.f,        0.f,        5.f / 32.f, 3.f / 32.f },
+        { 2.f / 32.f, 4.f / 32.f, 5.f / 32.f, 4.f / 32.f, 2.f / 32.f },
+        { 0.f,        2.f / 32.f, 3.f / 32.f, 2.f / 32.f, 0.f        },
+    } },
+};
+
+static const Kernel &Get_Kernel(DiffusionKernel kernel)
+{
+    if (kernel < 0 || kernel >= DIFFUSION_COUNT) throw runtime_error("Error: invalid error diffusion kernel!");
+    return kernels[kernel];
+}
+
+const char* Get_Kernel_Name(DiffusionKernel kernel)
+{
+    return Get_Kernel(kernel).name;
+}
+
+/**
+* Quantize one value to 8 bits and return the error to diffuse. The error is measured
+* from the saturated value, so clipped regions do not build up error, and NaN is 0.
+*/
+static inline float Quantize(float value, uint8_t &result)
+{
+    result = Color::FloatToUNORM8(value);
+    return Color::Saturate(value) - (float)result * (1.f / 255.f);
+}
+
+//--------------------------------------------------------------------------------------
+// Serial
+//--------------------------------------------------------------------------------------
+
+/**
+* The reference: every pixel scatters its error to its neighbors as soon as it is quantized.
+*/
+void Diffuse_Serial(const DiffusionSettings &settings, float* const planes[3], uint32_t width, uint32_t height, uint8_t* dest, size_t destPitch)
+{
+    const Kernel &kernel = Get_Kernel(settings.kernel);
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const int dir = (settings.serpentine && (y & 1)) ? -1 : 1;
+            float* row = &planes[c][(size_t)y * width];
+            uint8_t* out = &dest[y * destPitch];
+
+            for (uint32_t i = 0; i < width; i++)
+            {
+                const int x = (dir > 0) ? (int)i : (int)(width - 1 - i);
+                const float error = Quantize(row[x], out[x * 4 + c]);
+                if (c == 0) out[x * 4 + 3] = 0xFF;
+
+                for (int dy = 0; dy < kernel.rows && (y + dy) < height; dy++)
+                {
+                    float* target = &row[(size_t)dy * width];
+                    for (int dx = -kernel.radius; dx <= kernel.radius; dx++)
+                    {
+                        const float weight = kernel.weights[dy][dx + KERNEL_RADIUS];
+                        const int tx = x + (dir * dx);
+                        if (weight == 0.f || tx < 0 || tx >= (int)width) continue;
+                        target[tx] += error * weight;
+                    }
+                }
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Wavefront
+// Each row is quantized in chunks: the errors along the row are diffused as it goes,
+// and the errors into the rows below are kept until every source of a pixel below is
+// known. Those pixels are then updated in the order the serial scatter would have
+// added to them, which makes the gather vectorizable without changing the result.
+//--------------------------------------------------------------------------------------
+
+static const uint32_t CHUNK_SIZE = 64;
+
+/**
+* The taps of one kernel row, in the order their sources are scanned. Tap j reads the
+* error of the pixel at dir * (j - radius) from the target.
+*/
+struct GatherRow
+{
+    int offsets[KERNEL_WIDTH];
+    float weights[KERNEL_WIDTH];
+    int count;
+};
+
+static GatherRow Get_Gather_Row(const Kernel &kernel, int dy, int dir)
+{
+    GatherRow result = {};
+    for (int j = 0; j < KERNEL_WIDTH; j++)
+    {
+        const float weight = kernel.weights[dy][(KERNEL_WIDTH - 1) - j];
+        if (weight == 0.f) continue;
+        result.offsets[result.count] = dir * (j - KERNEL_RADIUS);
+        result.weights[result.count] = weight;
+        result.count++;
+    }
+    return result;
+}
+
+static void Gather_Scalar(const GatherRow &taps, const float* errors, float* target, int width, int begin, int end)
+{
+    for (int x = begin; x < end; x++)
+    {
+        float value = target[x];
+        for (int t = 0; t < taps.count; t++)
+        {
+            const int source = x + taps.offsets[t];
+            if (source < 0 || source >= width) continue;
+            value += errors[source] * taps.weights[t];
+        }
+        target[x] = value;
+    }
+}
+
+#if SIMD_X86
+SIMD_TARGET_AVX2 static int Gather_AVX2(const GatherRow &taps, const float* errors, float* target, int begin, int end)
+{
+    int x = begin;
+    for (; (x + 8) <= end; x += 8)
+    {
+        __m256 value = _mm256_loadu_ps(&target[x]);
+        for (int t = 0; t < taps.count; t++)
+        {
+            value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_loadu_ps(&errors[x + taps.offsets[t]]), _mm256_set1_ps(taps.weights[t])));
+        }
+        _mm256_storeu_ps(&target[x], value);
+    }
+    return x;
+}
+
+SIMD_AVX512_BEGIN
+SIMD_TARGET_AVX512 static int Gather_AVX512(const GatherRow &taps, const float* errors, float* target, int begin, int end)
+{
+    int x = begin;
+    for (; (x + 16) <= end; x += 16)
+    {
+        __m512 value = _mm512_loadu_ps(&target[x]);
+        for (int t = 0; t < taps.count; t++)
+        {
+            value = _mm512_add_ps(value, _mm512_mul_ps(_mm512_loadu_ps(&errors[x + taps.offsets[t]]), _mm512_set1_ps(taps.weights[t])));
+        }
+        _mm512_storeu_ps(&target[x], value);
+    }
+    return x;
+}
+SIMD_AVX512_END
+#endif
+
+/**
+* Add the errors of one row to pixels [begin, end) of a row below. Pixels within the
+* kernel radius of the edges skip the sources outside the image, so only the interior
+* is vectorized.
+*/
+static void Gather(SimdLevel level, const GatherRow &taps, const float* errors, float* target, int width, int begin, int end)
+{
+    const int interiorBegin = max(begin, KERNEL_RADIUS);
+    const int interiorEnd = min(end, width - KERNEL_RADIUS);
+    if (interiorBegin >= interiorEnd)
+    {
+        Gather_Scalar(taps, errors, target, width, begin, end);
+        return;
+    }
+
+    Gather_Scalar(taps, errors, target, width, begin, interiorBegin);
+    int x = interiorBegin;
+#if SIMD_X86
+    if (level >= SIMD_AVX512) x = Gather_AVX512(taps, errors, target, x, interiorEnd);
+    if (level >= SIMD_AVX2) x = Gather_AVX2(taps, errors, target, x, interiorEnd);
+#endif
+    Gather_Scalar(taps, errors, target, width, x, interiorEnd);
+    Gather_Scalar(taps, errors, target, width, interiorEnd, end);
+}
+
+struct Wavefront
+{
+    const Kernel* kernel;
+    SimdLevel level;
+    bool serpentine;
+    float* const* planes;
+    uint32_t width;
+    uint32_t height;
+    uint8_t* dest;
+    size_t destPitch;
+
+    // The number of pixels, from the left, of the rows below row y that have every error from row y
+    unique_ptr<atomic<uint32_t>[]> progress;
+};
+
+static void Wait(const atomic<uint32_t> &progress, uint32_t target)
+{
+    while (progress.load(memory_order_acquire) < target) this_thread::yield();
+}
+
+/**
+* Diffuse one row, all three channels at once: each channel is a serial chain, so
+* interleaving them hides the latency of quantizing. Waits on the row above, which was
+* claimed earlier since Parallel_For() hands out jobs in order.
+*/
+static void Diffuse_Row(const Wavefront &wf, uint32_t y, float* const errors[3])
+{
+    const Kernel &kernel = *wf.kernel;
+    const int width = (int)wf.width;
+    const int dir = (wf.serpentine && (y & 1)) ? -1 : 1;
+    const atomic<uint32_t>* above = (y > 0) ? &wf.progress[y - 1] : nullptr;
+    atomic<uint32_t> &progress = wf.progress[y];
+
+    float* rows[3];
+    for (uint32_t c = 0; c < 3; c++) rows[c] = &wf.planes[c][(size_t)y * width];
+    uint8_t* out = &wf.dest[y * wf.destPitch];
+
+    GatherRow taps[KERNEL_ROWS];
+    for (int dy = 1; dy < kernel.rows; dy++) taps[dy] = Get_Gather_Row(kernel, dy, dir);
+    const float forward[2] = { kernel.weights[0][KERNEL_RADIUS + 1], kernel.weights[0][KERNEL_RADIUS + 2] };
+
+    // A right to left row reads the pixels the row above finishes last, so it waits for all of them
+    if (above && dir < 0) Wait(*above, wf.width);
+
+    // The two pixels ahead are carried in registers, with the errors added in the same order
+    // as the serial scatter, so the loop does not wait on its own stores
+    int gathered = 0;
+    float ahead1[3] = {};
+    float ahead2[3] = {};
+    for (int done = 0; done < width;)
+    {
+        const int count = min((int)CHUNK_SIZE, width - done);
+
+        // The chunk reads the pixels past its end, that the row above may still be adding to
+        if (above && dir > 0) Wait(*above, (uint32_t)min(done + count + KERNEL_RADIUS, width));
+        if (done == 0)
+        {
+            const int first = (dir > 0) ? 0 : (width - 1);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                ahead1[c] = rows[c][first];
+                ahead2[c] = (width > 1) ? rows[c][first + dir] : 0.f;
+            }
+        }
+
+        for (int i = done; i < (done + count); i++)
+        {
+            const int x = (dir > 0) ? i : (width - 1 - i);
+            const int x2 = x + (2 * dir);
+            const bool inside = (x2 >= 0 && x2 < width);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                const float value = ahead1[c];
+                const float error = Quantize(value, out[x * 4 + c]);
+                rows[c][x] = value;
+                errors[c][x] = error;
+
+                // Zero weights are skipped like the serial scatter does, adding 0 can flip the sign of a zero
+                ahead1[c] = ahead2[c] + error * forward[0];
+                ahead2[c] = inside ? rows[c][x2] : 0.f;
+                if (forward[1] != 0.f) ahead2[c] += error * forward[1];
+            }
+            out[x * 4 + 3] = 0xFF;
+        }
+        done += count;
+
+        // Left to right, a pixel below has all of its sources once the scan is a radius past it.
+        // Right to left rows only publish once they are complete.
+        int ready = 0;
+        if (done == width) ready = width;
+        else if (dir > 0) ready = max(done - kernel.radius, 0);
+        if (ready <= gathered) continue;
+
+        for (int dy = 1; dy < kernel.rows && (y + dy) < wf.height; dy++)
+        {
+            for (uint32_t c = 0; c < 3; c++) Gather(wf.level, taps[dy], errors[c], &rows[c][(size_t)dy * width], width, gathered, ready);
+        }
+        gathered = ready;
+        progress.store((uint32_t)ready, memory_order_release);
+    }
+}
+
+/**
+* Diffuse the three planes across the thread pool, with the same result as Diffuse_Serial().
+*/
+void Diffuse(ThreadPool &pool, const DiffusionSettings &settings, float* const planes[3], uint32_t width, uint32_t height, uint8_t* dest, size_t destPitch)
+{
+    Wavefront wf;
+    wf.kernel = &Get_Kernel(settings.kernel);
+    wf.level = Simd::Get_Level();
+    wf.serpentine = settings.serpentine;
+    wf.planes = planes;
+    wf.width = width;
+    wf.height = height;
+    wf.dest = dest;
+    wf.destPitch = destPitch;
+    wf.progress.reset(new atomic<uint32_t>[height]);
+    for (uint32_t y = 0; y < height; y++) wf.progress[y].store(0, memory_order_relaxed);
+
+    // Jobs are rows in order, so a job only waits on jobs claimed before it
+    Threading::Parallel_For(pool, height, [&](uint32_t y)
+    {
+        vector<float> errors((size_t)width * 3);
+        float* const rows[3] = { &errors[0], &errors[width], &errors[(size_t)width * 2] };
+        Diffuse_Row(wf, y, rows);
+    });
+}
+
+}
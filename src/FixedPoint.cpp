@@ -0,0 +1,231 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FixedPoint.h"
+#include "Color.h"
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace FixedPoint
+{
+
+/**
+* Get the table from 16-bit linear values to 8-bit sRGB codes: the shader's LinearToSRGB(),
+* then rounded like a UNORM8 render target. Built on first use.
+*/
+const uint8_t* Get_Linear16_To_SRGB8_Table()
+{
+    static const vector<uint8_t> table = []()
+    {
+        vector<uint8_t> values(FIXED_POINT_ONE + 1);
+        for (uint32_t v = 0; v <= FIXED_POINT_ONE; v++)
+        {
+            values[v] = Color::FloatToUNORM8(Color::LinearToSRGB((float)v / (float)FIXED_POINT_ONE));
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+/**
+* Convert noise to 16-bit steps, rounded to nearest.
+*/
+static inline int32_t ToFixed(float noise)
+{
+    return (int32_t)lrintf(noise * (float)FIXED_POINT_ONE);
+}
+
+template<NoiseDistribution Distribution>
+static void Fill_Offsets(FixedPointNoise &noise)
+{
+    for (uint32_t k = 0; k < 256; k++)
+    {
+        float rnd;
+        if (noise.source.type == NOISE_WHITE)
+        {
+            // The center of the range of hashes with this top byte
+            rnd = ((float)k + 0.5f) / 256.f;
+        }
+        else
+        {
+            rnd = (float)k / 255.f;
+            if (noise.source.type == NOISE_LDS_BLUE)
+            {
+                rnd += noise.source.offset;
+                rnd -= floorf(rnd);
+            }
+        }
+        noise.offsets[k] = ToFixed(Noise::Finalize<Distribution>(rnd, noise.noiseScale));
+    }
+}
+
+/**
+* Look up the noise of a frame and convert it to 16-bit steps. Without dithering, the noise is 0.
+*/
+FixedPointNoise Create_Noise(const BandingConstants &constants, const NoiseTextures &textures)
+{
+    FixedPointNoise noise;
+    noise.distribution = Noise::GetDistribution(constants);
+    noise.noiseScale = constants.noiseScale;
+    noise.width = constants.resolutionX;
+    noise.frame = constants.frameNumber;
+    if (constants.useDithering <= 0) return noise;
+
+    if ((constants.noiseType == NOISE_BLUE && textures.blueNoiseArray.empty()) || (constants.noiseType == NOISE_LDS_BLUE && textures.blueNoise.width == 0) ||
+        (constants.noiseType == NOISE_SPATIOTEMPORAL_BLUE && textures.spatiotemporalArray.empty()))
+    {
+        throw runtime_error("Error: blue noise textures are not loaded!");
+    }
+
+    noise.source = Noise::GetNoiseSource(constants, textures);
+    if (noise.distribution == DISTRIBUTION_TRIANGULAR) Fill_Offsets<DISTRIBUTION_TRIANGULAR>(noise);
+    else Fill_Offsets<DISTRIBUTION_UNIFORM>(noise);
+    return noise;
+}
+
+/**
+* Dither a row of R16G16B16A16 linear color to R8G8B8A8 sRGB, with the noise type fixed at compile time.
+*/
+template<NoiseType Type>
+static void Dither_Row(const FixedPointNoise &noise, uint32_t x, uint32_t y, uint32_t count, const uint16_t* src, uint8_t* dest)
+{
+    const uint8_t* table = Get_Linear16_To_SRGB8_Table();
+
+    const uint8_t* texels = nullptr;
+    uint32_t textureWidth = 0;
+    uint32_t stride = 0;
+    if (Type == NOISE_BLUE || Type == NOISE_LDS_BLUE || Type == NOISE_SPATIOTEMPORAL_BLUE)
+    {
+        const TextureInfo &texture = *noise.source.texture;
+        texels = &texture.Get_Pixels()[(y % texture.height) * texture.width * texture.stride];
+        textureWidth = (uint32_t)texture.width;
+        stride = (uint32_t)texture.stride;
+    }
+
+    // Ordered dither thresholds are floats, so their row is converted here, like GetOrderedDitherRow()
+    int32_t ordered[BAYER_MAX_SIZE];
+    uint32_t mask = 0;
+    if (Type == NOISE_ORDERED)
+    {
+        assert(noise.source.size <= BAYER_MAX_SIZE);
+        mask = noise.source.size - 1;
+        const float* thresholds = &noise.source.thresholds[(y & mask) * noise.source.size];
+        for (uint32_t i = 0; i < noise.source.size; i++)
+        {
+            ordered[i] = (noise.distribution == DISTRIBUTION_TRIANGULAR) ? ToFixed(Noise::Finalize<DISTRIBUTION_TRIANGULAR>(thresholds[i], noise.noiseScale))
+                : ToFixed(Noise::Finalize<DISTRIBUTION_UNIFORM>(thresholds[i], noise.noiseScale));
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int32_t offsets[3] = { 0, 0, 0 };
+        if (Type == NOISE_WHITE)
+        {
+            // The same seed and hash sequence as GenerateRandomNumber(), keeping the top byte
+            uint32_t seed = ((y * noise.width) + (x + i)) * noise.frame;
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                seed = Noise::WangHash(seed);
+                offsets[c] = noise.offsets[Noise::Xorshift(seed) >> 24];
+            }
+        }
+        else if (Type == NOISE_BLUE || Type == NOISE_LDS_BLUE || Type == NOISE_SPATIOTEMPORAL_BLUE)
+        {
+            const uint8_t* texel = &texels[((x + i) % textureWidth) * stride];
+            for (uint32_t c = 0; c < 3; c++) offsets[c] = noise.offsets[texel[c]];
+        }
+        else if (Type == NOISE_ORDERED)
+        {
+            offsets[0] = offsets[1] = offsets[2] = ordered[(x + i) & mask];
+        }
+
+        const uint16_t* in = &src[i * 4];
+        uint8_t* out = &dest[i * 4];
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            int32_t value = (int32_t)in[c] + offsets[c];
+            value = (value < 0) ? 0 : ((value > (int32_t)FIXED_POINT_ONE) ? (int32_t)FIXED_POINT_ONE : value);
+            out[c] = table[value];
+        }
+
+        // Alpha is linear, rounded to nearest
+        out[3] = (uint8_t)(((uint32_t)in[3] * 255 + (FIXED_POINT_ONE / 2)) / FIXED_POINT_ONE);
+    }
+}
+
+typedef void (*DitherRowKernel)(const FixedPointNoise &noise, uint32_t x, uint32_t y, uint32_t count, const uint16_t* src, uint8_t* dest);
+
+static DitherRowKernel Get_Dither_Row_Kernel(NoiseType type)
+{
+    switch (type)
+    {
+        case NOISE_WHITE: return Dither_Row<NOISE_WHITE>;
+        case NOISE_BLUE: return Dither_Row<NOISE_BLUE>;
+        case NOISE_LDS_BLUE: return Dither_Row<NOISE_LDS_BLUE>;
+        case NOISE_SPATIOTEMPORAL_BLUE: return Dither_Row<NOISE_SPATIOTEMPORAL_BLUE>;
+        case NOISE_ORDERED: return Dither_Row<NOISE_ORDERED>;
+        default: return Dither_Row<NOISE_NONE>;
+    }
+}
+
+/**
+* Dither count pixels of R16G16B16A16 linear color, starting at pixel (x, y), to R8G8B8A8 sRGB.
+*/
+void Dither_Row(const FixedPointNoise &noise, uint32_t x, uint32_t y, uint32_t count, const uint16_t* src, uint8_t* dest)
+{
+    Get_Dither_Row_Kernel(noise.source.type)(noise, x, y, count, src, dest);
+}
+
+/**
+* Dither a frame of R16G16B16A16 linear color to an R8G8B8A8 frame of the same size, distributing rows across the thread pool.
+*/
+void Dither_Frame(ThreadPool &pool, const BandingConstants &constants, const NoiseTextures &textures, const PixelSpan &src, SoftwareFrame &frame)
+{
+    if (frame.bytesPerPixel != 4) throw runtime_error("Error: fixed point dithering writes R8G8B8A8 frames!");
+    if (frame.height > 0 && (src.rowPitch < (size_t)frame.width * 8 || src.size < (src.rowPitch * (frame.height - 1)) + ((size_t)frame.width * 8)))
+    {
+        throw runtime_error("Error: fixed point source is smaller than the frame!");
+    }
+
+    const FixedPointNoise noise = Create_Noise(constants, textures);
+    const DitherRowKernel kernel = Get_Dither_Row_Kernel(noise.source.type);
+    Get_Linear16_To_SRGB8_Table();
+
+    Threading::Parallel_For(pool, frame.height, [&](uint32_t y)
+    {
+        const uint16_t* in = (const uint16_t*)&src.data[(size_t)y * src.rowPitch];
+        kernel(noise, 0, y, frame.width, in, &frame.pixels[(size_t)y * frame.rowPitch]);
+    });
+}
+
+}
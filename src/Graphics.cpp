@@ -124,8 +124,10 @@ void Create_Descriptor_Heaps(D3D12Global &d3d, D3D12Resources &resources)
     // Describe the descriptor heap
     // 1 SRV for the blue noise texture
     // 1 SRV for the blue noise texture array
+    // 1 SRV for the spatiotemporal blue noise texture array
+    // 1 UAV for the compute shader's output
     D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-    desc.NumDescriptors = 2;
+    desc.NumDescriptors = 4;
     desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     
@@ -153,7 +155,63 @@ void Create_Descriptor_Heaps(D3D12Global &d3d, D3D12Resources &resources)
 }
 
 /**
- * Create the graphics PSO.
+* Create the compute PSO, which runs the dither pass as CS() and writes the UAV.
+*/
+static void Create_Compute_PSO(D3D12Global &d3d, D3D12Resources &resources)
+{
+    D3D12_SHADER_BYTECODE cs;
+    cs.BytecodeLength = resources.csBytecode->GetBufferSize();
+    cs.pShaderBytecode = resources.csBytecode->GetBufferPointer();
+
+    // Constant Buffer Root Parameter
+    D3D12_ROOT_PARAMETER param0 = {};
+    param0.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+    param0.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    param0.Descriptor.RegisterSpace = 0;
+    param0.Descriptor.ShaderRegister = 0;
+
+    // Describe the descriptor table, the three noise SRVs then the output UAV
+    D3D12_DESCRIPTOR_RANGE ranges[2];
+    ranges[0].BaseShaderRegister = 0;
+    ranges[0].NumDescriptors = 3;
+    ranges[0].RegisterSpace = 0;
+    ranges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    ranges[0].OffsetInDescriptorsFromTableStart = 0;
+
+    ranges[1].BaseShaderRegister = 0;
+    ranges[1].NumDescriptors = 1;
+    ranges[1].RegisterSpace = 0;
+    ranges[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+    ranges[1].OffsetInDescriptorsFromTableStart = 3;
+
+    D3D12_ROOT_PARAMETER param1 = {};
+    param1.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    param1.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    param1.DescriptorTable.NumDescriptorRanges = _countof(ranges);
+    param1.DescriptorTable.pDescriptorRanges = ranges;
+
+    D3D12_ROOT_PARAMETER rootParams[2] = { param0, param1 };
+
+    D3D12_ROOT_SIGNATURE_DESC rsDesc = {};
+    rsDesc.NumParameters = _countof(rootParams);
+    rsDesc.pParameters = rootParams;
+    rsDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+    resources.computeRS = D3D12::Create_Root_Signature(d3d, rsDesc);
+
+    // Describe and create the PSO
+    D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+    desc.pRootSignature = resources.computeRS;
+    desc.CS = cs;
+
+    HRESULT hr = d3d.device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&resources.computePSO));
+    Utils::Validate(hr, L"Error: failed to create the compute PSO!");
+#if NAME_D3D_RESOURCES
+    resources.computePSO->SetName(L"Compute PSO");
+#endif
+}
+
+/**
+ * Create the graphics PSO, and the compute PSO that d3d.useCompute selects instead of it.
  */
 void Create_PSO(D3D12Global &d3d, D3D12Resources &resources)
 {
@@ -197,7 +255,7 @@ void Create_PSO(D3D12Global &d3d, D3D12Resources &resources)
     // Describe the descriptor table
     D3D12_DESCRIPTOR_RANGE range;
     range.BaseShaderRegister = 0;
-    range.NumDescriptors = 2;
+    range.NumDescriptors = 3;
     range.RegisterSpace = 0;
     range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
     range.OffsetInDescriptorsFromTableStart = 0;
@@ -227,7 +285,7 @@ void Create_PSO(D3D12Global &d3d, D3D12Resources &resources)
     desc.SampleMask = UINT_MAX;
     desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
     desc.NumRenderTargets = 1;
-    desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.RTVFormats[0] = D3D12::Get_BackBuffer_Format(d3d);
     desc.SampleDesc.Count = 1;
 
     // Create the PSO
@@ -236,6 +294,63 @@ void Create_PSO(D3D12Global &d3d, D3D12Resources &resources)
 #if NAME_D3D_RESOURCES
     resources.pso->SetName(L"PSO");
 #endif
+
+    Create_Compute_PSO(d3d, resources);
+}
+
+/**
+* Create the texture the compute shader writes, in the back buffer format, with its UAV after the noise SRVs.
+*/
+void Create_Dither_Output(D3D12Global &d3d, D3D12Resources &resources)
+{
+    // Swap chain buffers can't be UAVs, so the output is copied to the back buffer
+    D3D12_RESOURCE_DESC textureDesc = {};
+    textureDesc.Width = d3d.width;
+    textureDesc.Height = d3d.height;
+    textureDesc.MipLevels = 1;
+    textureDesc.DepthOrArraySize = 1;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Format = D3D12::Get_BackBuffer_Format(d3d);
+    textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    HRESULT hr = d3d.device->CreateCommittedResource(&DefaultHeapProperties, D3D12_HEAP_FLAG_NONE, &textureDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&resources.ditherOutput));
+    Utils::Validate(hr, L"Error: failed to create the dither output texture!");
+#if NAME_D3D_RESOURCES
+    resources.ditherOutput->SetName(L"Dither Output");
+#endif
+
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = textureDesc.Format;
+    uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = resources.descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    handle.ptr += 3 * resources.cbvSrvUavDescSize;
+    d3d.device->CreateUnorderedAccessView(resources.ditherOutput, nullptr, &uavDesc, handle);
+}
+
+/**
+* Create the timestamp queries around the dither pass, and the buffer they are resolved to.
+* Each frame in flight has its own pair, so resolving one frame never overwrites another
+* frame's timestamps before they are read.
+*/
+void Create_Timestamp_Queries(D3D12Global &d3d, D3D12Resources &resources)
+{
+    D3D12_QUERY_HEAP_DESC desc = {};
+    desc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    desc.Count = 2 * (UINT)_countof(resources.timestampFences);
+
+    HRESULT hr = d3d.device->CreateQueryHeap(&desc, IID_PPV_ARGS(&resources.timestampHeap));
+    Utils::Validate(hr, L"Error: failed to create the timestamp query heap!");
+#if NAME_D3D_RESOURCES
+    resources.timestampHeap->SetName(L"Timestamp Query Heap");
+#endif
+
+    D3D12BufferCreateInfo info = D3D12BufferCreateInfo(desc.Count * sizeof(UINT64), D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
+    Create_Buffer(d3d, info, &resources.timestampReadback);
+#if NAME_D3D_RESOURCES
+    resources.timestampReadback->SetName(L"Timestamp Readback Buffer");
+#endif
 }
 
 /**
@@ -259,15 +374,42 @@ void Create_ConstantBuffer(D3D12Global &d3d, D3D12Resources &resources, BandingC
     memcpy(resources.bandingCBStart, &constants, sizeof(BandingConstants));
 }
 
+/**
+* Get the row pitch of a texture in an upload buffer.
+*/
+static UINT Get_Upload_Row_Pitch(const TextureInfo &texture)
+{
+    const UINT alignment = D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+    return ((texture.width * texture.stride) + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+* Get the size of a texture in an upload buffer, padded so the next texture is placed at a valid offset.
+*/
+static UINT Get_Upload_Size(const TextureInfo &texture)
+{
+    const UINT alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+    return ((Get_Upload_Row_Pitch(texture) * texture.height) + alignment - 1) & ~(alignment - 1);
+}
+
 /**
  * Copy a texture from the CPU to the GPU upload heap, then schedule a copy to the default heap.
+ * The textures are decoded (or mapped from the cache) before the device exists, so this copies
+ * their pixels rather than decoding into the upload heap with Utils::DecodeTexture().
  */
 void Upload_Texture(D3D12Global &d3d, ID3D12Resource* destResource, ID3D12Resource* srcResource, const TextureInfo &texture, UINT subresourceIndex)
 {
-    // Copy the pixel data to the upload heap resource
+    // Copy the pixel data to the upload heap resource, rows must be pitch aligned
+    const UINT rowPitch = Get_Upload_Row_Pitch(texture);
     UINT8* pData;
     HRESULT hr = srcResource->Map(0, nullptr, reinterpret_cast<void**>(&pData));
-    memcpy(pData + texture.offset, texture.pixels.data(), texture.width * texture.height * texture.stride);
+    Utils::Validate(hr, L"Error: failed to map texture upload buffer!");
+
+    PixelSpan dest;
+    dest.data = pData + texture.offset;
+    dest.size = rowPitch * texture.height;
+    dest.rowPitch = rowPitch;
+    Utils::CopyTexture(texture, dest);
     srcResource->Unmap(0, nullptr);
 
     // Describe the upload heap resource location for the copy
@@ -275,7 +417,7 @@ void Upload_Texture(D3D12Global &d3d, ID3D12Resource* destResource, ID3D12Resour
     subresource.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
     subresource.Width = texture.width;
     subresource.Height = texture.height;
-    subresource.RowPitch = (texture.width * texture.stride);
+    subresource.RowPitch = rowPitch;
     subresource.Depth = 1;
 
     D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
@@ -298,30 +440,41 @@ void Upload_Texture(D3D12Global &d3d, ID3D12Resource* destResource, ID3D12Resour
 }
 
 /**
-* Load a vertex and pixel shader.
+* Load a vertex and pixel shader, and the compute shader with the group size of d3d.
 */
-void Load_Shaders(D3D12Resources &resources, D3D12ShaderCompilerInfo &shaderCompiler)
+void Load_Shaders(D3D12Global &d3d, D3D12Resources &resources, D3D12ShaderCompilerInfo &shaderCompiler)
 {
     D3D12ShaderInfo vsInfo = D3D12ShaderInfo(L"shaders/ColorBanding.hlsl", L"VS", L"vs_6_0");
     D3DShaders::Compile_Shader(shaderCompiler, vsInfo, &resources.vsBytecode);
 
     D3D12ShaderInfo psInfo = D3D12ShaderInfo(L"shaders/ColorBanding.hlsl", L"PS", L"ps_6_0");
     D3DShaders::Compile_Shader(shaderCompiler, psInfo, &resources.psBytecode);
+
+    wstring groupSize = to_wstring(d3d.computeGroupSize);
+    DxcDefine define = { L"DITHER_GROUP_SIZE", groupSize.c_str() };
+
+    D3D12ShaderInfo csInfo = D3D12ShaderInfo(L"shaders/ColorBanding.hlsl", L"CS", L"cs_6_0");
+    csInfo.defines = &define;
+    csInfo.defineCount = 1;
+    D3DShaders::Compile_Shader(shaderCompiler, csInfo, &resources.csBytecode);
 }
 
 /**
-* Loads a set of blue noise textures from disk and uploads them to the GPU.
+* Upload a set of textures to the GPU as a texture array, with its SRV at descriptorIndex.
 */
-void Load_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources, UINT num)
+static void Load_Texture_Array(D3D12Global &d3d, D3D12Resources &resources, vector<TextureInfo> &textures, UINT descriptorIndex, ID3D12Resource* &texture, ID3D12Resource* &uploadResource, LPCWSTR name, LPCWSTR uploadName)
 {
-    TextureInfo* textures = new TextureInfo[num];
+    // Every slice has the same size, so each offset depends only on its index and the
+    // slices can be decoded in any order
+    const UINT num = (UINT)textures.size();
+    const UINT sliceSize = Get_Upload_Size(textures[0]);
     for (UINT i = 0; i < num; i++)
     {
-        string filepath = "data\\blue-noise\\LDR_RGB1_";
-        filepath.append(to_string(i));
-        filepath.append(".png");
-        textures[i] = Utils::LoadTexture(filepath);
-        if (i > 0) textures[i].offset = i * textures[i - 1].width * textures[i - 1].height * textures[i - 1].stride;
+        if (textures[i].width != textures[0].width || textures[i].height != textures[0].height || textures[i].stride != textures[0].stride)
+        {
+            throw runtime_error("Error: texture array slices must all be the same size!");
+        }
+        textures[i].offset = i * sliceSize;
     }
 
     // Describe the texture array
@@ -335,10 +488,10 @@ void Load_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources,
     textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 
     // Create the texture resource on the default heap
-    HRESULT hr = d3d.device->CreateCommittedResource(&DefaultHeapProperties, D3D12_HEAP_FLAG_NONE, &textureDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&resources.blueNoiseArray));
+    HRESULT hr = d3d.device->CreateCommittedResource(&DefaultHeapProperties, D3D12_HEAP_FLAG_NONE, &textureDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&texture));
     Utils::Validate(hr, L"Error: failed to create texture resource (default heap)!");
 #if NAME_D3D_RESOURCES
-    resources.blueNoiseArray->SetName(L"Blue Noise");
+    texture->SetName(name);
 #endif
 
     // Create the SRV on the descriptor heap
@@ -350,12 +503,12 @@ void Load_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources,
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 
     D3D12_CPU_DESCRIPTOR_HANDLE handle = resources.descriptorHeap->GetCPUDescriptorHandleForHeapStart();
-    handle.ptr += d3d.device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    d3d.device->CreateShaderResourceView(resources.blueNoiseArray, &srvDesc, handle);
+    handle.ptr += descriptorIndex * d3d.device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    d3d.device->CreateShaderResourceView(texture, &srvDesc, handle);
 
     // Describe the upload resource
     D3D12_RESOURCE_DESC resourceDesc = {};
-    resourceDesc.Width = (textures[0].width * textures[0].height * textures[0].stride) * num;
+    resourceDesc.Width = sliceSize * num;
     resourceDesc.Height = 1;
     resourceDesc.DepthOrArraySize = 1;
     resourceDesc.MipLevels = 1;
@@ -365,39 +518,50 @@ void Load_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources,
     resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
 
     // Create the buffer resource on the upload heap
-    hr = d3d.device->CreateCommittedResource(&UploadHeapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&resources.blueNoiseArrayUploadResource));
+    hr = d3d.device->CreateCommittedResource(&UploadHeapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&uploadResource));
     Utils::Validate(hr, L"Error: failed to create buffer resource (upload heap)!");
 #if NAME_D3D_RESOURCES
-    resources.blueNoiseArrayUploadResource->SetName(L"Blue Noise Array Upload Buffer");
+    uploadResource->SetName(uploadName);
 #endif
 
     // Upload the textures to the GPU
     for (UINT i = 0; i < num; i++)
     {
-        Upload_Texture(d3d, resources.blueNoiseArray, resources.blueNoiseArrayUploadResource, textures[i], i);
+        Upload_Texture(d3d, texture, uploadResource, textures[i], i);
     }
 
-    // Transition the texture to a shader resource
+    // Transition the texture to a shader resource, for the pixel or compute shader
     D3D12_RESOURCE_BARRIER barrier = {};
     barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Transition.pResource = resources.blueNoiseArray;
+    barrier.Transition.pResource = texture;
     barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
     barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
 
     d3d.cmdList->ResourceBarrier(1, &barrier);
+}
 
-    SAFE_DELETE_ARRAY(textures);
+/**
+* Uploads a set of blue noise textures (loaded from disk or generated) to the GPU as a texture array.
+*/
+void Load_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources, vector<TextureInfo> &textures)
+{
+    Load_Texture_Array(d3d, resources, textures, 1, resources.blueNoiseArray, resources.blueNoiseArrayUploadResource, L"Blue Noise", L"Blue Noise Array Upload Buffer");
 }
 
 /**
- * Load a blue noise texture from disk and uploads it to the GPU.
- */
-void Load_Blue_Noise_Texture(D3D12Global &d3d, D3D12Resources &resources)
+* Uploads the spatiotemporal blue noise slices to the GPU as a texture array.
+*/
+void Load_Spatiotemporal_Blue_Noise_Texture_Array(D3D12Global &d3d, D3D12Resources &resources, vector<TextureInfo> &textures)
 {
-    string filepath = "data\\blue-noise\\rgb-256.png";
-    TextureInfo texture = Utils::LoadTexture(filepath);
+    Load_Texture_Array(d3d, resources, textures, 2, resources.spatiotemporalBlueNoiseArray, resources.spatiotemporalBlueNoiseArrayUploadResource, L"Spatiotemporal Blue Noise", L"Spatiotemporal Blue Noise Array Upload Buffer");
+}
 
+/**
+ * Uploads a blue noise texture (loaded from disk or generated) to the GPU.
+ */
+void Load_Blue_Noise_Texture(D3D12Global &d3d, D3D12Resources &resources, const TextureInfo &texture)
+{
     // Describe the texture
     D3D12_RESOURCE_DESC textureDesc = {};
     textureDesc.Width = texture.width;
@@ -428,7 +592,7 @@ void Load_Blue_Noise_Texture(D3D12Global &d3d, D3D12Resources &resources)
 
     // Describe the upload resource
     D3D12_RESOURCE_DESC resourceDesc = {};
-    resourceDesc.Width = texture.width * texture.height * texture.stride;
+    resourceDesc.Width = Get_Upload_Size(texture);
     resourceDesc.Height = 1;
     resourceDesc.DepthOrArraySize = 1;
     resourceDesc.MipLevels = 1;
@@ -447,12 +611,12 @@ void Load_Blue_Noise_Texture(D3D12Global &d3d, D3D12Resources &resources)
     // Upload the texture to the GPU
     Upload_Texture(d3d, resources.blueNoise, resources.blueNoiseUploadResource, texture, 0);
 
-    // Transition the texture to a shader resource
+    // Transition the texture to a shader resource, for the pixel or compute shader
     D3D12_RESOURCE_BARRIER barrier = {};
     barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
     barrier.Transition.pResource = resources.blueNoise;
     barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
     barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
 
     d3d.cmdList->ResourceBarrier(1, &barrier);
@@ -470,13 +634,21 @@ void Destroy(D3D12Resources &resources)
     SAFE_RELEASE(resources.blueNoiseUploadResource);
     SAFE_RELEASE(resources.blueNoiseArray);
     SAFE_RELEASE(resources.blueNoiseArrayUploadResource);
+    SAFE_RELEASE(resources.spatiotemporalBlueNoiseArray);
+    SAFE_RELEASE(resources.spatiotemporalBlueNoiseArrayUploadResource);
     SAFE_RELEASE(resources.rtvHeap);
     SAFE_RELEASE(resources.descriptorHeap);
     SAFE_RELEASE(resources.uiDescriptorHeap);
     SAFE_RELEASE(resources.rs);
     SAFE_RELEASE(resources.pso);
+    SAFE_RELEASE(resources.computeRS);
+    SAFE_RELEASE(resources.computePSO);
+    SAFE_RELEASE(resources.ditherOutput);
+    SAFE_RELEASE(resources.timestampHeap);
+    SAFE_RELEASE(resources.timestampReadback);
     SAFE_RELEASE(resources.vsBytecode);
     SAFE_RELEASE(resources.psBytecode);
+    SAFE_RELEASE(resources.csBytecode);
 }
 
 }
@@ -718,6 +890,15 @@ void Create_Scissor(D3D12Global &d3d)
     d3d.scissor.bottom = d3d.height;
 }
 
+/**
+* Get the DXGI format of the back buffers. Flip model swap chains only support UNORM formats
+* with 8 or 10 bits per channel, so those are the only depths the application renders to.
+*/
+DXGI_FORMAT Get_BackBuffer_Format(const D3D12Global &d3d)
+{
+    return (d3d.backBufferFormat == PIXEL_FORMAT_RGB10A2) ? DXGI_FORMAT_R10G10B10A2_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+}
+
 /**
 * Create the swap chain.
 */
@@ -728,7 +909,7 @@ void Create_SwapChain(D3D12Global &d3d, HWND &window)
     desc.BufferCount = 2;
     desc.Width = d3d.width;
     desc.Height = d3d.height;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.Format = Get_BackBuffer_Format(d3d);
     desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
     desc.SampleDesc.Count = 1;
@@ -772,7 +953,7 @@ ID3D12RootSignature* Create_Root_Signature(D3D12Global &d3d, const D3D12_ROOT_SI
 /**
  * Run a fullscreen graphics pass.
  */
-void Build_CmdList(D3D12Global &d3d, D3D12Resources &resources)
+static void Build_Graphics_Pass(D3D12Global &d3d, D3D12Resources &resources)
 {
     // Transition the back buffer to a render target
     D3D12_RESOURCE_BARRIER barrier = {};
@@ -789,10 +970,6 @@ void Build_CmdList(D3D12Global &d3d, D3D12Resources &resources)
     rtvHandle.ptr += (resources.rtvDescSize * d3d.frameIndex);
     d3d.cmdList->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
 
-    // Set the descriptor heaps
-    ID3D12DescriptorHeap* ppHeaps[] = { resources.descriptorHeap };
-    d3d.cmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-
     // Set root signature, parameters, and pipeline state
     d3d.cmdList->SetGraphicsRootSignature(resources.rs);
     d3d.cmdList->SetGraphicsRootConstantBufferView(0, resources.bandingCB->GetGPUVirtualAddress());
@@ -815,6 +992,101 @@ void Build_CmdList(D3D12Global &d3d, D3D12Resources &resources)
     d3d.cmdList->ResourceBarrier(1, &barrier);
 }
 
+/**
+ * Run the dither pass as a compute shader, and copy its output to the back buffer.
+ */
+static void Build_Compute_Pass(D3D12Global &d3d, D3D12Resources &resources)
+{
+    // Set root signature, parameters, and pipeline state
+    d3d.cmdList->SetComputeRootSignature(resources.computeRS);
+    d3d.cmdList->SetComputeRootConstantBufferView(0, resources.bandingCB->GetGPUVirtualAddress());
+    d3d.cmdList->SetComputeRootDescriptorTable(1, resources.descriptorHeap->GetGPUDescriptorHandleForHeapStart());
+    d3d.cmdList->SetPipelineState(resources.computePSO);
+
+    // Dispatch a group for every tile, including partial tiles on the right and bottom edges
+    const UINT groupSize = d3d.computeGroupSize;
+    d3d.cmdList->Dispatch((d3d.width + groupSize - 1) / groupSize, (d3d.height + groupSize - 1) / groupSize, 1);
+
+    // Transition the output to a copy source, and the back buffer to a copy destination
+    D3D12_RESOURCE_BARRIER barriers[2] = {};
+    barriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barriers[0].Transition.pResource = resources.ditherOutput;
+    barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
+    barriers[0].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+    barriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barriers[1].Transition.pResource = d3d.backBuffer[d3d.frameIndex];
+    barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
+    barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
+    barriers[1].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+    d3d.cmdList->ResourceBarrier(2, barriers);
+    d3d.cmdList->CopyResource(d3d.backBuffer[d3d.frameIndex], resources.ditherOutput);
+
+    // Transition both back for the next frame
+    barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_SOURCE;
+    barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+    barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+    d3d.cmdList->ResourceBarrier(2, barriers);
+}
+
+/**
+ * Run the dither pass with the graphics or compute PSO, and time it on the GPU.
+ */
+void Build_CmdList(D3D12Global &d3d, D3D12Resources &resources)
+{
+    // Set the descriptor heaps
+    ID3D12DescriptorHeap* ppHeaps[] = { resources.descriptorHeap };
+    d3d.cmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+
+    // Time the pass into the current frame's pair of queries
+    const UINT query = 2 * d3d.frameIndex;
+    d3d.cmdList->EndQuery(resources.timestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, query);
+
+    if (d3d.useCompute) Build_Compute_Pass(d3d, resources);
+    else Build_Graphics_Pass(d3d, resources);
+
+    d3d.cmdList->EndQuery(resources.timestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, query + 1);
+    d3d.cmdList->ResolveQueryData(resources.timestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, query, 2, resources.timestampReadback, query * sizeof(UINT64));
+
+    // Submit_CmdList() signals the next fence value of this frame
+    resources.timestampFences[d3d.frameIndex] = d3d.fenceValues[d3d.frameIndex] + 1;
+}
+
+/**
+ * Read the timestamps of the dither pass of every frame whose fence has completed, and update
+ * the average pass time.
+ */
+void Read_Pass_Time(D3D12Global &d3d, D3D12Resources &resources)
+{
+    UINT64 frequency = 0;
+    HRESULT hr = d3d.cmdQueue->GetTimestampFrequency(&frequency);
+    Utils::Validate(hr, L"Error: failed to get the timestamp frequency!");
+
+    const UINT64 completed = d3d.fence->GetCompletedValue();
+    for (UINT frame = 0; frame < _countof(resources.timestampFences); frame++)
+    {
+        if (resources.timestampFences[frame] == 0 || resources.timestampFences[frame] > completed) continue;
+        resources.timestampFences[frame] = 0;
+
+        UINT64* timestamps;
+        D3D12_RANGE range = { 2 * frame * sizeof(UINT64), 2 * (frame + 1) * sizeof(UINT64) };
+        hr = resources.timestampReadback->Map(0, &range, reinterpret_cast<void**>(&timestamps));
+        Utils::Validate(hr, L"Error: failed to map the timestamp readback buffer!");
+
+        const UINT64 ticks = timestamps[2 * frame + 1] - timestamps[2 * frame];
+
+        D3D12_RANGE written = { 0, 0 };
+        resources.timestampReadback->Unmap(0, &written);
+
+        // Average over frames so the value is readable in the UI
+        const float milliseconds = (float)((double)ticks * 1000.0 / (double)frequency);
+        d3d.passTime = (d3d.passTime > 0.f) ? (0.95f * d3d.passTime + 0.05f * milliseconds) : milliseconds;
+    }
+}
+
 /**
 * Reset the command list.
 */
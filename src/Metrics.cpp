@@ -0,0 +1,334 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Metrics.h"
+#include "Quantize.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Metrics
+{
+
+static const uint32_t ROW_BAND_SIZE = 16;
+static const uint32_t WINDOW_PIXELS = METRICS_WINDOW_SIZE * METRICS_WINDOW_SIZE;
+
+static const float LUMA_R = 0.2126f;
+static const float LUMA_G = 0.7152f;
+static const float LUMA_B = 0.0722f;
+
+// SSIM constants for a dynamic range of 1
+static const double SSIM_C1 = (0.01 * 0.01);
+static const double SSIM_C2 = (0.03 * 0.03);
+
+/**
+* Sums over one window, of values relative to an offset so the variances don't cancel out.
+*/
+struct WindowSums
+{
+    float x = 0.f;      // reference
+    float y = 0.f;      // test
+    float xx = 0.f;
+    float yy = 0.f;
+    float xy = 0.f;
+};
+
+struct WindowRowResult
+{
+    double ssim = 0.0;
+    double banding = 0.0;       // sum of squared mean errors over the smooth windows
+    uint32_t smoothWindows = 0;
+};
+
+//--------------------------------------------------------------------------------------
+// Row Kernels
+// Sum the squared error of a row of RGB and compute the luma of both rows.
+//--------------------------------------------------------------------------------------
+
+static double Row_Pass_Scalar(const float* const reference[3], const float* const test[3], uint32_t count, float* referenceLuma, float* testLuma)
+{
+    double sum = 0.0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            const float difference = test[c][i] - reference[c][i];
+            sum += (double)(difference * difference);
+        }
+        referenceLuma[i] = (LUMA_R * reference[0][i]) + (LUMA_G * reference[1][i]) + (LUMA_B * reference[2][i]);
+        testLuma[i] = (LUMA_R * test[0][i]) + (LUMA_G * test[1][i]) + (LUMA_B * test[2][i]);
+    }
+    return sum;
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_AVX2 static inline float Sum_AVX2(__m256 x)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+SIMD_TARGET_AVX2 static inline __m256 Luma_AVX2(const float* const planes[3], uint32_t i)
+{
+    const __m256 r = _mm256_mul_ps(_mm256_loadu_ps(planes[0] + i), _mm256_set1_ps(LUMA_R));
+    const __m256 g = _mm256_mul_ps(_mm256_loadu_ps(planes[1] + i), _mm256_set1_ps(LUMA_G));
+    const __m256 b = _mm256_mul_ps(_mm256_loadu_ps(planes[2] + i), _mm256_set1_ps(LUMA_B));
+    return _mm256_add_ps(_mm256_add_ps(r, g), b);
+}
+
+SIMD_TARGET_AVX2 static double Row_Pass_AVX2(const float* const reference[3], const float* const test[3], uint32_t count, float* referenceLuma, float* testLuma)
+{
+    __m256 sum = _mm256_setzero_ps();
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
+    {
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            const __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(test[c] + i), _mm256_loadu_ps(reference[c] + i));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(difference, difference));
+        }
+        _mm256_storeu_ps(referenceLuma + i, Luma_AVX2(reference, i));
+        _mm256_storeu_ps(testLuma + i, Luma_AVX2(test, i));
+    }
+
+    const float* const referenceTail[3] = { reference[0] + i, reference[1] + i, reference[2] + i };
+    const float* const testTail[3] = { test[0] + i, test[1] + i, test[2] + i };
+    return (double)Sum_AVX2(sum) + Row_Pass_Scalar(referenceTail, testTail, count - i, referenceLuma + i, testLuma + i);
+}
+
+#endif
+
+//--------------------------------------------------------------------------------------
+// Window Kernels
+// Sum an 8x8 window of reference and test luma, relative to offset.
+//--------------------------------------------------------------------------------------
+
+static WindowSums Window_Sums_Scalar(const float* reference, const float* test, uint32_t pitch, float offset)
+{
+    WindowSums sums;
+    for (uint32_t row = 0; row < METRICS_WINDOW_SIZE; row++)
+    {
+        for (uint32_t i = 0; i < METRICS_WINDOW_SIZE; i++)
+        {
+            const float x = reference[row * pitch + i] - offset;
+            const float y = test[row * pitch + i] - offset;
+            sums.x += x;
+            sums.y += y;
+            sums.xx += x * x;
+            sums.yy += y * y;
+            sums.xy += x * y;
+        }
+    }
+    return sums;
+}
+
+#if SIMD_X86
+
+/**
+* One row of the window is one AVX2 register.
+*/
+SIMD_TARGET_AVX2 static WindowSums Window_Sums_AVX2(const float* reference, const float* test, uint32_t pitch, float offset)
+{
+    const __m256 vOffset = _mm256_set1_ps(offset);
+    __m256 sx = _mm256_setzero_ps();
+    __m256 sy = _mm256_setzero_ps();
+    __m256 sxx = _mm256_setzero_ps();
+    __m256 syy = _mm256_setzero_ps();
+    __m256 sxy = _mm256_setzero_ps();
+
+    for (uint32_t row = 0; row < METRICS_WINDOW_SIZE; row++)
+    {
+        const __m256 x = _mm256_sub_ps(_mm256_loadu_ps(reference + row * pitch), vOffset);
+        const __m256 y = _mm256_sub_ps(_mm256_loadu_ps(test + row * pitch), vOffset);
+        sx = _mm256_add_ps(sx, x);
+        sy = _mm256_add_ps(sy, y);
+        sxx = _mm256_add_ps(sxx, _mm256_mul_ps(x, x));
+        syy = _mm256_add_ps(syy, _mm256_mul_ps(y, y));
+        sxy = _mm256_add_ps(sxy, _mm256_mul_ps(x, y));
+    }
+
+    WindowSums sums;
+    sums.x = Sum_AVX2(sx);
+    sums.y = Sum_AVX2(sy);
+    sums.xx = Sum_AVX2(sxx);
+    sums.yy = Sum_AVX2(syy);
+    sums.xy = Sum_AVX2(sxy);
+    return sums;
+}
+
+#endif
+
+/**
+* Compute SSIM and the banding contribution of every window in a row of windows.
+*/
+static WindowRowResult Window_Row(SimdLevel level, const vector<float> &referenceLuma, const vector<float> &testLuma, uint32_t width, uint32_t windowsX, uint32_t windowY, double maxCode)
+{
+    WindowRowResult result;
+    const size_t rowOffset = (size_t)windowY * METRICS_WINDOW_STRIDE * width;
+
+    for (uint32_t windowX = 0; windowX < windowsX; windowX++)
+    {
+        const size_t offset = rowOffset + (size_t)windowX * METRICS_WINDOW_STRIDE;
+        const float* reference = &referenceLuma[offset];
+        const float* test = &testLuma[offset];
+
+        // Center the values on the first reference value, so small variances survive in float
+        const float center = reference[0];
+
+        WindowSums sums;
+#if SIMD_X86
+        if (level >= SIMD_AVX2) sums = Window_Sums_AVX2(reference, test, width, center);
+        else
+#endif
+        sums = Window_Sums_Scalar(reference, test, width, center);
+
+        const double n = (double)WINDOW_PIXELS;
+        const double meanX = (double)sums.x / n;
+        const double meanY = (double)sums.y / n;
+        const double varianceX = max(((double)sums.xx / n) - (meanX * meanX), 0.0);
+        const double varianceY = max(((double)sums.yy / n) - (meanY * meanY), 0.0);
+        const double covariance = ((double)sums.xy / n) - (meanX * meanY);
+
+        // SSIM is not shift invariant, so the means include the center again
+        const double muX = meanX + center;
+        const double muY = meanY + center;
+        result.ssim += ((2.0 * muX * muY + SSIM_C1) * (2.0 * covariance + SSIM_C2)) /
+                       (((muX * muX) + (muY * muY) + SSIM_C1) * (varianceX + varianceY + SSIM_C2));
+
+        if ((sqrt(varianceX) * maxCode) < (double)METRICS_SMOOTH_THRESHOLD)
+        {
+            const double meanError = (meanY - meanX) * maxCode;
+            result.banding += meanError * meanError;
+            result.smoothWindows++;
+        }
+    }
+    return result;
+}
+
+//--------------------------------------------------------------------------------------
+// Public Functions
+//--------------------------------------------------------------------------------------
+
+/**
+* Compare a quantized frame, packed with layout, against its float reference with the given instruction set.
+*/
+QualityMetrics Compare(ThreadPool &pool, SimdLevel level, const ReferenceFrame &reference, const SoftwareFrame &frame, const PixelLayout &layout)
+{
+    if (reference.width != frame.width || reference.height != frame.height) throw runtime_error("Error: reference and frame sizes do not match!");
+    if (frame.bytesPerPixel != layout.bytesPerPixel) throw runtime_error("Error: frame was not created for the pixel layout!");
+
+    auto start = chrono::high_resolution_clock::now();
+
+    const uint32_t width = frame.width;
+    const uint32_t height = frame.height;
+    const double maxCode = (double)((1u << Quantize::Get_Color_Bits(layout)) - 1);
+
+    // Unpack the frame, sum the squared error, and convert both frames to luma
+    vector<float> referenceLuma((size_t)width * height);
+    vector<float> testLuma((size_t)width * height);
+
+    const uint32_t numBands = (height + ROW_BAND_SIZE - 1) / ROW_BAND_SIZE;
+    vector<double> bandErrors(numBands, 0.0);
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        vector<float> r(width), g(width), b(width);
+        const float* const test[3] = { r.data(), g.data(), b.data() };
+
+        const uint32_t end = min(height, (band + 1) * ROW_BAND_SIZE);
+        for (uint32_t y = band * ROW_BAND_SIZE; y < end; y++)
+        {
+            const size_t offset = (size_t)y * width;
+            const float* const referenceRow[3] = { &reference.planes[0][offset], &reference.planes[1][offset], &reference.planes[2][offset] };
+
+            Quantize::Unpack_Row(level, layout, &frame.pixels[(size_t)y * frame.rowPitch], width, r.data(), g.data(), b.data(), nullptr);
+#if SIMD_X86
+            if (level >= SIMD_AVX2)
+            {
+                bandErrors[band] += Row_Pass_AVX2(referenceRow, test, width, &referenceLuma[offset], &testLuma[offset]);
+                continue;
+            }
+#endif
+            bandErrors[band] += Row_Pass_Scalar(referenceRow, test, width, &referenceLuma[offset], &testLuma[offset]);
+        }
+    });
+
+    // Compare the luma over windows
+    const uint32_t windowsX = (width >= METRICS_WINDOW_SIZE) ? ((width - METRICS_WINDOW_SIZE) / METRICS_WINDOW_STRIDE) + 1 : 0;
+    const uint32_t windowsY = (height >= METRICS_WINDOW_SIZE) ? ((height - METRICS_WINDOW_SIZE) / METRICS_WINDOW_STRIDE) + 1 : 0;
+
+    vector<WindowRowResult> windowRows(windowsY);
+    Threading::Parallel_For(pool, windowsY, [&](uint32_t windowY)
+    {
+        windowRows[windowY] = Window_Row(level, referenceLuma, testLuma, width, windowsX, windowY, maxCode);
+    });
+
+    // Combine the partial sums in order
+    double error = 0.0;
+    for (double bandError : bandErrors) error += bandError;
+
+    WindowRowResult total;
+    for (const WindowRowResult &row : windowRows)
+    {
+        total.ssim += row.ssim;
+        total.banding += row.banding;
+        total.smoothWindows += row.smoothWindows;
+    }
+
+    QualityMetrics metrics;
+    const double mse = error / (3.0 * width * height);
+    metrics.psnr = (mse > 0.0) ? (10.0 * log10(1.0 / mse)) : numeric_limits<double>::infinity();
+
+    const double numWindows = (double)windowsX * windowsY;
+    if (numWindows > 0.0)
+    {
+        metrics.ssim = total.ssim / numWindows;
+        metrics.smoothFraction = total.smoothWindows / numWindows;
+    }
+    if (total.smoothWindows > 0) metrics.banding = sqrt(total.banding / total.smoothWindows);
+
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    metrics.milliseconds = elapsed.count();
+    return metrics;
+}
+
+/**
+* Compare a quantized frame, packed with layout, against its float reference.
+*/
+QualityMetrics Compare(ThreadPool &pool, const ReferenceFrame &reference, const SoftwareFrame &frame, const PixelLayout &layout)
+{
+    return Compare(pool, Simd::Get_Level(), reference, frame, layout);
+}
+
+}
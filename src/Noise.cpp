@@ -0,0 +1,420 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Noise.h"
+
+namespace Noise
+{
+
+static constexpr BayerMatrix<2> bayer2;
+static constexpr BayerMatrix<4> bayer4;
+static constexpr BayerMatrix<8> bayer8;
+static constexpr BayerMatrix<16> bayer16;
+static constexpr BayerMatrix<32> bayer32;
+static constexpr BayerMatrix<64> bayer64;
+
+static_assert(bayer4(1, 1) == (4.5f / 16.f) && bayer4(5, 1) == bayer4(1, 1), "Bayer matrices must wrap with a power of two mask");
+
+/**
+* Get the thresholds of a Bayer matrix, or nullptr when size is not a power of two from 2 to 64.
+*/
+const float* GetBayerMatrix(uint32_t size)
+{
+    switch (size)
+    {
+        case 2: return bayer2.thresholds;
+        case 4: return bayer4.thresholds;
+        case 8: return bayer8.thresholds;
+        case 16: return bayer16.thresholds;
+        case 32: return bayer32.thresholds;
+        case 64: return bayer64.thresholds;
+        default: return nullptr;
+    }
+}
+
+/**
+* Look up the noise of a frame: the texture slice, threshold matrix, or LDS offset it reads.
+* The type is NOISE_NONE when the noise type is unknown or its matrix is missing or too large.
+*/
+static NoiseSource GetNoiseSource(NoiseType type, const BandingConstants &constants, const NoiseTextures &textures)
+{
+    static const float goldenRatioConjugate = 0.61803398875f;
+
+    NoiseSource source;
+    source.type = type;
+    if (type == NOISE_BLUE)
+    {
+        source.texture = &textures.blueNoiseArray[constants.frameNumber % textures.blueNoiseArray.size()];
+    }
+    else if (type == NOISE_LDS_BLUE)
+    {
+        source.texture = &textures.blueNoise;
+        source.offset = goldenRatioConjugate * (float)((constants.frameNumber - 1) % 16);
+    }
+    else if (type == NOISE_SPATIOTEMPORAL_BLUE)
+    {
+        source.texture = &textures.spatiotemporalArray[constants.frameNumber % textures.spatiotemporalArray.size()];
+    }
+    else if (type == NOISE_ORDERED && !textures.thresholdMatrix.thresholds.empty())
+    {
+        const uint32_t size = textures.thresholdMatrix.size;
+        if (size < BAYER_MIN_SIZE || size > BAYER_MAX_SIZE || (size & (size - 1)) != 0 || textures.thresholdMatrix.thresholds.size() != (size_t)size * size)
+        {
+            source.type = NOISE_NONE;
+            return source;
+        }
+
+        source.thresholds = textures.thresholdMatrix.thresholds.data();
+        source.size = textures.thresholdMatrix.size;
+    }
+    else if (type == NOISE_ORDERED && GetBayerMatrix(constants.ditherMatrixSize))
+    {
+        source.thresholds = GetBayerMatrix(constants.ditherMatrixSize);
+        source.size = constants.ditherMatrixSize;
+    }
+    else if (type != NOISE_WHITE)
+    {
+        source.type = NOISE_NONE;
+    }
+    return source;
+}
+
+/**
+* Look up the noise selected by constants.noiseType.
+*/
+NoiseSource GetNoiseSource(const BandingConstants &constants, const NoiseTextures &textures)
+{
+    const NoiseType type = (constants.noiseType >= 0 && constants.noiseType < NOISE_NONE) ? (NoiseType)constants.noiseType : NOISE_NONE;
+    return GetNoiseSource(type, constants, textures);
+}
+
+/**
+* Get the distribution selected by constants.distributionType. Anything but triangular is uniform, as in the shader.
+*/
+NoiseDistribution GetDistribution(const BandingConstants &constants)
+{
+    return (constants.distributionType == 1) ? DISTRIBUTION_TRIANGULAR : DISTRIBUTION_UNIFORM;
+}
+
+/**
+* Generate a row of noise of a fixed type, with the distribution selected by the constants.
+*/
+template<NoiseType Type>
+static void GetNoiseRowOfType(const BandingConstants &constants, const NoiseSource &source, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+{
+    if (GetDistribution(constants) == DISTRIBUTION_TRIANGULAR) GetNoiseRow<Type, DISTRIBUTION_TRIANGULAR>(constants, source, x, y, count, r, g, b);
+    else GetNoiseRow<Type, DISTRIBUTION_UNIFORM>(constants, source, x, y, count, r, g, b);
+}
+
+/**
+* Generate a row of white noise in image-space.
+*/
+void GetWhiteNoiseRow(const BandingConstants &constants, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+{
+    GetNoiseRowOfType<NOISE_WHITE>(constants, NoiseSource(), x, y, count, r, g, b);
+}
+
+/**
+* Generate a row of blue noise in image-space, using the frame number to select the texture array slice.
+*/
+void GetBlueNoiseRow(const BandingConstants &constants, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+{
+    GetNoiseRowOfType<NOISE_BLUE>(constants, GetNoiseSource(NOISE_BLUE, constants, textures), x, y, count, r, g, b);
+}
+
+/**
+* Generate a row of spatiotemporal blue noise in image-space. Slices are consecutive
+* frames, so averaging over frames converges faster than with independent slices.
+*/
+void GetSpatiotemporalBlueNoiseRow(const BandingConstants &constants, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+{
+    GetNoiseRowOfType<NOISE_SPATIOTEMPORAL_BLUE>(constants, GetNoiseSource(NOISE_SPATIOTEMPORAL_BLUE, constants, textures), x, y, count, r, g, b);
+}
+
+/**
+* Generate a row of low discrepancy blue noise in image-space.
+*/
+void GetLDSBlueNoiseRow(const BandingConstants &constants, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+{
+    GetNoiseRowOfType<NOISE_LDS_BLUE>(constants, GetNoiseSource(NOISE_LDS_BLUE, constants, textures), x, y, count, r, g, b);
+}
+
+/**
+* Generate a row of ordered dither noise in image-space from a power of two threshold matrix.
+*/
+void GetOrderedDitherRow(const BandingConstants &constants, const float* thresholds, uint32_t size, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+{
+    NoiseSource source;
+    source.type = NOISE_ORDERED;
+    source.thresholds = thresholds;
+    source.size = size;
+    GetNoiseRowOfType<NOISE_ORDERED>(constants, source, x, y, count, r, g, b);
+}
+
+/**
+* Generate a row of the noise selected by constants.noiseType.
+*/
+void GetNoiseRow(const BandingConstants &constants, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+{
+    const NoiseSource source = GetNoiseSource(constants, textures);
+    switch (source.type)
+    {
+        case NOISE_WHITE: GetNoiseRowOfType<NOISE_WHITE>(constants, source, x, y, count, r, g, b); break;
+        case NOISE_BLUE: GetNoiseRowOfType<NOISE_BLUE>(constants, source, x, y, count, r, g, b); break;
+        case NOISE_LDS_BLUE: GetNoiseRowOfType<NOISE_LDS_BLUE>(constants, source, x, y, count, r, g, b); break;
+        case NOISE_SPATIOTEMPORAL_BLUE: GetNoiseRowOfType<NOISE_SPATIOTEMPORAL_BLUE>(constants, source, x, y, count, r, g, b); break;
+        case NOISE_ORDERED: GetNoiseRowOfType<NOISE_ORDERED>(constants, source, x, y, count, r, g, b); break;
+        default: GetNoiseRowOfType<NOISE_NONE>(constants, source, x, y, count, r, g, b); break;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// White Noise Batch Kernels
+//--------------------------------------------------------------------------------------
+
+/**
+* Scalar white noise, seeded per pixel the same way as GetWhiteNoise() in ColorBanding.hlsl.
+*/
+static void GenerateWhiteNoiseRow_Scalar(uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t seed = ((y * width) + (x + i)) * frame;
+        r[i] = GenerateRandomNumber(seed);
+        g[i] = GenerateRandomNumber(seed);
+        b[i] = GenerateRandomNumber(seed);
+    }
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_SSE42 static inline __m128i WangHash_SSE42(__m128i seed)
+{
+    seed = _mm_xor_si128(_mm_xor_si128(seed, _mm_set1_epi32(61)), _mm_srli_epi32(seed, 16));
+    seed = _mm_add_epi32(seed, _mm_slli_epi32(seed, 3));                            // seed *= 9
+    seed = _mm_xor_si128(seed, _mm_srli_epi32(seed, 4));
+    seed = _mm_mullo_epi32(seed, _mm_set1_epi32(0x27d4eb2d));
+    seed = _mm_xor_si128(seed, _mm_srli_epi32(seed, 15));
+    return seed;
+}
+
+SIMD_TARGET_SSE42 static inline __m128i Xorshift_SSE42(__m128i seed)
+{
+    seed = _mm_xor_si128(seed, _mm_slli_epi32(seed, 13));
+    seed = _mm_xor_si128(seed, _mm_srli_epi32(seed, 17));
+    seed = _mm_xor_si128(seed, _mm_slli_epi32(seed, 5));
+    return seed;
+}
+
+/**
+* Convert unsigned 32-bit integers to float the same way as UintToFloat_AVX2().
+*/
+SIMD_TARGET_SSE42 static inline __m128 UintToFloat_SSE42(__m128i value)
+{
+    const __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(value, 16)), _mm_set1_ps(65536.f));
+    const __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(value, _mm_set1_epi32(0xFFFF)));
+    return _mm_add_ps(hi, lo);
+}
+
+SIMD_TARGET_SSE42 static inline __m128 GenerateRandomNumber_SSE42(__m128i &seed)
+{
+    seed = WangHash_SSE42(seed);
+    return _mm_mul_ps(UintToFloat_SSE42(Xorshift_SSE42(seed)), _mm_set1_ps(1.f / 4294967296.f));
+}
+
+/**
+* SSE4.2 white noise, 4 pixels at a time.
+*/
+SIMD_TARGET_SSE42 static void GenerateWhiteNoiseRow_SSE42(uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b)
+{
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i vframe = _mm_set1_epi32((int)frame);
+
+    uint32_t i = 0;
+    for (; (i + 4) <= count; i += 4)
+    {
+        const __m128i index = _mm_add_epi32(_mm_set1_epi32((int)((y * width) + (x + i))), lanes);
+        __m128i seed = _mm_mullo_epi32(index, vframe);
+
+        _mm_storeu_ps(r + i, GenerateRandomNumber_SSE42(seed));
+        _mm_storeu_ps(g + i, GenerateRandomNumber_SSE42(seed));
+        _mm_storeu_ps(b + i, GenerateRandomNumber_SSE42(seed));
+    }
+
+    GenerateWhiteNoiseRow_Scalar(x + i, y, count - i, width, frame, r + i, g + i, b + i);
+}
+
+SIMD_TARGET_AVX2 static inline __m256i WangHash_AVX2(__m256i seed)
+{
+    seed = _mm256_xor_si256(_mm256_xor_si256(seed, _mm256_set1_epi32(61)), _mm256_srli_epi32(seed, 16));
+    seed = _mm256_add_epi32(seed, _mm256_slli_epi32(seed, 3));                      // seed *= 9
+    seed = _mm256_xor_si256(seed, _mm256_srli_epi32(seed, 4));
+    seed = _mm256_mullo_epi32(seed, _mm256_set1_epi32(0x27d4eb2d));
+    seed = _mm256_xor_si256(seed, _mm256_srli_epi32(seed, 15));
+    return seed;
+}
+
+SIMD_TARGET_AVX2 static inline __m256i Xorshift_AVX2(__m256i seed)
+{
+    seed = _mm256_xor_si256(seed, _mm256_slli_epi32(seed, 13));
+    seed = _mm256_xor_si256(seed, _mm256_srli_epi32(seed, 17));
+    seed = _mm256_xor_si256(seed, _mm256_slli_epi32(seed, 5));
+    return seed;
+}
+
+/**
+* Convert unsigned 32-bit integers to float, rounding to nearest like a scalar conversion.
+* Both 16-bit halves convert exactly, so the only rounding happens in the final add.
+*/
+SIMD_TARGET_AVX2 static inline __m256 UintToFloat_AVX2(__m256i value)
+{
+    const __m256 hi = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(value, 16)), _mm256_set1_ps(65536.f));
+    const __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(value, _mm256_set1_epi32(0xFFFF)));
+    return _mm256_add_ps(hi, lo);
+}
+
+SIMD_TARGET_AVX2 static inline __m256 GenerateRandomNumber_AVX2(__m256i &seed)
+{
+    seed = WangHash_AVX2(seed);
+    return _mm256_mul_ps(UintToFloat_AVX2(Xorshift_AVX2(seed)), _mm256_set1_ps(1.f / 4294967296.f));
+}
+
+/**
+* AVX2 white noise, 8 pixels at a time.
+*/
+SIMD_TARGET_AVX2 static void GenerateWhiteNoiseRow_AVX2(uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b)
+{
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i vframe = _mm256_set1_epi32((int)frame);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
+    {
+        const __m256i index = _mm256_add_epi32(_mm256_set1_epi32((int)((y * width) + (x + i))), lanes);
+        __m256i seed = _mm256_mullo_epi32(index, vframe);
+
+        _mm256_storeu_ps(r + i, GenerateRandomNumber_AVX2(seed));
+        _mm256_storeu_ps(g + i, GenerateRandomNumber_AVX2(seed));
+        _mm256_storeu_ps(b + i, GenerateRandomNumber_AVX2(seed));
+    }
+
+    GenerateWhiteNoiseRow_Scalar(x + i, y, count - i, width, frame, r + i, g + i, b + i);
+}
+
+SIMD_AVX512_BEGIN
+SIMD_TARGET_AVX512 static inline __m512i WangHash_AVX512(__m512i seed)
+{
+    seed = _mm512_xor_si512(_mm512_xor_si512(seed, _mm512_set1_epi32(61)), _mm512_srli_epi32(seed, 16));
+    seed = _mm512_add_epi32(seed, _mm512_slli_epi32(seed, 3));                      // seed *= 9
+    seed = _mm512_xor_si512(seed, _mm512_srli_epi32(seed, 4));
+    seed = _mm512_mullo_epi32(seed, _mm512_set1_epi32(0x27d4eb2d));
+    seed = _mm512_xor_si512(seed, _mm512_srli_epi32(seed, 15));
+    return seed;
+}
+
+SIMD_TARGET_AVX512 static inline __m512i Xorshift_AVX512(__m512i seed)
+{
+    seed = _mm512_xor_si512(seed, _mm512_slli_epi32(seed, 13));
+    seed = _mm512_xor_si512(seed, _mm512_srli_epi32(seed, 17));
+    seed = _mm512_xor_si512(seed, _mm512_slli_epi32(seed, 5));
+    return seed;
+}
+
+SIMD_TARGET_AVX512 static inline __m512 GenerateRandomNumber_AVX512(__m512i &seed)
+{
+    seed = WangHash_AVX512(seed);
+    return _mm512_mul_ps(_mm512_cvtepu32_ps(Xorshift_AVX512(seed)), _mm512_set1_ps(1.f / 4294967296.f));
+}
+
+/**
+* AVX-512 white noise, 16 pixels at a time. The tail is handled with masked stores.
+*/
+SIMD_TARGET_AVX512 static void GenerateWhiteNoiseRow_AVX512(uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b)
+{
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i vframe = _mm512_set1_epi32((int)frame);
+
+    for (uint32_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = (count - i) >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+        const __m512i index = _mm512_add_epi32(_mm512_set1_epi32((int)((y * width) + (x + i))), lanes);
+        __m512i seed = _mm512_mullo_epi32(index, vframe);
+
+        _mm512_mask_storeu_ps(r + i, mask, GenerateRandomNumber_AVX512(seed));
+        _mm512_mask_storeu_ps(g + i, mask, GenerateRandomNumber_AVX512(seed));
+        _mm512_mask_storeu_ps(b + i, mask, GenerateRandomNumber_AVX512(seed));
+    }
+}
+SIMD_AVX512_END
+
+#endif
+
+typedef void (*WhiteNoiseRowKernel)(uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b);
+
+/**
+* Get the white noise kernel of an instruction set.
+*/
+static WhiteNoiseRowKernel Get_WhiteNoiseRow_Kernel(SimdLevel level)
+{
+#if SIMD_X86
+    if (level >= SIMD_AVX512) return GenerateWhiteNoiseRow_AVX512;
+    if (level >= SIMD_AVX2) return GenerateWhiteNoiseRow_AVX2;
+    if (level >= SIMD_SSE42) return GenerateWhiteNoiseRow_SSE42;
+#endif
+    return GenerateWhiteNoiseRow_Scalar;
+}
+
+/**
+* Generate uniform white noise for count pixels of row y with the given instruction set.
+*/
+void GenerateWhiteNoiseRow(SimdLevel level, uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b)
+{
+    Get_WhiteNoiseRow_Kernel(level)(x, y, count, width, frame, r, g, b);
+}
+
+/**
+* Generate uniform white noise for count pixels of row y.
+*/
+void GenerateWhiteNoiseRow(uint32_t x, uint32_t y, uint32_t count, uint32_t width, uint32_t frame, float* r, float* g, float* b)
+{
+    static const WhiteNoiseRowKernel kernel = Get_WhiteNoiseRow_Kernel(Simd::Get_Level());
+    kernel(x, y, count, width, frame, r, g, b);
+}
+
+/**
+* Generate uniform white noise for a tile. Each output plane is tileHeight rows of pitch floats.
+*/
+void GenerateWhiteNoiseTile(uint32_t x, uint32_t y, uint32_t tileWidth, uint32_t tileHeight, uint32_t width, uint32_t frame, float* r, float* g, float* b, uint32_t pitch)
+{
+    for (uint32_t row = 0; row < tileHeight; row++)
+    {
+        const size_t offset = (size_t)row * pitch;
+        GenerateWhiteNoiseRow(x, y + row, tileWidth, width, frame, r + offset, g + offset, b + offset);
+    }
+}
+
+}
@@ -0,0 +1,612 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Quantize.h"
+#include "Color.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Quantize
+{
+
+//--------------------------------------------------------------------------------------
+// Layouts
+//--------------------------------------------------------------------------------------
+
+/**
+* Get the name of a pixel format.
+*/
+const char* Get_Format_Name(PixelFormat format)
+{
+    switch (format)
+    {
+        case PIXEL_FORMAT_RGBA8: return "RGBA8";
+        case PIXEL_FORMAT_RGB565: return "RGB565";
+        case PIXEL_FORMAT_RGB10A2: return "RGB10A2";
+        case PIXEL_FORMAT_RGBA16: return "RGBA16";
+        default: return "Unknown";
+    }
+}
+
+/**
+* Get the bit layout of a pixel format.
+*/
+PixelLayout Get_Layout(PixelFormat format)
+{
+    PixelLayout layout;
+    if (format == PIXEL_FORMAT_RGB565)
+    {
+        layout = { { 5, 6, 5, 0 }, { 11, 5, 0, 0 }, 2 };
+    }
+    else if (format == PIXEL_FORMAT_RGB10A2)
+    {
+        layout = { { 10, 10, 10, 2 }, { 0, 10, 20, 30 }, 4 };
+    }
+    else if (format == PIXEL_FORMAT_RGBA16)
+    {
+        layout = { { 16, 16, 16, 16 }, { 0, 16, 32, 48 }, 8 };
+    }
+    else if (format != PIXEL_FORMAT_RGBA8)
+    {
+        throw runtime_error("Error: unknown pixel format!");
+    }
+    return layout;
+}
+
+/**
+* Create a layout with any depth per channel (up to 16 bits, 0 leaves the channel out). Channels
+* are packed from the least significant bit in RGBA order, into the smallest word that holds them.
+*/
+PixelLayout Create_Layout(uint32_t redBits, uint32_t greenBits, uint32_t blueBits, uint32_t alphaBits)
+{
+    const uint32_t bits[4] = { redBits, greenBits, blueBits, alphaBits };
+
+    PixelLayout layout;
+    uint32_t total = 0;
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        if (bits[c] > QUANTIZE_MAX_BITS) throw runtime_error("Error: channels can have at most 16 bits!");
+        layout.bits[c] = (uint8_t)bits[c];
+        layout.shift[c] = (uint8_t)(bits[c] ? total : 0);
+        total += bits[c];
+    }
+    if (total == 0) throw runtime_error("Error: pixel layout has no channels!");
+
+    layout.bytesPerPixel = 1;
+    while ((layout.bytesPerPixel * 8) < total) layout.bytesPerPixel *= 2;
+    return layout;
+}
+
+/**
+* Get the depth of the coarsest color channel of a layout, or 0 when it has no color channels.
+*/
+uint32_t Get_Color_Bits(const PixelLayout &layout)
+{
+    uint32_t bits = 0;
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        if (layout.bits[c] > 0 && (bits == 0 || layout.bits[c] < bits)) bits = layout.bits[c];
+    }
+    return bits;
+}
+
+/**
+* Get the noise scale that dithers a quantization to the given depth: one step with a uniform
+* distribution, and two with a triangular distribution (distribution 1).
+*/
+float Get_Noise_Scale(uint32_t bits, int distribution)
+{
+    if (bits == 0) return 0.f;
+    const float step = 1.f / (float)((1u << bits) - 1);
+    return (distribution == 1) ? (2.f * step) : step;
+}
+
+/**
+* Get the noise scale for the coarsest color channel of a layout.
+*/
+float Get_Noise_Scale(const PixelLayout &layout, int distribution)
+{
+    return Get_Noise_Scale(Get_Color_Bits(layout), distribution);
+}
+
+//--------------------------------------------------------------------------------------
+// Packing Kernels
+// Channels with no bits are left out. A null alpha pointer writes opaque alpha.
+//--------------------------------------------------------------------------------------
+
+static inline float Get_Max_Value(uint32_t bits)
+{
+    return (float)((1u << bits) - 1);
+}
+
+/**
+* Scalar packing, one pixel at a time.
+*/
+static void Pack_Row_Scalar(const PixelLayout &layout, const float* const channels[4], uint32_t count, uint8_t* dest)
+{
+    float maxValues[4];
+    for (uint32_t c = 0; c < 4; c++) maxValues[c] = Get_Max_Value(layout.bits[c]);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t pixel = 0;
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            if (layout.bits[c] == 0) continue;
+
+            uint64_t value = (uint64_t)maxValues[c];
+            if (channels[c]) value = (uint64_t)(uint32_t)(Color::Saturate(channels[c][i]) * maxValues[c] + 0.5f);
+            pixel |= (value << layout.shift[c]);
+        }
+        memcpy(&dest[(size_t)i * layout.bytesPerPixel], &pixel, layout.bytesPerPixel);
+    }
+}
+
+#if SIMD_X86
+
+/**
+* Saturate (NaN becomes 0), scale, and round 4 values, like the scalar conversion.
+*/
+SIMD_TARGET_SSE42 static inline __m128i Quantize_SSE42(const float* src, __m128 maxValue)
+{
+    __m128 x = _mm_loadu_ps(src);
+    x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, maxValue), _mm_set1_ps(0.5f)));
+}
+
+/**
+* SSE4.2 packing, 4 pixels at a time, built the same way as Pack_Row_AVX2().
+*/
+SIMD_TARGET_SSE42 static void Pack_Row_SSE42(const PixelLayout &layout, const float* const channels[4], uint32_t count, uint8_t* dest)
+{
+    __m128 maxValues[4];
+    __m128i shifts[4];
+    uint64_t opaque = 0;
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        maxValues[c] = _mm_set1_ps(Get_Max_Value(layout.bits[c]));
+        shifts[c] = _mm_cvtsi32_si128(layout.shift[c]);
+        if (layout.bits[c] > 0 && !channels[c]) opaque |= ((uint64_t)((1u << layout.bits[c]) - 1) << layout.shift[c]);
+    }
+
+    uint32_t i = 0;
+    if (layout.bytesPerPixel <= 4)
+    {
+        for (; (i + 4) <= count; i += 4)
+        {
+            __m128i pixel = _mm_set1_epi32((int)(uint32_t)opaque);
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (layout.bits[c] == 0 || !channels[c]) continue;
+                pixel = _mm_or_si128(pixel, _mm_sll_epi32(Quantize_SSE42(channels[c] + i, maxValues[c]), shifts[c]));
+            }
+
+            uint8_t* out = &dest[(size_t)i * layout.bytesPerPixel];
+            if (layout.bytesPerPixel == 4)
+            {
+                _mm_storeu_si128((__m128i*)out, pixel);
+                continue;
+            }
+
+            const __m128i words = _mm_packus_epi32(pixel, pixel);
+            if (layout.bytesPerPixel == 2) _mm_storel_epi64((__m128i*)out, words);
+            else
+            {
+                const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+                memcpy(out, &bytes, sizeof(bytes));
+            }
+        }
+    }
+    else
+    {
+        for (; (i + 4) <= count; i += 4)
+        {
+            __m128i lo = _mm_set1_epi64x((long long)opaque);
+            __m128i hi = lo;
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (layout.bits[c] == 0 || !channels[c]) continue;
+
+                const __m128i value = Quantize_SSE42(channels[c] + i, maxValues[c]);
+                lo = _mm_or_si128(lo, _mm_sll_epi64(_mm_cvtepu32_epi64(value), shifts[c]));
+                hi = _mm_or_si128(hi, _mm_sll_epi64(_mm_cvtepu32_epi64(_mm_unpackhi_epi64(value, value)), shifts[c]));
+            }
+
+            uint8_t* out = &dest[(size_t)i * 8];
+            _mm_storeu_si128((__m128i*)out, lo);
+            _mm_storeu_si128((__m128i*)(out + 16), hi);
+        }
+    }
+
+    const float* const tail[4] =
+    {
+        channels[0] ? channels[0] + i : nullptr,
+        channels[1] ? channels[1] + i : nullptr,
+        channels[2] ? channels[2] + i : nullptr,
+        channels[3] ? channels[3] + i : nullptr,
+    };
+    Pack_Row_Scalar(layout, tail, count - i, &dest[(size_t)i * layout.bytesPerPixel]);
+}
+
+/**
+* Saturate (NaN becomes 0), scale, and round 8 values, like the scalar conversion.
+*/
+SIMD_TARGET_AVX2 static inline __m256i Quantize_AVX2(const float* src, __m256 maxValue)
+{
+    __m256 x = _mm256_loadu_ps(src);
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(x, maxValue), _mm256_set1_ps(0.5f)));
+}
+
+/**
+* AVX2 packing, 8 pixels at a time. Pixels of up to 32 bits are built in 32-bit lanes and
+* narrowed to the word size, 64-bit pixels are built in two sets of 64-bit lanes.
+*/
+SIMD_TARGET_AVX2 static void Pack_Row_AVX2(const PixelLayout &layout, const float* const channels[4], uint32_t count, uint8_t* dest)
+{
+    __m256 maxValues[4];
+    __m128i shifts[4];
+    uint64_t opaque = 0;
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        maxValues[c] = _mm256_set1_ps(Get_Max_Value(layout.bits[c]));
+        shifts[c] = _mm_cvtsi32_si128(layout.shift[c]);
+        if (layout.bits[c] > 0 && !channels[c]) opaque |= ((uint64_t)((1u << layout.bits[c]) - 1) << layout.shift[c]);
+    }
+
+    uint32_t i = 0;
+    if (layout.bytesPerPixel <= 4)
+    {
+        for (; (i + 8) <= count; i += 8)
+        {
+            __m256i pixel = _mm256_set1_epi32((int)(uint32_t)opaque);
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (layout.bits[c] == 0 || !channels[c]) continue;
+                pixel = _mm256_or_si256(pixel, _mm256_sll_epi32(Quantize_AVX2(channels[c] + i, maxValues[c]), shifts[c]));
+            }
+
+            uint8_t* out = &dest[(size_t)i * layout.bytesPerPixel];
+            if (layout.bytesPerPixel == 4)
+            {
+                _mm256_storeu_si256((__m256i*)out, pixel);
+                continue;
+            }
+
+            const __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(pixel), _mm256_extracti128_si256(pixel, 1));
+            if (layout.bytesPerPixel == 2) _mm_storeu_si128((__m128i*)out, words);
+            else _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(words, words));
+        }
+    }
+    else
+    {
+        for (; (i + 8) <= count; i += 8)
+        {
+            __m256i lo = _mm256_set1_epi64x((long long)opaque);
+            __m256i hi = lo;
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (layout.bits[c] == 0 || !channels[c]) continue;
+
+                const __m256i value = Quantize_AVX2(channels[c] + i, maxValues[c]);
+                lo = _mm256_or_si256(lo, _mm256_sll_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(value)), shifts[c]));
+                hi = _mm256_or_si256(hi, _mm256_sll_epi64(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(value, 1)), shifts[c]));
+            }
+
+            uint8_t* out = &dest[(size_t)i * 8];
+            _mm256_storeu_si256((__m256i*)out, lo);
+            _mm256_storeu_si256((__m256i*)(out + 32), hi);
+        }
+    }
+
+    const float* const tail[4] =
+    {
+        channels[0] ? channels[0] + i : nullptr,
+        channels[1] ? channels[1] + i : nullptr,
+        channels[2] ? channels[2] + i : nullptr,
+        channels[3] ? channels[3] + i : nullptr,
+    };
+    Pack_Row_Scalar(layout, tail, count - i, &dest[(size_t)i * layout.bytesPerPixel]);
+}
+
+SIMD_AVX512_BEGIN
+/**
+* Saturate (NaN becomes 0), scale, and round up to 16 values, like the scalar conversion.
+*/
+SIMD_TARGET_AVX512 static inline __m512i Quantize_AVX512(const float* src, __mmask16 mask, __m512 maxValue)
+{
+    __m512 x = _mm512_maskz_loadu_ps(mask, src);
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_setzero_ps()), _mm512_set1_ps(1.f));
+    return _mm512_cvttps_epi32(_mm512_add_ps(_mm512_mul_ps(x, maxValue), _mm512_set1_ps(0.5f)));
+}
+
+/**
+* AVX-512 packing, 16 pixels at a time. The tail is handled with masked loads and stores.
+*/
+SIMD_TARGET_AVX512 static void Pack_Row_AVX512(const PixelLayout &layout, const float* const channels[4], uint32_t count, uint8_t* dest)
+{
+    __m512 maxValues[4];
+    __m128i shifts[4];
+    uint64_t opaque = 0;
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        maxValues[c] = _mm512_set1_ps(Get_Max_Value(layout.bits[c]));
+        shifts[c] = _mm_cvtsi32_si128(layout.shift[c]);
+        if (layout.bits[c] > 0 && !channels[c]) opaque |= ((uint64_t)((1u << layout.bits[c]) - 1) << layout.shift[c]);
+    }
+
+    for (uint32_t i = 0; i < count; i += 16)
+    {
+        const __mmask16 mask = (count - i) >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+        uint8_t* out = &dest[(size_t)i * layout.bytesPerPixel];
+
+        if (layout.bytesPerPixel <= 4)
+        {
+            __m512i pixel = _mm512_set1_epi32((int)(uint32_t)opaque);
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (layout.bits[c] == 0 || !channels[c]) continue;
+                pixel = _mm512_or_si512(pixel, _mm512_sll_epi32(Quantize_AVX512(channels[c] + i, mask, maxValues[c]), shifts[c]));
+            }
+
+            if (layout.bytesPerPixel == 4) _mm512_mask_storeu_epi32(out, mask, pixel);
+            else if (layout.bytesPerPixel == 2) _mm512_mask_cvtepi32_storeu_epi16(out, mask, pixel);
+            else _mm512_mask_cvtepi32_storeu_epi8(out, mask, pixel);
+        }
+        else
+        {
+            __m512i lo = _mm512_set1_epi64((long long)opaque);
+            __m512i hi = lo;
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (layout.bits[c] == 0 || !channels[c]) continue;
+
+                const __m512i value = Quantize_AVX512(channels[c] + i, mask, maxValues[c]);
+                lo = _mm512_or_si512(lo, _mm512_sll_epi64(_mm512_cvtepu32_epi64(_mm512_castsi512_si256(value)), shifts[c]));
+                hi = _mm512_or_si512(hi, _mm512_sll_epi64(_mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(value, 1)), shifts[c]));
+            }
+
+            _mm512_mask_storeu_epi64(out, (__mmask8)mask, lo);
+            _mm512_mask_storeu_epi64(out + 64, (__mmask8)(mask >> 8), hi);
+        }
+    }
+}
+SIMD_AVX512_END
+
+#endif
+
+typedef void (*PackRowKernel)(const PixelLayout &layout, const float* const channels[4], uint32_t count, uint8_t* dest);
+
+static PackRowKernel Get_Pack_Row_Kernel(SimdLevel level)
+{
+#if SIMD_X86
+    if (level >= SIMD_AVX512) return Pack_Row_AVX512;
+    if (level >= SIMD_AVX2) return Pack_Row_AVX2;
+    if (level >= SIMD_SSE42) return Pack_Row_SSE42;
+#endif
+    return Pack_Row_Scalar;
+}
+
+/**
+* Quantize count pixels of planar RGBA and pack them into dest with the given instruction set.
+* Alpha may be null, which writes opaque alpha.
+*/
+void Pack_Row(SimdLevel level, const PixelLayout &layout, const float* r, const float* g, const float* b, const float* a, uint32_t count, void* dest)
+{
+    const float* const channels[4] = { r, g, b, a };
+    Get_Pack_Row_Kernel(level)(layout, channels, count, (uint8_t*)dest);
+}
+
+/**
+* Quantize count pixels of planar RGBA and pack them into dest. Alpha may be null, which writes opaque alpha.
+*/
+void Pack_Row(const PixelLayout &layout, const float* r, const float* g, const float* b, const float* a, uint32_t count, void* dest)
+{
+    static const PackRowKernel kernel = Get_Pack_Row_Kernel(Simd::Get_Level());
+    const float* const channels[4] = { r, g, b, a };
+    kernel(layout, channels, count, (uint8_t*)dest);
+}
+
+//--------------------------------------------------------------------------------------
+// Unpacking Kernels
+// Channels the layout leaves out are 0, or 1 for alpha. Null channel pointers are skipped.
+//--------------------------------------------------------------------------------------
+
+/**
+* Scalar unpacking, one pixel at a time.
+*/
+static void Unpack_Row_Scalar(const PixelLayout &layout, const uint8_t* src, uint32_t count, float* const channels[4])
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t pixel = 0;
+        memcpy(&pixel, &src[(size_t)i * layout.bytesPerPixel], layout.bytesPerPixel);
+
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            if (!channels[c]) continue;
+            if (layout.bits[c] == 0)
+            {
+                channels[c][i] = (c == 3) ? 1.f : 0.f;
+                continue;
+            }
+
+            const uint64_t mask = (1ull << layout.bits[c]) - 1;
+            channels[c][i] = (float)((pixel >> layout.shift[c]) & mask) / Get_Max_Value(layout.bits[c]);
+        }
+    }
+}
+
+#if SIMD_X86
+
+/**
+* SSE4.2 unpacking, 4 pixels at a time, for pixels of up to 32 bits. Like Unpack_Row_AVX2(), it divides.
+*/
+SIMD_TARGET_SSE42 static void Unpack_Row_SSE42(const PixelLayout &layout, const uint8_t* src, uint32_t count, float* const channels[4])
+{
+    uint32_t i = 0;
+    if (layout.bytesPerPixel <= 4)
+    {
+        __m128 maxValues[4];
+        __m128i masks[4];
+        __m128i shifts[4];
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            maxValues[c] = _mm_set1_ps(Get_Max_Value(layout.bits[c]));
+            masks[c] = _mm_set1_epi32((int)((1u << layout.bits[c]) - 1));
+            shifts[c] = _mm_cvtsi32_si128(layout.shift[c]);
+        }
+
+        for (; (i + 4) <= count; i += 4)
+        {
+            const uint8_t* in = &src[(size_t)i * layout.bytesPerPixel];
+
+            __m128i pixel;
+            if (layout.bytesPerPixel == 4) pixel = _mm_loadu_si128((const __m128i*)in);
+            else if (layout.bytesPerPixel == 2) pixel = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)in));
+            else
+            {
+                int bytes;
+                memcpy(&bytes, in, sizeof(bytes));
+                pixel = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+            }
+
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (!channels[c]) continue;
+                if (layout.bits[c] == 0)
+                {
+                    _mm_storeu_ps(channels[c] + i, _mm_set1_ps((c == 3) ? 1.f : 0.f));
+                    continue;
+                }
+
+                const __m128i value = _mm_and_si128(_mm_srl_epi32(pixel, shifts[c]), masks[c]);
+                _mm_storeu_ps(channels[c] + i, _mm_div_ps(_mm_cvtepi32_ps(value), maxValues[c]));
+            }
+        }
+    }
+
+    float* const tail[4] =
+    {
+        channels[0] ? channels[0] + i : nullptr,
+        channels[1] ? channels[1] + i : nullptr,
+        channels[2] ? channels[2] + i : nullptr,
+        channels[3] ? channels[3] + i : nullptr,
+    };
+    Unpack_Row_Scalar(layout, &src[(size_t)i * layout.bytesPerPixel], count - i, tail);
+}
+
+/**
+* AVX2 unpacking, 8 pixels at a time, for pixels of up to 32 bits. Dividing (rather than
+* multiplying by the reciprocal) keeps the results identical to the scalar path.
+*/
+SIMD_TARGET_AVX2 static void Unpack_Row_AVX2(const PixelLayout &layout, const uint8_t* src, uint32_t count, float* const channels[4])
+{
+    uint32_t i = 0;
+    if (layout.bytesPerPixel <= 4)
+    {
+        __m256 maxValues[4];
+        __m256i masks[4];
+        __m128i shifts[4];
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            maxValues[c] = _mm256_set1_ps(Get_Max_Value(layout.bits[c]));
+            masks[c] = _mm256_set1_epi32((int)((1u << layout.bits[c]) - 1));
+            shifts[c] = _mm_cvtsi32_si128(layout.shift[c]);
+        }
+
+        for (; (i + 8) <= count; i += 8)
+        {
+            const uint8_t* in = &src[(size_t)i * layout.bytesPerPixel];
+
+            __m256i pixel;
+            if (layout.bytesPerPixel == 4) pixel = _mm256_loadu_si256((const __m256i*)in);
+            else if (layout.bytesPerPixel == 2) pixel = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)in));
+            else pixel = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)in));
+
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                if (!channels[c]) continue;
+                if (layout.bits[c] == 0)
+                {
+                    _mm256_storeu_ps(channels[c] + i, _mm256_set1_ps((c == 3) ? 1.f : 0.f));
+                    continue;
+                }
+
+                const __m256i value = _mm256_and_si256(_mm256_srl_epi32(pixel, shifts[c]), masks[c]);
+                _mm256_storeu_ps(channels[c] + i, _mm256_div_ps(_mm256_cvtepi32_ps(value), maxValues[c]));
+            }
+        }
+    }
+
+    float* const tail[4] =
+    {
+        channels[0] ? channels[0] + i : nullptr,
+        channels[1] ? channels[1] + i : nullptr,
+        channels[2] ? channels[2] + i : nullptr,
+        channels[3] ? channels[3] + i : nullptr,
+    };
+    Unpack_Row_Scalar(layout, &src[(size_t)i * layout.bytesPerPixel], count - i, tail);
+}
+
+#endif
+
+typedef void (*UnpackRowKernel)(const PixelLayout &layout, const uint8_t* src, uint32_t count, float* const channels[4]);
+
+static UnpackRowKernel Get_Unpack_Row_Kernel(SimdLevel level)
+{
+#if SIMD_X86
+    if (level >= SIMD_AVX2) return Unpack_Row_AVX2;
+    if (level >= SIMD_SSE42) return Unpack_Row_SSE42;
+#endif
+    return Unpack_Row_Scalar;
+}
+
+/**
+* Unpack count pixels to planar [0, 1] floats with the given instruction set. Any channel pointer may be null.
+*/
+void Unpack_Row(SimdLevel level, const PixelLayout &layout, const void* src, uint32_t count, float* r, float* g, float* b, float* a)
+{
+    float* const channels[4] = { r, g, b, a };
+    Get_Unpack_Row_Kernel(level)(layout, (const uint8_t*)src, count, channels);
+}
+
+/**
+* Unpack count pixels to planar [0, 1] floats. Any channel pointer may be null.
+*/
+void Unpack_Row(const PixelLayout &layout, const void* src, uint32_t count, float* r, float* g, float* b, float* a)
+{
+    static const UnpackRowKernel kernel = Get_Unpack_Row_Kernel(Simd::Get_Level());
+    float* const channels[4] = { r, g, b, a };
+    kernel(layout, (const uint8_t*)src, count, channels);
+}
+
+}
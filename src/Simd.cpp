@@ -0,0 +1,193 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Simd.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#if SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+using namespace std;
+
+namespace Simd
+{
+
+#if SIMD_X86
+
+static void CPUID(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = (uint32_t)info[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t XGETBV()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+/**
+* Probe CPUID, and check that the OS saves the wider register state.
+*/
+static SimdLevel Detect_Level()
+{
+    uint32_t regs[4];
+    CPUID(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1) return SIMD_SCALAR;
+
+    CPUID(1, 0, regs);
+    const bool sse42 = (regs[2] & (1u << 20)) != 0;
+    const bool popcnt = (regs[2] & (1u << 23)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool fma = (regs[2] & (1u << 12)) != 0;
+
+    const SimdLevel sseLevel = (sse42 && popcnt) ? SIMD_SSE42 : SIMD_SCALAR;
+    if (maxLeaf < 7 || !osxsave) return sseLevel;
+
+    const uint64_t xcr0 = XGETBV();
+    const bool ymm = (xcr0 & 0x6) == 0x6;
+    const bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+    CPUID(7, 0, regs);
+    const bool avx2 = (regs[1] & (1u << 5)) != 0;
+    const bool avx512f = (regs[1] & (1u << 16)) != 0;
+    const bool avx512dq = (regs[1] & (1u << 17)) != 0;
+    const bool avx512bw = (regs[1] & (1u << 30)) != 0;
+    const bool avx512vl = (regs[1] & (1u << 31)) != 0;
+
+    if (ymm && zmm && avx2 && fma && avx512f && avx512dq && avx512bw && avx512vl) return SIMD_AVX512;
+    if (ymm && avx2 && fma) return SIMD_AVX2;
+    return sseLevel;
+}
+
+#else
+
+static SimdLevel Detect_Level()
+{
+    return SIMD_SCALAR;
+}
+
+#endif
+
+/**
+* Apply the COLORBANDING_SIMD override, if it is set, to the level of the CPU.
+*/
+static SimdLevel Select_Level()
+{
+    const SimdLevel cpuLevel = Get_CPU_Level();
+    const char* value = getenv(SIMD_LEVEL_VARIABLE);
+    if (!value || !*value) return cpuLevel;
+
+    SimdLevel level;
+    if (!Parse_Level(value, level))
+    {
+        fprintf(stderr, "Warning: %s=%s is not scalar, sse4.2, avx2, or avx512, using %s\n", SIMD_LEVEL_VARIABLE, value, Get_Level_Name(cpuLevel));
+        return cpuLevel;
+    }
+    if (level > cpuLevel)
+    {
+        fprintf(stderr, "Warning: %s=%s is not supported by this CPU, using %s\n", SIMD_LEVEL_VARIABLE, value, Get_Level_Name(cpuLevel));
+        return cpuLevel;
+    }
+    return level;
+}
+
+/**
+* Get the instruction set that kernels run with: the widest one the CPU supports, unless
+* COLORBANDING_SIMD selects a lower one. Read once.
+*/
+SimdLevel Get_Level()
+{
+    static const SimdLevel level = Select_Level();
+    return level;
+}
+
+/**
+* Get the widest instruction set supported by this machine. The CPU is only probed once.
+*/
+SimdLevel Get_CPU_Level()
+{
+    static const SimdLevel level = Detect_Level();
+    return level;
+}
+
+const char* Get_Level_Name(SimdLevel level)
+{
+    switch (level)
+    {
+        case SIMD_AVX512: return "AVX-512";
+        case SIMD_AVX2: return "AVX2";
+        case SIMD_SSE42: return "SSE4.2";
+        default: return "Scalar";
+    }
+}
+
+/**
+* Parse a level name, ignoring case and punctuation, so "AVX-512" and "avx512" are the same.
+*/
+bool Parse_Level(const char* name, SimdLevel &level)
+{
+    static const char* const names[SIMD_LEVEL_COUNT] = { "scalar", "sse42", "avx2", "avx512" };
+
+    string key;
+    for (const char* c = name; *c; c++)
+    {
+        if (isalnum((unsigned char)*c)) key += (char)tolower((unsigned char)*c);
+    }
+
+    for (int l = SIMD_SCALAR; l < SIMD_LEVEL_COUNT; l++)
+    {
+        if (key == names[l])
+        {
+            level = (SimdLevel)l;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,330 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Software.h"
+#include "Color.h"
+#include "Noise.h"
+#include "Quantize.h"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Software
+{
+
+/**
+* Allocate a frame for pixels of the given layout, R8G8B8A8 by default.
+*/
+void Create_Frame(SoftwareFrame &frame, uint32_t width, uint32_t height, const PixelLayout &layout)
+{
+    frame.width = width;
+    frame.height = height;
+    frame.bytesPerPixel = layout.bytesPerPixel;
+    frame.rowPitch = width * layout.bytesPerPixel;
+    frame.pixels.resize((size_t)frame.rowPitch * height);
+}
+
+/**
+* Allocate a float reference frame.
+*/
+void Create_Reference(ReferenceFrame &frame, uint32_t width, uint32_t height)
+{
+    frame.width = width;
+    frame.height = height;
+    for (uint32_t c = 0; c < 3; c++) frame.planes[c].resize((size_t)width * height);
+}
+
+/**
+* Compute the lit color of count pixels, starting at pixel (x, y), and add noise in the same pass when it is given.
+*/
+template<bool AddNoise>
+static inline void Shade_Row(const BandingConstants &constants, uint32_t x, uint32_t y, uint32_t count, const float* const* noise, float* r, float* g, float* b)
+{
+    // VS() rasterizes a fullscreen triangle, so SV_POSITION is the pixel center
+    const float worldZ = (float)y + 0.5f;
+    const float lightY = constants.lightPosition.y;
+    const float dz = constants.lightPosition.z - worldZ;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const float worldX = (float)(x + i) + 0.5f;
+        const float dx = constants.lightPosition.x - worldX;
+
+        // The surface normal is (0, 1, 0), so dot(normal, normalize(lightVector)) is the Y component
+        const float nDotL = lightY / sqrtf(dx * dx + lightY * lightY + dz * dz);
+
+        r[i] = Color::Saturate(constants.color.x * nDotL);
+        g[i] = Color::Saturate(constants.color.y * nDotL);
+        b[i] = Color::Saturate(constants.color.z * nDotL);
+        if (AddNoise)
+        {
+            r[i] += noise[0][i];
+            g[i] += noise[1][i];
+            b[i] += noise[2][i];
+        }
+    }
+}
+
+/**
+* Compute the lit color of count pixels, starting at pixel (x, y). Matches the lighting in PS().
+*/
+void Shade_Row(const BandingConstants &constants, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b)
+{
+    Shade_Row<false>(constants, x, y, count, nullptr, r, g, b);
+}
+
+/**
+* Tonemap, dither, and gamma correct count pixels of linear color, then quantize and pack them
+* into dest with settings.layout. The color is modified in place.
+*/
+void Resolve_Row(const BandingConstants &constants, const SoftwareSettings &settings, const NoiseTextures &textures, uint32_t x, uint32_t y, uint32_t count, float* r, float* g, float* b, uint8_t* dest)
+{
+    float* channels[3] = { r, g, b };
+
+    // Apply tonemapping
+    if (constants.useTonemapping)
+    {
+        for (uint32_t c = 0; c < 3; c++) Color::ACESFilm(channels[c], channels[c], count);
+    }
+
+    // Dither
+    if (constants.useDithering > 0)
+    {
+        float noise[3][SOFTWARE_TILE_SIZE];
+        for (uint32_t offset = 0; offset < count; offset += SOFTWARE_TILE_SIZE)
+        {
+            const uint32_t span = min(count - offset, SOFTWARE_TILE_SIZE);
+            Noise::GetNoiseRow(constants, textures, x + offset, y, span, noise[0], noise[1], noise[2]);
+
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                if (constants.showNoise)
+                {
+                    for (uint32_t i = 0; i < span; i++) channels[c][offset + i] = noise[c][i];
+                }
+                else
+                {
+                    for (uint32_t i = 0; i < span; i++) channels[c][offset + i] += noise[c][i];
+                }
+            }
+        }
+    }
+
+    // Gamma correct (the noise is written out directly when it is being visualized)
+    if (!(constants.useDithering > 0 && constants.showNoise))
+    {
+        for (uint32_t c = 0; c < 3; c++) Color::LinearToSRGB(settings.transferMode, channels[c], channels[c], count);
+    }
+
+    Quantize::Pack_Row(settings.layout, r, g, b, nullptr, count, dest);
+}
+
+//--------------------------------------------------------------------------------------
+// Tile Kernels
+// One kernel per permutation of the flags PS() branches on. Each shades, tonemaps, dithers,
+// gamma corrects, and packs a tile a row at a time, in buffers that stay in L1, so the only
+// per-pixel work is the work the flags select. The kernel is looked up once per frame.
+//--------------------------------------------------------------------------------------
+
+typedef void (*TileKernel)(const BandingConstants &constants, const SoftwareSettings &settings, const NoiseSource &source, SoftwareFrame &frame, uint32_t tileIndex);
+
+enum TileMode
+{
+    TILE_MODE_SHADE = 0,        // no dithering
+    TILE_MODE_DITHER,
+    TILE_MODE_SHOW_NOISE,       // the noise is written out instead of the color
+    TILE_MODE_COUNT,
+};
+
+/**
+* Render one tile of the frame with the flags fixed at compile time. Matches Shade_Row() followed by Resolve_Row().
+*/
+template<NoiseType Type, NoiseDistribution Distribution, bool Tonemap, TileMode Mode>
+static void Render_Tile_Kernel(const BandingConstants &constants, const SoftwareSettings &settings, const NoiseSource &source, SoftwareFrame &frame, uint32_t tileIndex)
+{
+    const uint32_t tilesX = (frame.width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    const uint32_t x = (tileIndex % tilesX) * SOFTWARE_TILE_SIZE;
+    const uint32_t y = (tileIndex / tilesX) * SOFTWARE_TILE_SIZE;
+    const uint32_t width = min(frame.width - x, SOFTWARE_TILE_SIZE);
+    const uint32_t height = min(frame.height - y, SOFTWARE_TILE_SIZE);
+
+    float color[3][SOFTWARE_TILE_SIZE];
+    float noise[3][SOFTWARE_TILE_SIZE];
+    const float* const noiseRows[3] = { noise[0], noise[1], noise[2] };
+
+    for (uint32_t row = y; row < (y + height); row++)
+    {
+        uint8_t* dest = &frame.pixels[(size_t)row * frame.rowPitch + x * frame.bytesPerPixel];
+
+        if (Mode == TILE_MODE_SHOW_NOISE)
+        {
+            // The noise replaces the color, so there is nothing to shade
+            Noise::GetNoiseRow<Type, Distribution>(constants, source, x, row, width, noise[0], noise[1], noise[2]);
+            Quantize::Pack_Row(settings.layout, noise[0], noise[1], noise[2], nullptr, width, dest);
+            continue;
+        }
+
+        if (Mode == TILE_MODE_DITHER)
+        {
+            Noise::GetNoiseRow<Type, Distribution>(constants, source, x, row, width, noise[0], noise[1], noise[2]);
+        }
+
+        if (Tonemap)
+        {
+            // The noise is added after tonemapping, so only an untonemapped color can take it while it is shaded
+            Shade_Row<false>(constants, x, row, width, nullptr, color[0], color[1], color[2]);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                Color::ACESFilm(color[c], color[c], width);
+                if (Mode == TILE_MODE_DITHER)
+                {
+                    for (uint32_t i = 0; i < width; i++) color[c][i] += noise[c][i];
+                }
+            }
+        }
+        else
+        {
+            Shade_Row<Mode == TILE_MODE_DITHER>(constants, x, row, width, noiseRows, color[0], color[1], color[2]);
+        }
+
+        for (uint32_t c = 0; c < 3; c++) Color::LinearToSRGB(settings.transferMode, color[c], color[c], width);
+        Quantize::Pack_Row(settings.layout, color[0], color[1], color[2], nullptr, width, dest);
+    }
+}
+
+// Kernels without dithering do not depend on the noise, so they share one instantiation per tonemap flag
+#define TILE_KERNELS_TONEMAP(type, distribution, tonemap) \
+    { \
+        Render_Tile_Kernel<NOISE_NONE, DISTRIBUTION_UNIFORM, tonemap, TILE_MODE_SHADE>, \
+        Render_Tile_Kernel<type, distribution, tonemap, TILE_MODE_DITHER>, \
+        Render_Tile_Kernel<type, distribution, false, TILE_MODE_SHOW_NOISE>, \
+    }
+
+#define TILE_KERNELS_DISTRIBUTION(type, distribution) \
+    { TILE_KERNELS_TONEMAP(type, distribution, false), TILE_KERNELS_TONEMAP(type, distribution, true) }
+
+#define TILE_KERNELS(type) \
+    { TILE_KERNELS_DISTRIBUTION(type, DISTRIBUTION_UNIFORM), TILE_KERNELS_DISTRIBUTION(type, DISTRIBUTION_TRIANGULAR) }
+
+static const TileKernel tileKernels[NOISE_TYPE_COUNT][DISTRIBUTION_COUNT][2][TILE_MODE_COUNT] =
+{
+    TILE_KERNELS(NOISE_WHITE),
+    TILE_KERNELS(NOISE_BLUE),
+    TILE_KERNELS(NOISE_LDS_BLUE),
+    TILE_KERNELS(NOISE_SPATIOTEMPORAL_BLUE),
+    TILE_KERNELS(NOISE_ORDERED),
+    TILE_KERNELS(NOISE_NONE),
+};
+
+#undef TILE_KERNELS
+#undef TILE_KERNELS_DISTRIBUTION
+#undef TILE_KERNELS_TONEMAP
+
+/**
+* Select the tile kernel for the flags in the constants.
+*/
+static TileKernel Select_Kernel(const BandingConstants &constants, const NoiseSource &source)
+{
+    TileMode mode = TILE_MODE_SHADE;
+    if (constants.useDithering > 0) mode = constants.showNoise ? TILE_MODE_SHOW_NOISE : TILE_MODE_DITHER;
+    return tileKernels[source.type][Noise::GetDistribution(constants)][constants.useTonemapping ? 1 : 0][mode];
+}
+
+/**
+* Render one tile of the frame. Tiles are numbered in row-major order. The kernel is selected
+* on every call, so Render_Frame() selects it once and calls it directly.
+*/
+void Render_Tile(const BandingConstants &constants, const SoftwareSettings &settings, const NoiseTextures &textures, SoftwareFrame &frame, uint32_t tileIndex)
+{
+    const NoiseSource source = Noise::GetNoiseSource(constants, textures);
+    Select_Kernel(constants, source)(constants, settings, source, frame, tileIndex);
+}
+
+/**
+* Render a frame, distributing tiles across the thread pool.
+*/
+void Render_Frame(ThreadPool &pool, const BandingConstants &constants, const SoftwareSettings &settings, const NoiseTextures &textures, SoftwareFrame &frame)
+{
+    if (constants.useDithering > 0)
+    {
+        if ((constants.noiseType == 1 && textures.blueNoiseArray.empty()) || (constants.noiseType == 2 && textures.blueNoise.width == 0) ||
+            (constants.noiseType == 3 && textures.spatiotemporalArray.empty()))
+        {
+            throw runtime_error("Error: blue noise textures are not loaded!");
+        }
+        if (constants.noiseType == 4 && textures.thresholdMatrix.thresholds.empty() && !Noise::GetBayerMatrix(constants.ditherMatrixSize))
+        {
+            throw runtime_error("Error: ordered dither matrix size must be a power of two from 2 to 64!");
+        }
+    }
+
+    if (frame.bytesPerPixel != settings.layout.bytesPerPixel)
+    {
+        throw runtime_error("Error: frame was not created for the pixel layout!");
+    }
+
+    const uint32_t tilesX = (frame.width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    const uint32_t tilesY = (frame.height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+
+    // Without dithering the noise textures may not be loaded, and are not read
+    const NoiseSource source = (constants.useDithering > 0) ? Noise::GetNoiseSource(constants, textures) : NoiseSource();
+    const TileKernel kernel = Select_Kernel(constants, source);
+
+    Threading::Parallel_For(pool, tilesX * tilesY, [&](uint32_t tileIndex)
+    {
+        kernel(constants, settings, source, frame, tileIndex);
+    });
+}
+
+/**
+* Render the float reference of a frame: the same shading, tonemapping, and gamma correction
+* as Render_Frame(), without dithering or quantization.
+*/
+void Render_Reference(ThreadPool &pool, const BandingConstants &constants, const SoftwareSettings &settings, ReferenceFrame &frame)
+{
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        if (frame.planes[c].size() != (size_t)frame.width * frame.height) throw runtime_error("Error: reference frame planes do not match its size!");
+    }
+
+    Threading::Parallel_For(pool, frame.height, [&](uint32_t y)
+    {
+        float* channels[3];
+        for (uint32_t c = 0; c < 3; c++) channels[c] = &frame.planes[c][(size_t)y * frame.width];
+
+        Shade_Row(constants, 0, y, frame.width, channels[0], channels[1], channels[2]);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            if (constants.useTonemapping) Color::ACESFilm(channels[c], channels[c], frame.width);
+            Color::LinearToSRGB(settings.transferMode, channels[c], channels[c], frame.width);
+        }
+    });
+}
+
+}
@@ -0,0 +1,275 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Spectrum.h"
+#include "Noise.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Spectrum
+{
+
+static const uint32_t ROW_BAND_SIZE = 8;
+static const double PI = 3.14159265358979323846;
+
+// Range of the spectrum image, in dB relative to the mean power
+static const float IMAGE_MIN_DB = -20.f;
+static const float IMAGE_MAX_DB = 10.f;
+
+/**
+* Twiddle factors e^(-2 pi i k / size) for k in [0, size / 2), conjugated for the inverse.
+*/
+static vector<complex<float>> Get_Twiddles(uint32_t size, bool inverse)
+{
+    vector<complex<float>> twiddles(size / 2);
+    const double sign = inverse ? 1.0 : -1.0;
+    for (uint32_t k = 0; k < (size / 2); k++)
+    {
+        const double angle = sign * 2.0 * PI * (double)k / (double)size;
+        twiddles[k] = complex<float>((float)cos(angle), (float)sin(angle));
+    }
+    return twiddles;
+}
+
+/**
+* In place radix-2 FFT of a power of two sized array, unscaled in both directions.
+*/
+static void FFT(complex<float>* data, uint32_t size, const complex<float>* twiddles)
+{
+    // Bit reversal permutation
+    for (uint32_t i = 1, j = 0; i < size; i++)
+    {
+        uint32_t bit = size >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) swap(data[i], data[j]);
+    }
+
+    for (uint32_t length = 2; length <= size; length <<= 1)
+    {
+        const uint32_t half = length >> 1;
+        const uint32_t step = size / length;
+        for (uint32_t start = 0; start < size; start += length)
+        {
+            for (uint32_t k = 0; k < half; k++)
+            {
+                const complex<float> odd = data[start + k + half] * twiddles[k * step];
+                data[start + k + half] = data[start + k] - odd;
+                data[start + k] += odd;
+            }
+        }
+    }
+}
+
+static void Validate_Size(uint32_t size)
+{
+    if (size < 2 || size > SPECTRUM_MAX_SIZE || (size & (size - 1)) != 0)
+    {
+        throw runtime_error("Error: FFT size must be a power of two up to 4096!");
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Public Functions
+//--------------------------------------------------------------------------------------
+
+/**
+* In place FFT of a power of two sized array. Neither direction is scaled.
+*/
+void FFT(complex<float>* data, uint32_t size, bool inverse)
+{
+    Validate_Size(size);
+    const vector<complex<float>> twiddles = Get_Twiddles(size, inverse);
+    FFT(data, size, twiddles.data());
+}
+
+/**
+* In place 2D FFT of a size x size array, rows then columns, split across the pool. Neither direction is scaled.
+*/
+void FFT_2D(ThreadPool &pool, complex<float>* data, uint32_t size, bool inverse)
+{
+    Validate_Size(size);
+    const vector<complex<float>> twiddles = Get_Twiddles(size, inverse);
+    const uint32_t numBands = (size + ROW_BAND_SIZE - 1) / ROW_BAND_SIZE;
+
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        const uint32_t end = min(size, (band + 1) * ROW_BAND_SIZE);
+        for (uint32_t y = band * ROW_BAND_SIZE; y < end; y++) FFT(&data[(size_t)y * size], size, twiddles.data());
+    });
+
+    // Columns are copied out a band at a time, so each row of the band is read in one pass
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        const uint32_t start = band * ROW_BAND_SIZE;
+        const uint32_t count = min(size, start + ROW_BAND_SIZE) - start;
+        vector<complex<float>> columns((size_t)count * size);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t i = 0; i < count; i++) columns[(size_t)i * size + y] = data[(size_t)y * size + start + i];
+        }
+        for (uint32_t i = 0; i < count; i++) FFT(&columns[(size_t)i * size], size, twiddles.data());
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t i = 0; i < count; i++) data[(size_t)y * size + start + i] = columns[(size_t)i * size + y];
+        }
+    });
+}
+
+/**
+* Average the power spectrum of frames of noise, starting at the frame number of constants,
+* over a size x size area at the top left of the frame.
+*/
+NoiseSpectrum Analyze_Noise(ThreadPool &pool, const BandingConstants &constants, const NoiseTextures &textures, uint32_t size, uint32_t frames)
+{
+    if (size < SPECTRUM_MIN_SIZE) throw runtime_error("Error: spectrum size must be at least 8!");
+    Validate_Size(size);
+    if (frames == 0) throw runtime_error("Error: no frames to analyze!");
+
+    auto start = chrono::high_resolution_clock::now();
+
+    const size_t numPixels = (size_t)size * size;
+    const uint32_t numBands = (size + ROW_BAND_SIZE - 1) / ROW_BAND_SIZE;
+    vector<float> planes[3] = { vector<float>(numPixels), vector<float>(numPixels), vector<float>(numPixels) };
+    vector<complex<float>> transform(numPixels);
+    vector<double> power(numPixels, 0.0);
+
+    BandingConstants frameConstants = constants;
+    frameConstants.noiseScale = 1.f;
+
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        frameConstants.frameNumber = constants.frameNumber + frame;
+        Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+        {
+            const uint32_t end = min(size, (band + 1) * ROW_BAND_SIZE);
+            for (uint32_t y = band * ROW_BAND_SIZE; y < end; y++)
+            {
+                const size_t offset = (size_t)y * size;
+                Noise::GetNoiseRow(frameConstants, textures, 0, y, size, &planes[0][offset], &planes[1][offset], &planes[2][offset]);
+            }
+        });
+
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            double mean = 0.0;
+            for (float value : planes[c]) mean += (double)value;
+            mean /= (double)numPixels;
+
+            for (size_t i = 0; i < numPixels; i++) transform[i] = complex<float>(planes[c][i] - (float)mean, 0.f);
+            FFT_2D(pool, transform.data(), size);
+
+            Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+            {
+                const size_t end = (size_t)min(size, (band + 1) * ROW_BAND_SIZE) * size;
+                for (size_t i = (size_t)band * ROW_BAND_SIZE * size; i < end; i++) power[i] += (double)norm(transform[i]);
+            });
+        }
+    }
+
+    NoiseSpectrum spectrum;
+    spectrum.size = size;
+    spectrum.frames = frames;
+    spectrum.power.resize(numPixels);
+    spectrum.radial.assign(size / 2 + 1, 0.f);
+
+    // Normalize, move DC to the center, and sum the rings
+    const double scale = 1.0 / ((double)numPixels * frames * 3.0);
+    const int half = (int)(size / 2);
+    const double lowRadius = (double)size / 8.0;
+    vector<double> rings(size / 2 + 1, 0.0);
+    vector<uint32_t> ringCounts(size / 2 + 1, 0);
+    double total = 0.0;
+    double low = 0.0;
+    uint32_t lowCount = 0;
+    for (uint32_t v = 0; v < size; v++)
+    {
+        const int fy = ((int)v < half) ? (int)v : (int)v - (int)size;
+        for (uint32_t u = 0; u < size; u++)
+        {
+            const int fx = ((int)u < half) ? (int)u : (int)u - (int)size;
+            const double value = power[(size_t)v * size + u] * scale;
+            spectrum.power[(size_t)(fy + half) * size + (fx + half)] = (float)value;
+            if (fx == 0 && fy == 0) continue;
+
+            total += value;
+            const double radius = sqrt((double)(fx * fx + fy * fy));
+            const uint32_t ring = (uint32_t)(radius + 0.5);
+            if (ring <= (uint32_t)half)
+            {
+                rings[ring] += value;
+                ringCounts[ring]++;
+            }
+            if (radius < lowRadius)
+            {
+                low += value;
+                lowCount++;
+            }
+        }
+    }
+
+    spectrum.meanPower = total / (double)(numPixels - 1);
+    if (spectrum.meanPower > 0.0)
+    {
+        for (uint32_t ring = 0; ring <= (uint32_t)half; ring++)
+        {
+            if (ringCounts[ring] > 0) spectrum.radial[ring] = (float)((rings[ring] / ringCounts[ring]) / spectrum.meanPower);
+        }
+        spectrum.blueness = 1.0 - ((low / lowCount) / spectrum.meanPower);
+    }
+
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    spectrum.milliseconds = elapsed.count();
+    return spectrum;
+}
+
+/**
+* Write the power spectrum as a grayscale PNG, with DC at the center, in dB relative to the
+* mean power from IMAGE_MIN_DB (black) to IMAGE_MAX_DB (white).
+*/
+void Write_Spectrum(const string &filepath, const NoiseSpectrum &spectrum)
+{
+    if (spectrum.power.empty()) throw runtime_error("Error: spectrum is empty!");
+
+    vector<uint8_t> pixels(spectrum.power.size());
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        const double relative = (double)spectrum.power[i] / max(spectrum.meanPower, 1e-30);
+        const float db = (float)(10.0 * log10(max(relative, 1e-30)));
+        const float value = min(max((db - IMAGE_MIN_DB) / (IMAGE_MAX_DB - IMAGE_MIN_DB), 0.f), 1.f);
+        pixels[i] = (uint8_t)(value * 255.f + 0.5f);
+    }
+    Utils::WritePNG(filepath, pixels.data(), (int)spectrum.size, (int)spectrum.size, 1);
+}
+
+}
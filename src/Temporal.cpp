@@ -0,0 +1,360 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Temporal.h"
+#include "Quantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Temporal
+{
+
+static const uint32_t ROW_BAND_SIZE = 16;
+
+/**
+* Values one row of one channel needs to be updated.
+*/
+struct RowState
+{
+    const float* x;
+    const float* reference;
+    float* mean;
+    float* m2;
+    float* previous;
+    float* eye[TEMPORAL_MAX_RATES];
+};
+
+/**
+* Partial sums of squared errors, for one band of rows.
+*/
+struct BandSums
+{
+    double convergence = 0.0;
+    double flicker = 0.0;
+    double eye[TEMPORAL_MAX_RATES] = {};
+};
+
+//--------------------------------------------------------------------------------------
+// Update Kernels
+// Add a row of values to the running mean (Welford's method), the frame to frame change,
+// and the eye filters. On the first frame, inverseCount and the alphas are 1, so every
+// statistic starts at x, and the flicker weight is 0.
+//--------------------------------------------------------------------------------------
+
+static void Update_Row_Scalar(const RowState &row, uint32_t numRates, const float* alphas, float inverseCount, float flickerWeight, uint32_t start, uint32_t count, BandSums &sums)
+{
+    for (uint32_t i = start; i < count; i++)
+    {
+        const float x = row.x[i];
+        const float delta = x - row.mean[i];
+        row.mean[i] += delta * inverseCount;
+        row.m2[i] += delta * (x - row.mean[i]);
+
+        const float error = row.mean[i] - row.reference[i];
+        sums.convergence += (double)(error * error);
+
+        const float change = (x - row.previous[i]) * flickerWeight;
+        sums.flicker += (double)(change * change);
+        row.previous[i] = x;
+
+        for (uint32_t rate = 0; rate < numRates; rate++)
+        {
+            row.eye[rate][i] += alphas[rate] * (x - row.eye[rate][i]);
+            const float eyeError = row.eye[rate][i] - row.reference[i];
+            sums.eye[rate] += (double)(eyeError * eyeError);
+        }
+    }
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_AVX2 static inline double Sum_AVX2(__m256 x)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return (double)_mm_cvtss_f32(sum);
+}
+
+/**
+* Eight values at a time. The squared errors are summed in float for one row, then added
+* to the band sums in double.
+*/
+SIMD_TARGET_AVX2 static void Update_Row_AVX2(const RowState &row, uint32_t numRates, const float* alphas, float inverseCount, float flickerWeight, uint32_t count, BandSums &sums)
+{
+    const __m256 vInverseCount = _mm256_set1_ps(inverseCount);
+    const __m256 vFlickerWeight = _mm256_set1_ps(flickerWeight);
+    __m256 vAlphas[TEMPORAL_MAX_RATES];
+    __m256 eyeSums[TEMPORAL_MAX_RATES];
+    for (uint32_t rate = 0; rate < numRates; rate++)
+    {
+        vAlphas[rate] = _mm256_set1_ps(alphas[rate]);
+        eyeSums[rate] = _mm256_setzero_ps();
+    }
+    __m256 convergence = _mm256_setzero_ps();
+    __m256 flicker = _mm256_setzero_ps();
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(row.x + i);
+        const __m256 reference = _mm256_loadu_ps(row.reference + i);
+
+        const __m256 delta = _mm256_sub_ps(x, _mm256_loadu_ps(row.mean + i));
+        const __m256 mean = _mm256_add_ps(_mm256_loadu_ps(row.mean + i), _mm256_mul_ps(delta, vInverseCount));
+        _mm256_storeu_ps(row.mean + i, mean);
+        _mm256_storeu_ps(row.m2 + i, _mm256_add_ps(_mm256_loadu_ps(row.m2 + i), _mm256_mul_ps(delta, _mm256_sub_ps(x, mean))));
+
+        const __m256 error = _mm256_sub_ps(mean, reference);
+        convergence = _mm256_add_ps(convergence, _mm256_mul_ps(error, error));
+
+        const __m256 change = _mm256_mul_ps(_mm256_sub_ps(x, _mm256_loadu_ps(row.previous + i)), vFlickerWeight);
+        flicker = _mm256_add_ps(flicker, _mm256_mul_ps(change, change));
+        _mm256_storeu_ps(row.previous + i, x);
+
+        for (uint32_t rate = 0; rate < numRates; rate++)
+        {
+            const __m256 eye = _mm256_loadu_ps(row.eye[rate] + i);
+            const __m256 filtered = _mm256_add_ps(eye, _mm256_mul_ps(vAlphas[rate], _mm256_sub_ps(x, eye)));
+            _mm256_storeu_ps(row.eye[rate] + i, filtered);
+            const __m256 eyeError = _mm256_sub_ps(filtered, reference);
+            eyeSums[rate] = _mm256_add_ps(eyeSums[rate], _mm256_mul_ps(eyeError, eyeError));
+        }
+    }
+
+    sums.convergence += Sum_AVX2(convergence);
+    sums.flicker += Sum_AVX2(flicker);
+    for (uint32_t rate = 0; rate < numRates; rate++) sums.eye[rate] += Sum_AVX2(eyeSums[rate]);
+    Update_Row_Scalar(row, numRates, alphas, inverseCount, flickerWeight, i, count, sums);
+}
+
+#endif
+
+//--------------------------------------------------------------------------------------
+// Public Functions
+//--------------------------------------------------------------------------------------
+
+/**
+* Create an accumulator for frames of the reference's size. The reference must outlive it.
+*/
+void Create_Accumulator(TemporalAccumulator &accumulator, const ReferenceFrame &reference, const TemporalSettings &settings)
+{
+    if (settings.numRates > TEMPORAL_MAX_RATES) throw runtime_error("Error: too many refresh rates!");
+    for (uint32_t rate = 0; rate < settings.numRates; rate++)
+    {
+        if (settings.refreshRates[rate] <= 0.f) throw runtime_error("Error: refresh rates must be positive!");
+    }
+    if (settings.eyeTimeConstant <= 0.f) throw runtime_error("Error: eye time constant must be positive!");
+
+    accumulator = TemporalAccumulator();
+    accumulator.settings = settings;
+    accumulator.reference = &reference;
+    accumulator.width = reference.width;
+    accumulator.height = reference.height;
+
+    const size_t numPixels = (size_t)reference.width * reference.height;
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        accumulator.mean[c].assign(numPixels, 0.f);
+        accumulator.m2[c].assign(numPixels, 0.f);
+        accumulator.previous[c].assign(numPixels, 0.f);
+        for (uint32_t rate = 0; rate < settings.numRates; rate++) accumulator.eye[rate][c].assign(numPixels, 0.f);
+    }
+}
+
+/**
+* Add a frame, packed with layout, to the accumulator with the given instruction set.
+*/
+void Accumulate(ThreadPool &pool, SimdLevel level, TemporalAccumulator &accumulator, const SoftwareFrame &frame, const PixelLayout &layout)
+{
+    if (frame.width != accumulator.width || frame.height != accumulator.height) throw runtime_error("Error: frame and accumulator sizes do not match!");
+    if (frame.bytesPerPixel != layout.bytesPerPixel) throw runtime_error("Error: frame was not created for the pixel layout!");
+
+    const double maxCode = (double)((1u << Quantize::Get_Color_Bits(layout)) - 1);
+    if (accumulator.frames > 0 && maxCode != accumulator.maxCode) throw runtime_error("Error: frames were packed with different depths!");
+    accumulator.maxCode = maxCode;
+
+    const bool first = (accumulator.frames == 0);
+    accumulator.frames++;
+
+    const TemporalSettings &settings = accumulator.settings;
+    const float inverseCount = 1.f / (float)accumulator.frames;
+    const float flickerWeight = first ? 0.f : 1.f;
+    float alphas[TEMPORAL_MAX_RATES] = {};
+    for (uint32_t rate = 0; rate < settings.numRates; rate++)
+    {
+        alphas[rate] = first ? 1.f : (float)(1.0 - exp(-1.0 / ((double)settings.refreshRates[rate] * settings.eyeTimeConstant)));
+    }
+
+    const uint32_t width = frame.width;
+    const uint32_t numBands = (frame.height + ROW_BAND_SIZE - 1) / ROW_BAND_SIZE;
+    vector<BandSums> bands(numBands);
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        vector<float> planes[3] = { vector<float>(width), vector<float>(width), vector<float>(width) };
+        const uint32_t end = min(frame.height, (band + 1) * ROW_BAND_SIZE);
+        for (uint32_t y = band * ROW_BAND_SIZE; y < end; y++)
+        {
+            Quantize::Unpack_Row(level, layout, &frame.pixels[(size_t)y * frame.rowPitch], width, planes[0].data(), planes[1].data(), planes[2].data(), nullptr);
+
+            const size_t offset = (size_t)y * width;
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                RowState row;
+                row.x = planes[c].data();
+                row.reference = &accumulator.reference->planes[c][offset];
+                row.mean = &accumulator.mean[c][offset];
+                row.m2 = &accumulator.m2[c][offset];
+                row.previous = &accumulator.previous[c][offset];
+                for (uint32_t rate = 0; rate < settings.numRates; rate++) row.eye[rate] = &accumulator.eye[rate][c][offset];
+#if SIMD_X86
+                if (level >= SIMD_AVX2)
+                {
+                    Update_Row_AVX2(row, settings.numRates, alphas, inverseCount, flickerWeight, width, bands[band]);
+                    continue;
+                }
+#endif
+                Update_Row_Scalar(row, settings.numRates, alphas, inverseCount, flickerWeight, 0, width, bands[band]);
+            }
+        }
+    });
+
+    // Combine the partial sums in order
+    BandSums total;
+    for (const BandSums &band : bands)
+    {
+        total.convergence += band.convergence;
+        total.flicker += band.flicker;
+        for (uint32_t rate = 0; rate < settings.numRates; rate++) total.eye[rate] += band.eye[rate];
+    }
+
+    const double numValues = 3.0 * width * frame.height;
+    accumulator.flicker += total.flicker;
+    accumulator.convergence.push_back(sqrt(total.convergence / numValues) * maxCode);
+    for (uint32_t rate = 0; rate < settings.numRates; rate++)
+    {
+        accumulator.eyeError[rate].push_back(sqrt(total.eye[rate] / numValues) * maxCode);
+    }
+}
+
+/**
+* Add a frame, packed with layout, to the accumulator.
+*/
+void Accumulate(ThreadPool &pool, TemporalAccumulator &accumulator, const SoftwareFrame &frame, const PixelLayout &layout)
+{
+    Accumulate(pool, Simd::Get_Level(), accumulator, frame, layout);
+}
+
+/**
+* Get the bias of the mean of one value against the reference, in steps.
+*/
+float Get_Bias(const TemporalAccumulator &accumulator, uint32_t channel, size_t index)
+{
+    return (float)((double)(accumulator.mean[channel][index] - accumulator.reference->planes[channel][index]) * accumulator.maxCode);
+}
+
+/**
+* Get the variance of one value over the frames, in squared steps.
+*/
+float Get_Variance(const TemporalAccumulator &accumulator, uint32_t channel, size_t index)
+{
+    if (accumulator.frames < 2) return 0.f;
+    return (float)(((double)accumulator.m2[channel][index] / (accumulator.frames - 1)) * accumulator.maxCode * accumulator.maxCode);
+}
+
+/**
+* Summarize the accumulated frames.
+*/
+TemporalStats Get_Stats(ThreadPool &pool, const TemporalAccumulator &accumulator)
+{
+    TemporalStats stats;
+    stats.frames = accumulator.frames;
+    if (accumulator.frames == 0) return stats;
+
+    struct BandStats
+    {
+        double bias = 0.0;
+        double squaredBias = 0.0;
+        double maxBias = 0.0;
+        double variance = 0.0;
+    };
+
+    const uint32_t width = accumulator.width;
+    const uint32_t numBands = (accumulator.height + ROW_BAND_SIZE - 1) / ROW_BAND_SIZE;
+    vector<BandStats> bands(numBands);
+    Threading::Parallel_For(pool, numBands, [&](uint32_t band)
+    {
+        BandStats &result = bands[band];
+        const size_t start = (size_t)band * ROW_BAND_SIZE * width;
+        const size_t end = (size_t)min(accumulator.height, (band + 1) * ROW_BAND_SIZE) * width;
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            for (size_t i = start; i < end; i++)
+            {
+                const double bias = (double)Get_Bias(accumulator, c, i);
+                result.bias += bias;
+                result.squaredBias += bias * bias;
+                result.maxBias = max(result.maxBias, fabs(bias));
+                result.variance += (double)Get_Variance(accumulator, c, i);
+            }
+        }
+    });
+
+    BandStats total;
+    for (const BandStats &band : bands)
+    {
+        total.bias += band.bias;
+        total.squaredBias += band.squaredBias;
+        total.maxBias = max(total.maxBias, band.maxBias);
+        total.variance += band.variance;
+    }
+
+    const double numValues = 3.0 * width * accumulator.height;
+    stats.meanBias = total.bias / numValues;
+    stats.bias = sqrt(total.squaredBias / numValues);
+    stats.maxBias = total.maxBias;
+    stats.deviation = sqrt(total.variance / numValues);
+    if (accumulator.frames > 1) stats.flicker = sqrt(accumulator.flicker / (numValues * (accumulator.frames - 1))) * accumulator.maxCode;
+
+    // Average the eye filter error once it has settled, or take the last frame if it never did
+    const TemporalSettings &settings = accumulator.settings;
+    for (uint32_t rate = 0; rate < settings.numRates; rate++)
+    {
+        const vector<double> &errors = accumulator.eyeError[rate];
+        const size_t warmUp = min(errors.size() - 1, (size_t)ceil(TEMPORAL_WARM_UP * settings.eyeTimeConstant * settings.refreshRates[rate]));
+        double sum = 0.0;
+        for (size_t i = warmUp; i < errors.size(); i++) sum += errors[i];
+        stats.eyeError[rate] = sum / (double)(errors.size() - warmUp);
+    }
+    return stats;
+}
+
+}
@@ -0,0 +1,144 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Threading.h"
+
+using namespace std;
+
+namespace Threading
+{
+
+/**
+* Pull work items until the current job runs dry.
+*/
+static void Run_Items(ThreadPool &pool)
+{
+    uint32_t index;
+    while ((index = pool.next.fetch_add(1, memory_order_relaxed)) < pool.count)
+    {
+        (*pool.job)(index);
+    }
+}
+
+/**
+* Worker thread loop.
+*/
+static void Worker(ThreadPool* pool)
+{
+    uint64_t generation = 0;
+    while (true)
+    {
+        {
+            unique_lock<mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [&] { return pool->quit || pool->generation != generation; });
+            if (pool->quit) return;
+            generation = pool->generation;
+        }
+
+        Run_Items(*pool);
+
+        {
+            lock_guard<mutex> lock(pool->mutex);
+            if (--pool->active == 0) pool->done.notify_one();
+        }
+    }
+}
+
+/**
+* Create a pool of worker threads. The calling thread also executes work, so numThreads - 1 workers are spawned.
+* A thread count of zero uses every hardware thread.
+*/
+void Create(ThreadPool &pool, uint32_t numThreads)
+{
+    if (numThreads == 0) numThreads = thread::hardware_concurrency();
+    if (numThreads == 0) numThreads = 1;
+
+    pool.quit = false;
+    pool.threads.reserve(numThreads - 1);
+    for (uint32_t i = 1; i < numThreads; i++)
+    {
+        pool.threads.emplace_back(Worker, &pool);
+    }
+}
+
+/**
+* Execute job(i) for every i in [0, count) across the pool and wait for completion.
+*/
+void Parallel_For(ThreadPool &pool, uint32_t count, const function<void(uint32_t)> &job)
+{
+    if (count == 0) return;
+    if (pool.threads.empty() || count == 1)
+    {
+        for (uint32_t i = 0; i < count; i++) job(i);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(pool.mutex);
+        pool.job = &job;
+        pool.count = count;
+        pool.next.store(0, memory_order_relaxed);
+        pool.active = (uint32_t)pool.threads.size();
+        pool.generation++;
+    }
+    pool.wake.notify_all();
+
+    Run_Items(pool);
+
+    // Wait for the workers to check in
+    unique_lock<mutex> lock(pool.mutex);
+    pool.done.wait(lock, [&] { return pool.active == 0; });
+    pool.job = nullptr;
+}
+
+/**
+* Get the number of threads that execute work, including the calling thread.
+*/
+uint32_t Get_Thread_Count(const ThreadPool &pool)
+{
+    return (uint32_t)pool.threads.size() + 1;
+}
+
+/**
+* Stop and join the worker threads.
+*/
+void Destroy(ThreadPool &pool)
+{
+    {
+        lock_guard<mutex> lock(pool.mutex);
+        pool.quit = true;
+    }
+    pool.wake.notify_all();
+
+    for (thread &t : pool.threads)
+    {
+        t.join();
+    }
+    pool.threads.clear();
+}
+
+}
@@ -32,6 +32,8 @@
 #include "imgui_impl_dx12.h"
 
 #include "UI.h"
+#include "Graphics.h"
+#include "Quantize.h"
 
 // Helper to display a (?) mark that shows a tooltip when hovered
 static void ShowHelpMarker(const char* desc)
@@ -53,6 +55,9 @@ void CreateDebugWindow(D3D12Global &d3d, BandingConstants &constants, bool &anim
     bool showNoiseCheckBox = constants.showNoise;
     bool useTonemappingCheckBox = constants.useTonemapping;
     bool useTriangularDistribution = constants.distributionType;
+    const int distributionType = constants.distributionType;
+    int ditherMatrixIndex = 0;
+    while ((2u << ditherMatrixIndex) < constants.ditherMatrixSize) ditherMatrixIndex++;
 
     ImGui::SetNextWindowSize(ImVec2(340, 0));
     ImGui::Begin("Debug Options and Performance", NULL, ImGuiWindowFlags_NoResize);
@@ -61,6 +66,9 @@ void CreateDebugWindow(D3D12Global &d3d, BandingConstants &constants, bool &anim
     ImGui::Checkbox("Vsync", &d3d.vsync);
     ImGui::SameLine(); ShowHelpMarker("Enable or disable vertical sync");
     ImGui::Checkbox("Animate Light", &animateLight);
+    ImGui::Text("Dither Pass: %.3f ms (GPU)", d3d.passTime);
+    ImGui::Checkbox("Compute Shader", &d3d.useCompute);
+    ImGui::SameLine(); ShowHelpMarker("Dither with a compute shader that writes a UAV, instead of rasterizing a fullscreen triangle");
 
     if (ImGui::Checkbox("Enable Tonemapping", &useTonemappingCheckBox))
     {
@@ -106,18 +114,52 @@ void CreateDebugWindow(D3D12Global &d3d, BandingConstants &constants, bool &anim
             }
         }
 
+        ImGui::RadioButton("Spatiotemporal Blue Noise", &constants.noiseType, 3);
+        ImGui::SameLine(); ShowHelpMarker("Blue over space and time, so it averages out faster and needs a smaller noise scale on high refresh rate displays");
+        if (constants.noiseType == 3)
+        {
+            ImGui::SetCursorPosX(30);
+            if (ImGui::Checkbox("Use Triangular Distribution", &useTriangularDistribution))
+            {
+                constants.distributionType = useTriangularDistribution ? 1 : 0;
+            }
+        }
+
+        ImGui::RadioButton("Ordered Dither", &constants.noiseType, 4);
+        ImGui::SameLine(); ShowHelpMarker("Bayer matrix dither, the cheapest option with no texture fetch or hash, but with a visible pattern");
+        if (constants.noiseType == 4)
+        {
+            ImGui::SetCursorPosX(30);
+            if (ImGui::Checkbox("Use Triangular Distribution", &useTriangularDistribution))
+            {
+                constants.distributionType = useTriangularDistribution ? 1 : 0;
+            }
+            ImGui::SetCursorPosX(30);
+            if (ImGui::Combo("Matrix Size", &ditherMatrixIndex, "2x2\0" "4x4\0" "8x8\0" "16x16\0" "32x32\0" "64x64\0\0"))
+            {
+                constants.ditherMatrixSize = (2u << ditherMatrixIndex);
+            }
+        }
+
         if (ImGui::Checkbox("Show Noise", &showNoiseCheckBox))
         {
             constants.showNoise = showNoiseCheckBox ? 1 : 0;
         }
 
+        // A triangular distribution needs twice the noise of a uniform distribution
+        const float noiseScale = Quantize::Get_Noise_Scale(Quantize::Get_Layout(d3d.backBufferFormat), constants.distributionType);
+        if (constants.distributionType != distributionType && !constants.showNoise)
+        {
+            constants.noiseScale = noiseScale;
+        }
+
         if (constants.showNoise)
         {
             constants.noiseScale = 1.f;
         }
         else 
         {
-            if(constants.noiseScale == 1.f) constants.noiseScale = (1.f / 256.f);
+            if(constants.noiseScale == 1.f) constants.noiseScale = noiseScale;
             ImGui::SliderFloat("Noise Scale", &constants.noiseScale, 0.f, 0.008f, "%.5f");
             ImGui::SameLine(); ShowHelpMarker("Change the magnitude of the noise");
         }
@@ -148,7 +190,7 @@ namespace UI
         ImGui_ImplDX12_Init(
             d3d.device,
             2,
-            DXGI_FORMAT_R8G8B8A8_UNORM,
+            D3D12::Get_BackBuffer_Format(d3d),
             resources.uiDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
             resources.uiDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
     }
@@ -28,18 +28,36 @@
 #pragma once
 
 #include "Utils.h"
+#include "Color.h"
+#include "Noise.h"
+#include "Simd.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <stdexcept>
+
+#ifdef _WIN32
 #include <shellapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 namespace Utils
 {
 
+#ifdef _WIN32
+
 //--------------------------------------------------------------------------------------
 // Command Line Parser
 //--------------------------------------------------------------------------------------
@@ -91,6 +109,42 @@ HRESULT ParseCommandLine(LPWSTR lpCmdLine, ConfigInfo &config)
                 continue;
             }
 
+            if (strcmp(str, "-bluenoise") == 0)
+            {
+                i++;
+                wcstombs(str, argv[i], 256);
+                config.blueNoiseSize = atoi(str);
+                i++;
+                continue;
+            }
+
+            if (strcmp(str, "-bits") == 0)
+            {
+                i++;
+                wcstombs(str, argv[i], 256);
+                config.backBufferFormat = (atoi(str) == 10) ? PIXEL_FORMAT_RGB10A2 : PIXEL_FORMAT_RGBA8;
+                i++;
+                continue;
+            }
+
+            if (strcmp(str, "-slices") == 0)
+            {
+                i++;
+                wcstombs(str, argv[i], 256);
+                config.blueNoiseSlices = atoi(str);
+                i++;
+                continue;
+            }
+
+            if (strcmp(str, "-compute") == 0)
+            {
+                i++;
+                wcstombs(str, argv[i], 256);
+                config.computeGroupSize = atoi(str);
+                i++;
+                continue;
+            }
+
             i++;
         }
     }
@@ -116,6 +170,8 @@ void Validate(HRESULT hr, LPWSTR msg)
     }
 }
 
+#endif
+
 //--------------------------------------------------------------------------------------
 // File Reading
 //--------------------------------------------------------------------------------------
@@ -139,51 +195,645 @@ vector<char> ReadFile(const string &filename)
     return buffer;
 }
 
+/**
+* Load an ordered dither threshold matrix from a text file of ranks, one per matrix element in
+* row major order, separated by whitespace or commas. The matrix must be square with a power of
+* two size from 2 to 64, and ranks run from 0 to size * size - 1.
+*/
+ThresholdMatrix LoadThresholdMatrix(const string &filepath)
+{
+    vector<char> text = ReadFile(filepath);
+    text.push_back('\0');
+
+    vector<uint32_t> ranks;
+    const char* cursor = text.data();
+    while (*cursor != '\0')
+    {
+        if (isspace((unsigned char)*cursor) || *cursor == ',')
+        {
+            cursor++;
+            continue;
+        }
+
+        char* end = nullptr;
+        const unsigned long rank = strtoul(cursor, &end, 10);
+        if (end == cursor) throw runtime_error("Error: threshold matrix contains a value that is not an integer!");
+        ranks.push_back((uint32_t)rank);
+        cursor = end;
+    }
+
+    // The noise kernels tile a matrix row from a BAYER_MAX_SIZE wide buffer on the stack
+    ThresholdMatrix matrix;
+    for (uint32_t size = BAYER_MIN_SIZE; size <= BAYER_MAX_SIZE; size *= 2)
+    {
+        if ((size * size) == ranks.size()) matrix.size = size;
+    }
+    if (matrix.size == 0) throw runtime_error("Error: threshold matrix must be square, with a power of two size from 2 to 64!");
+
+    const float levels = (float)ranks.size();
+    matrix.thresholds.resize(ranks.size());
+    for (size_t i = 0; i < ranks.size(); i++)
+    {
+        if (ranks[i] >= ranks.size()) throw runtime_error("Error: threshold matrix rank is out of range!");
+        matrix.thresholds[i] = ((float)ranks[i] + 0.5f) / levels;
+    }
+    return matrix;
+}
+
+/**
+* Map a whole file into memory, read only. Returns false if the file can't be opened or is empty.
+*/
+bool MapFile(const string &filepath, MappedFile &file)
+{
+    file = {};
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    // The view keeps the mapping alive, so both handles can be closed right away
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (mapping == NULL) return false;
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) return false;
+
+    file.data = (const uint8_t*)data;
+    file.size = (size_t)size.QuadPart;
+#else
+    const int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    file.data = (const uint8_t*)data;
+    file.size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void UnmapFile(MappedFile &file)
+{
+    if (!file.data) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(file.data);
+#else
+    munmap((void*)file.data, file.size);
+#endif
+    file = {};
+}
+
 //--------------------------------------------------------------------------------------
 // Textures
 //--------------------------------------------------------------------------------------
 
 /**
-* Format the loaded texture into the layout we use with D3D12.
+* Expand a row of 1 to 4 channel pixels to R8G8B8A8 with opaque alpha. Gray (and gray
+* alpha) pixels are replicated to RGB.
+*/
+static void ExpandToRGBA_Scalar(const uint8_t* src, int srcStride, uint8_t* dest, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint8_t* pixel = &src[i * srcStride];
+        const bool gray = (srcStride < 3);
+        dest[i * 4] = pixel[0];                         // R
+        dest[i * 4 + 1] = gray ? pixel[0] : pixel[1];   // G
+        dest[i * 4 + 2] = gray ? pixel[0] : pixel[2];   // B
+        dest[i * 4 + 3] = 0xFF;                         // A (always 1)
+    }
+}
+
+#if SIMD_X86
+/**
+* RGB to RGBA, eight pixels per iteration: each 128-bit lane loads four RGB pixels and
+* shuffles them into place, then alpha is set. Each load reads 16 bytes for 12 bytes of
+* pixels, so the loop stops early enough to stay inside the row.
 */
-void FormatTexture(TextureInfo &info, UINT8* pixels)
+SIMD_TARGET_AVX2 static uint32_t ExpandRGBToRGBA_AVX2(const uint8_t* src, uint8_t* dest, uint32_t count)
 {
-    const UINT numPixels = (info.width * info.height);
-    const UINT oldStride = info.stride;
-    const UINT oldSize = (numPixels * info.stride);
+    const __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+
+    uint32_t i = 0;
+    for (; (i + 11) <= count; i += 8)
+    {
+        const __m128i lo = _mm_loadu_si128((const __m128i*)&src[i * 3]);
+        const __m128i hi = _mm_loadu_si128((const __m128i*)&src[(i * 3) + 12]);
+        const __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        _mm256_storeu_si256((__m256i*)&dest[i * 4], _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+    }
+    return i;
+}
 
-    const UINT newStride = 4;                // uploading textures to GPU as DXGI_FORMAT_R8G8B8A8_UNORM
-    const UINT newSize = (numPixels * newStride);
-    info.pixels.resize(newSize);
+/**
+* RGBA to RGBA with opaque alpha, eight pixels per iteration.
+*/
+SIMD_TARGET_AVX2 static uint32_t ExpandRGBAToRGBA_AVX2(const uint8_t* src, uint8_t* dest, uint32_t count)
+{
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
 
-    for (UINT i = 0; i < numPixels; i++)
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8)
     {
-        info.pixels[i * newStride] = pixels[i * oldStride];            // R
-        info.pixels[i * newStride + 1] = pixels[i * oldStride + 1];    // G
-        info.pixels[i * newStride + 2] = pixels[i * oldStride + 2];    // B
-        info.pixels[i * newStride + 3] = 0xFF;                         // A (always 1)
+        const __m256i pixels = _mm256_loadu_si256((const __m256i*)&src[i * 4]);
+        _mm256_storeu_si256((__m256i*)&dest[i * 4], _mm256_or_si256(pixels, alpha));
     }
+    return i;
+}
+#endif
 
-    info.stride = newStride;
+/**
+* Expand a row of pixels to the R8G8B8A8 layout we use with D3D12.
+*/
+void ExpandToRGBA(const uint8_t* src, int srcStride, uint8_t* dest, uint32_t count)
+{
+    uint32_t done = 0;
+#if SIMD_X86
+    if (Simd::Get_Level() >= SIMD_AVX2)
+    {
+        if (srcStride == 3) done = ExpandRGBToRGBA_AVX2(src, dest, count);
+        else if (srcStride == 4) done = ExpandRGBAToRGBA_AVX2(src, dest, count);
+    }
+#endif
+    ExpandToRGBA_Scalar(&src[done * srcStride], srcStride, &dest[done * 4], count - done);
 }
 
 /**
-* Load an image from disk.
+* Decode an image as R8G8B8A8, one row every rowPitch bytes of the memory getDest returns.
+* The file is parsed once; getDest is called with the decoded size before any pixel is written,
+* so the caller can size a texture's own pixels or point at a mapped upload heap.
+* Returns the texture's size, its pixels are left empty.
 */
-TextureInfo LoadTexture(string filepath)
+TextureInfo DecodeTexture(const string &filepath, const function<PixelSpan(const TextureInfo&)> &getDest)
 {
     TextureInfo result = {};
 
     // Load image pixels with stb_image
-    UINT8* pixels = stbi_load(filepath.c_str(), &result.width, &result.height, &result.stride, STBI_default);
+    uint8_t* pixels = stbi_load(filepath.c_str(), &result.width, &result.height, &result.stride, STBI_default);
     if (!pixels)
     {
         throw runtime_error("Error: failed to load image!");
     }
 
-    FormatTexture(result, pixels);
+    const int srcStride = result.stride;
+    result.stride = 4;          // uploading textures to GPU as DXGI_FORMAT_R8G8B8A8_UNORM
+
+    const size_t rowSize = (size_t)result.width * 4;
+    PixelSpan dest;
+    try
+    {
+        dest = getDest(result);
+    }
+    catch (...)
+    {
+        stbi_image_free(pixels);
+        throw;
+    }
+
+    if (dest.rowPitch < rowSize || dest.size < (dest.rowPitch * (result.height - 1)) + rowSize)
+    {
+        stbi_image_free(pixels);
+        throw runtime_error("Error: image does not fit in the destination!");
+    }
+
+    for (int y = 0; y < result.height; y++)
+    {
+        ExpandToRGBA(&pixels[(size_t)y * result.width * srcStride], srcStride, &dest.data[y * dest.rowPitch], result.width);
+    }
+
     stbi_image_free(pixels);
     return result;
 }
 
+/**
+* Copy a texture into dest, one row every dest.rowPitch bytes.
+*/
+void CopyTexture(const TextureInfo &texture, const PixelSpan &dest)
+{
+    const size_t rowSize = (size_t)texture.width * texture.stride;
+    if (dest.rowPitch < rowSize || dest.size < (dest.rowPitch * (texture.height - 1)) + rowSize)
+    {
+        throw runtime_error("Error: texture does not fit in the destination!");
+    }
+
+    const uint8_t* pixels = texture.Get_Pixels();
+    if (dest.rowPitch == rowSize)
+    {
+        memcpy(dest.data, pixels, rowSize * texture.height);
+        return;
+    }
+
+    for (int y = 0; y < texture.height; y++)
+    {
+        memcpy(&dest.data[y * dest.rowPitch], &pixels[y * rowSize], rowSize);
+    }
+}
+
+/**
+* Load an image from disk, decoding it straight into the texture's pixels.
+*/
+TextureInfo LoadTexture(string filepath)
+{
+    TextureInfo result = {};
+    TextureInfo size = DecodeTexture(filepath, [&](const TextureInfo &decoded)
+    {
+        result.pixels.resize((size_t)decoded.width * decoded.height * decoded.stride);
+
+        PixelSpan dest;
+        dest.data = result.pixels.data();
+        dest.size = result.pixels.size();
+        dest.rowPitch = (size_t)decoded.width * decoded.stride;
+        return dest;
+    });
+
+    result.width = size.width;
+    result.height = size.height;
+    result.stride = size.stride;
+    return result;
+}
+
+static const uint8_t PNGSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+/**
+* Check the bit depth in the IHDR chunk, this version of stb_image has no stbi_is_16_bit().
+*/
+static bool Is16BitPNG(const string &filepath)
+{
+    ifstream file(filepath, ios::binary);
+    uint8_t header[25] = {};
+    if (!file.read((char*)header, sizeof(header))) return false;
+
+    // The signature is followed by the IHDR length, type, width, height, and then bit depth
+    return (memcmp(header, PNGSignature, 8) == 0) && (memcmp(&header[12], "IHDR", 4) == 0) && (header[24] == 16);
+}
+
+/**
+* Load an image from disk and convert it to linear float color.
+* Radiance .hdr files are already linear. 8-bit and 16-bit images are decoded from sRGB,
+* keeping all 16 bits (stbi_loadf would reduce them to 8).
+*/
+ImageInfo LoadLinearImage(string filepath)
+{
+    ImageInfo result = {};
+    const char* path = filepath.c_str();
+
+    if (stbi_is_hdr(path))
+    {
+        float* pixels = stbi_loadf(path, &result.width, &result.height, &result.stride, STBI_default);
+        if (!pixels)
+        {
+            throw runtime_error("Error: failed to load image!");
+        }
+
+        result.pixels.assign(pixels, pixels + ((size_t)result.width * result.height * result.stride));
+        stbi_image_free(pixels);
+        return result;
+    }
+
+    size_t numValues = 0;
+    if (Is16BitPNG(filepath))
+    {
+        uint16_t* pixels = stbi_load_16(path, &result.width, &result.height, &result.stride, STBI_default);
+        if (!pixels)
+        {
+            throw runtime_error("Error: failed to load image!");
+        }
+
+        numValues = (size_t)result.width * result.height * result.stride;
+        result.pixels.resize(numValues);
+        for (size_t i = 0; i < numValues; i++) result.pixels[i] = (float)pixels[i] / 65535.f;
+        stbi_image_free(pixels);
+    }
+    else
+    {
+        uint8_t* pixels = stbi_load(path, &result.width, &result.height, &result.stride, STBI_default);
+        if (!pixels)
+        {
+            throw runtime_error("Error: failed to load image!");
+        }
+
+        numValues = (size_t)result.width * result.height * result.stride;
+        result.pixels.resize(numValues);
+        for (size_t i = 0; i < numValues; i++) result.pixels[i] = (float)pixels[i] / 255.f;
+        stbi_image_free(pixels);
+    }
+
+    // Decode the color channels, grayscale and RGB images have no alpha
+    const bool hasAlpha = (result.stride == 2 || result.stride == 4);
+    if (!hasAlpha)
+    {
+        Color::SRGBToLinear(TRANSFER_POLYNOMIAL, result.pixels.data(), result.pixels.data(), (uint32_t)numValues);
+    }
+    else
+    {
+        const size_t numPixels = (size_t)result.width * result.height;
+        const int numColors = (result.stride - 1);
+        for (size_t i = 0; i < numPixels; i++)
+        {
+            float* pixel = &result.pixels[i * result.stride];
+            Color::SRGBToLinear(TRANSFER_POLYNOMIAL, pixel, pixel, numColors);
+        }
+    }
+    return result;
+}
+
+//--------------------------------------------------------------------------------------
+// PNG Writing
+// Filtered rows compressed with fixed Huffman codes and a single-probe hash for matches.
+// Not as small as a full deflate implementation, but fast and dependency free.
+//--------------------------------------------------------------------------------------
+
+struct BitWriter
+{
+    vector<uint8_t>* data = nullptr;
+    uint32_t bits = 0;
+    uint32_t count = 0;
+
+    void Write(uint32_t value, uint32_t numBits)
+    {
+        bits |= (value << count);
+        count += numBits;
+        while (count >= 8)
+        {
+            data->push_back((uint8_t)bits);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes are stored most significant bit first
+    void WriteCode(uint32_t code, uint32_t numBits)
+    {
+        uint32_t reversed = 0;
+        for (uint32_t i = 0; i < numBits; i++) reversed |= ((code >> i) & 1) << (numBits - 1 - i);
+        Write(reversed, numBits);
+    }
+
+    void Flush()
+    {
+        if (count > 0) data->push_back((uint8_t)bits);
+        bits = 0;
+        count = 0;
+    }
+};
+
+static const uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static void WriteLiteral(BitWriter &writer, uint32_t value)
+{
+    if (value < 144) writer.WriteCode(0x30 + value, 8);
+    else if (value < 256) writer.WriteCode(0x190 + (value - 144), 9);
+    else if (value < 280) writer.WriteCode(value - 256, 7);
+    else writer.WriteCode(0xC0 + (value - 280), 8);
+}
+
+static void WriteMatch(BitWriter &writer, uint32_t length, uint32_t distance)
+{
+    uint32_t code = 28;
+    while (LengthBase[code] > length) code--;
+    WriteLiteral(writer, 257 + code);
+    writer.Write(length - LengthBase[code], LengthExtra[code]);
+
+    code = 29;
+    while (DistanceBase[code] > distance) code--;
+    writer.WriteCode(code, 5);
+    writer.Write(distance - DistanceBase[code], DistanceExtra[code]);
+}
+
+/**
+* Compress data into a zlib stream.
+*/
+static vector<uint8_t> Deflate(const vector<uint8_t> &input)
+{
+    const uint32_t HASH_SIZE = (1 << 15);
+    const uint32_t WINDOW_SIZE = 32768;
+    const uint32_t MAX_MATCH = 258;
+
+    vector<uint8_t> output;
+    output.reserve(input.size() / 2 + 64);
+    output.push_back(0x78);                     // deflate, 32K window
+    output.push_back(0x01);                     // fastest compression, header checksum
+
+    BitWriter writer;
+    writer.data = &output;
+    writer.Write(1, 1);                         // final block
+    writer.Write(1, 2);                         // fixed Huffman codes
+
+    vector<int64_t> head(HASH_SIZE, -1);
+    const size_t size = input.size();
+    size_t i = 0;
+    while (i < size)
+    {
+        uint32_t bestLength = 0;
+        size_t bestDistance = 0;
+        if ((i + 3) <= size)
+        {
+            const uint32_t hash = ((input[i] << 16) | (input[i + 1] << 8) | input[i + 2]) * 2654435761u >> 17;
+            const int64_t candidate = head[hash];
+            head[hash] = (int64_t)i;
+
+            if (candidate >= 0 && (i - (size_t)candidate) <= WINDOW_SIZE)
+            {
+                const size_t limit = min((size_t)MAX_MATCH, size - i);
+                uint32_t length = 0;
+                while (length < limit && input[(size_t)candidate + length] == input[i + length]) length++;
+                if (length >= 3)
+                {
+                    bestLength = length;
+                    bestDistance = i - (size_t)candidate;
+                }
+            }
+        }
+
+        if (bestLength > 0)
+        {
+            WriteMatch(writer, bestLength, (uint32_t)bestDistance);
+            i += bestLength;
+        }
+        else
+        {
+            WriteLiteral(writer, input[i]);
+            i++;
+        }
+    }
+
+    WriteLiteral(writer, 256);                  // end of block
+    writer.Flush();
+
+    // Adler-32 of the uncompressed data
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (size_t offset = 0; offset < size; offset += 5552)
+    {
+        const size_t end = min(size, offset + 5552);
+        for (size_t j = offset; j < end; j++)
+        {
+            a += input[j];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    const uint32_t adler = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8) output.push_back((uint8_t)(adler >> shift));
+    return output;
+}
+
+static uint32_t CRC32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    static uint32_t table[256] = {};
+    static const bool initialized = []()
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            table[n] = c;
+        }
+        return true;
+    }();
+    (void)initialized;
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void WriteChunk(ofstream &file, const char* type, const uint8_t* data, size_t size)
+{
+    uint8_t header[8];
+    for (int i = 0; i < 4; i++) header[i] = (uint8_t)((uint32_t)size >> (24 - i * 8));
+    memcpy(&header[4], type, 4);
+
+    uint32_t crc = CRC32(&header[4], 4);
+    crc = CRC32(data, size, crc);
+
+    uint8_t footer[4];
+    for (int i = 0; i < 4; i++) footer[i] = (uint8_t)(crc >> (24 - i * 8));
+
+    file.write((const char*)header, 8);
+    file.write((const char*)data, size);
+    file.write((const char*)footer, 4);
+}
+
+static uint8_t Paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = abs(p - a);
+    const int pb = abs(p - b);
+    const int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    if (pb <= pc) return (uint8_t)b;
+    return (uint8_t)c;
+}
+
+/**
+* Write 8-bit pixels to a PNG file. Stride is the number of channels: 1 (gray), 2 (gray, alpha), 3 (RGB), or 4 (RGBA).
+*/
+void WritePNG(const string &filepath, const uint8_t* pixels, int width, int height, int stride)
+{
+    static const uint8_t colorTypes[5] = { 0, 0, 4, 2, 6 };
+    if (width <= 0 || height <= 0 || stride < 1 || stride > 4)
+    {
+        throw runtime_error("Error: invalid PNG dimensions!");
+    }
+
+    // Filter each row with whichever of the five filters gives the smallest sum of absolute values
+    const size_t rowSize = (size_t)width * stride;
+    vector<uint8_t> filtered((rowSize + 1) * height);
+    vector<uint8_t> candidate(rowSize);
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t* row = pixels + (size_t)y * rowSize;
+        const uint8_t* prev = (y > 0) ? (row - rowSize) : nullptr;
+        uint8_t* dest = &filtered[(size_t)y * (rowSize + 1)];
+
+        uint64_t bestSum = UINT64_MAX;
+        for (uint8_t filter = 0; filter < 5; filter++)
+        {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < rowSize; i++)
+            {
+                const int a = (i >= (size_t)stride) ? row[i - stride] : 0;
+                const int b = prev ? prev[i] : 0;
+                const int c = (prev && i >= (size_t)stride) ? prev[i - stride] : 0;
+
+                uint8_t value = row[i];
+                if (filter == 1) value = (uint8_t)(row[i] - a);
+                else if (filter == 2) value = (uint8_t)(row[i] - b);
+                else if (filter == 3) value = (uint8_t)(row[i] - ((a + b) >> 1));
+                else if (filter == 4) value = (uint8_t)(row[i] - Paeth(a, b, c));
+
+                candidate[i] = value;
+                sum += (value < 128) ? value : (256 - value);
+            }
+
+            if (sum < bestSum)
+            {
+                bestSum = sum;
+                dest[0] = filter;
+                memcpy(dest + 1, candidate.data(), rowSize);
+            }
+        }
+    }
+
+    ofstream file(filepath, ios::binary);
+    if (!file.is_open())
+    {
+        throw runtime_error("Error: failed to open file for writing!");
+    }
+
+    file.write((const char*)PNGSignature, 8);
+
+    vector<uint8_t> header(13);
+    for (int i = 0; i < 4; i++)
+    {
+        header[i] = (uint8_t)(width >> (24 - i * 8));
+        header[4 + i] = (uint8_t)(height >> (24 - i * 8));
+    }
+    header[8] = 8;                              // bit depth
+    header[9] = colorTypes[stride];
+    WriteChunk(file, "IHDR", header.data(), header.size());
+
+    // Chunks are limited to 2^31 bytes, so split large images
+    const vector<uint8_t> compressed = Deflate(filtered);
+    const size_t CHUNK_SIZE = (1 << 30);
+    for (size_t offset = 0; offset < compressed.size(); offset += CHUNK_SIZE)
+    {
+        const size_t end = min(compressed.size(), offset + CHUNK_SIZE);
+        WriteChunk(file, "IDAT", &compressed[offset], end - offset);
+    }
+    WriteChunk(file, "IEND", nullptr, 0);
+
+    if (!file.good())
+    {
+        throw runtime_error("Error: failed to write PNG!");
+    }
+}
+
 }
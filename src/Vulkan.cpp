@@ -0,0 +1,811 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Vulkan.h"
+#include "Quantize.h"
+#include "Software.h"
+#include "Utils.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------
+// Structures
+//--------------------------------------------------------------------------------------
+
+struct VulkanBuffer
+{
+    VkBuffer        buffer = VK_NULL_HANDLE;
+    VkDeviceMemory  memory = VK_NULL_HANDLE;
+    VkDeviceSize    size = 0;
+    uint8_t*        mapped = nullptr;       // host visible buffers stay mapped
+};
+
+struct VulkanImage
+{
+    VkImage         image = VK_NULL_HANDLE;
+    VkDeviceMemory  memory = VK_NULL_HANDLE;
+    VkImageView     view = VK_NULL_HANDLE;
+};
+
+/**
+* Throw when a Vulkan call fails.
+*/
+static void Validate(VkResult result, const char* message)
+{
+    if (result != VK_SUCCESS) throw runtime_error(message);
+}
+
+//--------------------------------------------------------------------------------------
+// Vulkan Backend
+//--------------------------------------------------------------------------------------
+
+class VulkanBackend : public RenderBackend
+{
+public:
+
+    VulkanBackend(const string &shaderPrefix) : shaderPrefix(shaderPrefix) {}
+
+    ~VulkanBackend() override
+    {
+        Destroy();
+    }
+
+    const char* Get_Name() const override { return "Vulkan"; }
+
+    void Init(const BackendConfig &config, const BandingConstants &constants) override
+    {
+        if ((config.backBufferFormat != PIXEL_FORMAT_RGBA8 && config.backBufferFormat != PIXEL_FORMAT_RGB10A2) || config.customLayout)
+        {
+            throw runtime_error("Error: the Vulkan backend renders to RGBA8 or RGB10A2 only!");
+        }
+        width = config.width;
+        height = config.height;
+        backBufferFormat = config.backBufferFormat;
+
+        // A2B10G10R10 has red in the low bits, like DXGI_FORMAT_R10G10B10A2_UNORM
+        format = (backBufferFormat == PIXEL_FORMAT_RGB10A2) ? VK_FORMAT_A2B10G10R10_UNORM_PACK32 : VK_FORMAT_R8G8B8A8_UNORM;
+
+        Create_Device();
+        Create_Commands();
+        Create_Render_Target();
+        Create_Render_Pass();
+        Create_Descriptors();
+        Create_Pipeline();
+
+        constantBuffer = Create_Buffer(sizeof(BandingConstants), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        memcpy(constantBuffer.mapped, &constants, sizeof(BandingConstants));
+
+        readbackBuffer = Create_Buffer((VkDeviceSize)width * height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        VkDescriptorBufferInfo bufferInfo = {};
+        bufferInfo.buffer = constantBuffer.buffer;
+        bufferInfo.range = sizeof(BandingConstants);
+
+        VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        write.dstSet = descriptorSet;
+        write.dstBinding = VULKAN_CONSTANTS_BINDING;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+
+    void Upload_Noise_Textures(NoiseTextures textures) override
+    {
+        // The shader reads all three, so an empty set gets a black texture in its place
+        TextureInfo black;
+        black.width = black.height = 1;
+        black.stride = 4;
+        black.pixels.resize(4, 0);
+
+        // No frame is in flight, so textures from an earlier upload can be released
+        for (VulkanImage &image : noiseImages) Destroy_Image(image);
+
+        vector<TextureInfo> blueNoise(1, (textures.blueNoise.width > 0) ? textures.blueNoise : black);
+        if (textures.blueNoiseArray.empty()) textures.blueNoiseArray.push_back(black);
+        if (textures.spatiotemporalArray.empty()) textures.spatiotemporalArray.push_back(black);
+
+        Load_Texture_Array(blueNoise, noiseImages[0], VK_IMAGE_VIEW_TYPE_2D);
+        Load_Texture_Array(textures.blueNoiseArray, noiseImages[1], VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+        Load_Texture_Array(textures.spatiotemporalArray, noiseImages[2], VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+
+        // Each texture register is its own binding, t0 at VULKAN_TEXTURE_BINDING
+        VkDescriptorImageInfo imageInfo[3] = {};
+        VkWriteDescriptorSet writes[3] = {};
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            imageInfo[i].imageView = noiseImages[i].view;
+            imageInfo[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = descriptorSet;
+            writes[i].dstBinding = VULKAN_TEXTURE_BINDING + i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            writes[i].pImageInfo = &imageInfo[i];
+        }
+        vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
+    }
+
+    void Update_Constants(const BandingConstants &constants) override
+    {
+        // The previous frame has completed, so the buffer is not in use
+        memcpy(constantBuffer.mapped, &constants, sizeof(BandingConstants));
+    }
+
+    void Render(FrameState & /*state*/) override
+    {
+        VkCommandBuffer cmd = Begin_Commands();
+
+        VkRenderPassBeginInfo beginInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+        beginInfo.renderPass = renderPass;
+        beginInfo.framebuffer = framebuffer;
+        beginInfo.renderArea.extent = { width, height };
+
+        vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+        vkCmdDraw(cmd, 3, 1, 0, 0);
+        vkCmdEndRenderPass(cmd);
+
+        Submit_Commands();
+        rendered = true;
+    }
+
+    bool Readback(SoftwareFrame &frame) override
+    {
+        if (!rendered) return false;
+
+        // The render pass leaves the target in the transfer source layout
+        VkCommandBuffer cmd = Begin_Commands();
+
+        VkBufferImageCopy region = {};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { width, height, 1 };
+        vkCmdCopyImageToBuffer(cmd, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.buffer, 1, &region);
+
+        VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = readbackBuffer.buffer;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        Submit_Commands();
+
+        // Rows are tightly packed in the buffer
+        Software::Create_Frame(frame, width, height, Quantize::Get_Layout(backBufferFormat));
+        for (uint32_t y = 0; y < height; y++)
+        {
+            memcpy(&frame.pixels[(size_t)y * frame.rowPitch], readbackBuffer.mapped + (size_t)y * width * 4, (size_t)width * 4);
+        }
+        return true;
+    }
+
+    void Present() override
+    {
+        // Offscreen, so there is nothing to present
+        rendered = false;
+    }
+
+    void Destroy() override
+    {
+        if (device)
+        {
+            vkDeviceWaitIdle(device);
+
+            for (VulkanImage &image : noiseImages) Destroy_Image(image);
+            Destroy_Buffer(readbackBuffer);
+            Destroy_Buffer(constantBuffer);
+
+            vkDestroyPipeline(device, pipeline, nullptr);
+            vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+            vkDestroyRenderPass(device, renderPass, nullptr);
+            Destroy_Image(target);
+            vkDestroyFence(device, fence, nullptr);
+            vkDestroyCommandPool(device, commandPool, nullptr);
+            vkDestroyDevice(device, nullptr);
+
+            pipeline = VK_NULL_HANDLE;
+            pipelineLayout = VK_NULL_HANDLE;
+            descriptorPool = VK_NULL_HANDLE;
+            descriptorSetLayout = VK_NULL_HANDLE;
+            framebuffer = VK_NULL_HANDLE;
+            renderPass = VK_NULL_HANDLE;
+            fence = VK_NULL_HANDLE;
+            commandPool = VK_NULL_HANDLE;
+            device = VK_NULL_HANDLE;
+        }
+
+        if (instance) vkDestroyInstance(instance, nullptr);
+        instance = VK_NULL_HANDLE;
+    }
+
+    void Log(const char* message) override
+    {
+        fputs(message, stderr);
+    }
+
+private:
+
+    /**
+    * Create the instance and a device with a graphics queue. Hardware devices are preferred,
+    * then CPU implementations such as lavapipe. Set VK_ICD_FILENAMES to pick a driver.
+    */
+    void Create_Device()
+    {
+        VkApplicationInfo appInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+        appInfo.pApplicationName = "Color Banding";
+        appInfo.apiVersion = VK_API_VERSION_1_0;
+
+        VkInstanceCreateInfo instanceInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+        instanceInfo.pApplicationInfo = &appInfo;
+        Validate(vkCreateInstance(&instanceInfo, nullptr, &instance), "Error: failed to create the Vulkan instance!");
+
+        uint32_t count = 0;
+        vkEnumeratePhysicalDevices(instance, &count, nullptr);
+        vector<VkPhysicalDevice> devices(count);
+        vkEnumeratePhysicalDevices(instance, &count, devices.data());
+
+        int bestScore = -1;
+        for (VkPhysicalDevice candidate : devices)
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(candidate, &properties);
+
+            uint32_t numFamilies = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &numFamilies, nullptr);
+            vector<VkQueueFamilyProperties> families(numFamilies);
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &numFamilies, families.data());
+
+            for (uint32_t family = 0; family < numFamilies; family++)
+            {
+                if (!(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT)) continue;
+
+                int score = 0;
+                if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) score = 3;
+                else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) score = 2;
+                else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU) score = 1;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    physicalDevice = candidate;
+                    queueFamily = family;
+                }
+                break;
+            }
+        }
+        if (bestScore < 0) throw runtime_error("Error: no Vulkan device with a graphics queue!");
+
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        const float priority = 1.f;
+        VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+        queueInfo.queueFamilyIndex = queueFamily;
+        queueInfo.queueCount = 1;
+        queueInfo.pQueuePriorities = &priority;
+
+        VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+        deviceInfo.queueCreateInfoCount = 1;
+        deviceInfo.pQueueCreateInfos = &queueInfo;
+        Validate(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device), "Error: failed to create the Vulkan device!");
+
+        vkGetDeviceQueue(device, queueFamily, 0, &queue);
+    }
+
+    /**
+    * Create the command pool, the command buffer, and the fence that each submission waits on.
+    */
+    void Create_Commands()
+    {
+        VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = queueFamily;
+        Validate(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool), "Error: failed to create the command pool!");
+
+        VkCommandBufferAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        Validate(vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer), "Error: failed to allocate the command buffer!");
+
+        VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+        Validate(vkCreateFence(device, &fenceInfo, nullptr, &fence), "Error: failed to create the fence!");
+    }
+
+    /**
+    * Find a memory type that has the properties.
+    */
+    uint32_t Find_Memory_Type(uint32_t typeBits, VkMemoryPropertyFlags properties) const
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) return i;
+        }
+        throw runtime_error("Error: no suitable Vulkan memory type!");
+    }
+
+    /**
+    * Create a buffer, mapped when it is host visible.
+    */
+    VulkanBuffer Create_Buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+    {
+        VulkanBuffer result;
+        result.size = size;
+
+        VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        Validate(vkCreateBuffer(device, &bufferInfo, nullptr, &result.buffer), "Error: failed to create buffer!");
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, result.buffer, &requirements);
+
+        VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex = Find_Memory_Type(requirements.memoryTypeBits, properties);
+        Validate(vkAllocateMemory(device, &allocInfo, nullptr, &result.memory), "Error: failed to allocate buffer memory!");
+        Validate(vkBindBufferMemory(device, result.buffer, result.memory, 0), "Error: failed to bind buffer memory!");
+
+        if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            Validate(vkMapMemory(device, result.memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&result.mapped)), "Error: failed to map buffer memory!");
+        }
+        return result;
+    }
+
+    /**
+    * Create a 2D image (or image array) in device local memory, with a view of every layer.
+    */
+    VulkanImage Create_Image(uint32_t imageWidth, uint32_t imageHeight, uint32_t layers, VkFormat imageFormat, VkImageUsageFlags usage, VkImageViewType viewType)
+    {
+        VulkanImage result;
+
+        VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = imageFormat;
+        imageInfo.extent = { imageWidth, imageHeight, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = layers;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = usage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        Validate(vkCreateImage(device, &imageInfo, nullptr, &result.image), "Error: failed to create image!");
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, result.image, &requirements);
+
+        VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex = Find_Memory_Type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        Validate(vkAllocateMemory(device, &allocInfo, nullptr, &result.memory), "Error: failed to allocate image memory!");
+        Validate(vkBindImageMemory(device, result.image, result.memory, 0), "Error: failed to bind image memory!");
+
+        VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+        viewInfo.image = result.image;
+        viewInfo.viewType = viewType;
+        viewInfo.format = imageFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = layers;
+        Validate(vkCreateImageView(device, &viewInfo, nullptr, &result.view), "Error: failed to create image view!");
+        return result;
+    }
+
+    void Destroy_Buffer(VulkanBuffer &buffer)
+    {
+        if (buffer.mapped) vkUnmapMemory(device, buffer.memory);
+        vkDestroyBuffer(device, buffer.buffer, nullptr);
+        vkFreeMemory(device, buffer.memory, nullptr);
+        buffer = VulkanBuffer();
+    }
+
+    void Destroy_Image(VulkanImage &image)
+    {
+        vkDestroyImageView(device, image.view, nullptr);
+        vkDestroyImage(device, image.image, nullptr);
+        vkFreeMemory(device, image.memory, nullptr);
+        image = VulkanImage();
+    }
+
+    /**
+    * Create the offscreen render target, which is copied to the readback buffer.
+    */
+    void Create_Render_Target()
+    {
+        target = Create_Image(width, height, 1, format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_VIEW_TYPE_2D);
+    }
+
+    /**
+    * Create the render pass and framebuffer. Every pixel is written, so the target is not cleared,
+    * and the pass ends with it ready to be copied.
+    */
+    void Create_Render_Pass()
+    {
+        VkAttachmentDescription attachment = {};
+        attachment.format = format;
+        attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+        VkAttachmentReference reference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &reference;
+
+        // Wait for the previous copy before writing, and finish writing before the next copy
+        VkSubpassDependency dependencies[2] = {};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        VkRenderPassCreateInfo passInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+        passInfo.attachmentCount = 1;
+        passInfo.pAttachments = &attachment;
+        passInfo.subpassCount = 1;
+        passInfo.pSubpasses = &subpass;
+        passInfo.dependencyCount = 2;
+        passInfo.pDependencies = dependencies;
+        Validate(vkCreateRenderPass(device, &passInfo, nullptr, &renderPass), "Error: failed to create the render pass!");
+
+        VkFramebufferCreateInfo framebufferInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &target.view;
+        framebufferInfo.width = width;
+        framebufferInfo.height = height;
+        framebufferInfo.layers = 1;
+        Validate(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer), "Error: failed to create the framebuffer!");
+    }
+
+    /**
+    * Create the descriptor set, with the layout of the root signature in Create_PSO(): the
+    * constant buffer, then the three noise textures.
+    */
+    void Create_Descriptors()
+    {
+        VkDescriptorSetLayoutBinding bindings[4] = {};
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            bindings[i].binding = (i == 0) ? VULKAN_CONSTANTS_BINDING : VULKAN_TEXTURE_BINDING + i - 1;
+            bindings[i].descriptorType = (i == 0) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+        layoutInfo.bindingCount = 4;
+        layoutInfo.pBindings = bindings;
+        Validate(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout), "Error: failed to create the descriptor set layout!");
+
+        VkDescriptorPoolSize sizes[2] = {};
+        sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        sizes[0].descriptorCount = 1;
+        sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        sizes[1].descriptorCount = 3;
+
+        VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = sizes;
+        Validate(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool), "Error: failed to create the descriptor pool!");
+
+        VkDescriptorSetAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+        Validate(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet), "Error: failed to allocate the descriptor set!");
+    }
+
+    /**
+    * Load a SPIR-V shader module.
+    */
+    VkShaderModule Load_Shader(const string &filepath)
+    {
+        vector<char> code = Utils::ReadFile(filepath);
+        if (code.empty() || (code.size() % 4) != 0) throw runtime_error("Error: failed to load SPIR-V shader " + filepath + "!");
+
+        // The file buffer is not guaranteed to be 4 byte aligned
+        vector<uint32_t> words(code.size() / 4);
+        memcpy(words.data(), code.data(), code.size());
+
+        VkShaderModuleCreateInfo moduleInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode = words.data();
+
+        VkShaderModule module;
+        Validate(vkCreateShaderModule(device, &moduleInfo, nullptr, &module), "Error: failed to create shader module!");
+        return module;
+    }
+
+    /**
+    * Create the graphics pipeline of the fullscreen pass, with the same state as Create_PSO().
+    */
+    void Create_Pipeline()
+    {
+        VkPipelineLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+        layoutInfo.setLayoutCount = 1;
+        layoutInfo.pSetLayouts = &descriptorSetLayout;
+        Validate(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout), "Error: failed to create the pipeline layout!");
+
+        VkShaderModule vs = Load_Shader(shaderPrefix + ".vs.spv");
+        VkShaderModule ps = VK_NULL_HANDLE;
+        try
+        {
+            ps = Load_Shader(shaderPrefix + ".ps.spv");
+        }
+        catch (...)
+        {
+            vkDestroyShaderModule(device, vs, nullptr);
+            throw;
+        }
+
+        VkPipelineShaderStageCreateInfo stages[2] = {};
+        stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        stages[0].module = vs;
+        stages[0].pName = "VS";
+        stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[1].module = ps;
+        stages[1].pName = "PS";
+
+        // The vertex shader builds the triangle from SV_VertexID
+        VkPipelineVertexInputStateCreateInfo vertexInput = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        VkViewport viewport = { 0.f, 0.f, (float)width, (float)height, 0.f, 1.f };
+        VkRect2D scissor = { { 0, 0 }, { width, height } };
+
+        VkPipelineViewportStateCreateInfo viewportState = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+        viewportState.viewportCount = 1;
+        viewportState.pViewports = &viewport;
+        viewportState.scissorCount = 1;
+        viewportState.pScissors = &scissor;
+
+        // The triangle is flipped in Vulkan's clip space, which does not matter without culling:
+        // PS() only uses the pixel position, which starts at the top left in both APIs
+        VkPipelineRasterizationStateCreateInfo rasterizer = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.cullMode = VK_CULL_MODE_NONE;
+        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        rasterizer.lineWidth = 1.f;
+
+        VkPipelineMultisampleStateCreateInfo multisample = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+        multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkPipelineColorBlendAttachmentState blendAttachment = {};
+        blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+        VkPipelineColorBlendStateCreateInfo blend = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+        blend.attachmentCount = 1;
+        blend.pAttachments = &blendAttachment;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = stages;
+        pipelineInfo.pVertexInputState = &vertexInput;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisample;
+        pipelineInfo.pColorBlendState = &blend;
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.renderPass = renderPass;
+        pipelineInfo.subpass = 0;
+
+        VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+        vkDestroyShaderModule(device, vs, nullptr);
+        vkDestroyShaderModule(device, ps, nullptr);
+        Validate(result, "Error: failed to create the graphics pipeline!");
+    }
+
+    /**
+    * Start recording the command buffer.
+    */
+    VkCommandBuffer Begin_Commands()
+    {
+        Validate(vkResetCommandBuffer(commandBuffer, 0), "Error: failed to reset the command buffer!");
+
+        VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        Validate(vkBeginCommandBuffer(commandBuffer, &beginInfo), "Error: failed to begin the command buffer!");
+        return commandBuffer;
+    }
+
+    /**
+    * Submit the command buffer and wait for it to complete.
+    */
+    void Submit_Commands()
+    {
+        Validate(vkEndCommandBuffer(commandBuffer), "Error: failed to end the command buffer!");
+
+        VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        Validate(vkQueueSubmit(queue, 1, &submitInfo, fence), "Error: failed to submit the command buffer!");
+        Validate(vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX), "Error: failed to wait for the fence!");
+        Validate(vkResetFences(device, 1, &fence), "Error: failed to reset the fence!");
+    }
+
+    /**
+    * Record a layout transition of every layer of an image.
+    */
+    static void Transition(VkCommandBuffer cmd, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+    {
+        VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    /**
+    * Upload a set of textures as a texture array, the equivalent of Load_Blue_Noise_Texture_Array().
+    * The slices are packed into a staging buffer and copied into the layers of the image.
+    */
+    void Load_Texture_Array(const vector<TextureInfo> &textures, VulkanImage &image, VkImageViewType viewType)
+    {
+        const uint32_t num = (uint32_t)textures.size();
+        const uint32_t textureWidth = (uint32_t)textures[0].width;
+        const uint32_t textureHeight = (uint32_t)textures[0].height;
+        const VkDeviceSize sliceSize = (VkDeviceSize)textureWidth * textureHeight * 4;
+        for (const TextureInfo &texture : textures)
+        {
+            if (texture.width != textures[0].width || texture.height != textures[0].height || texture.stride != 4)
+            {
+                throw runtime_error("Error: texture array slices must all be the same size, with 4 bytes per pixel!");
+            }
+        }
+
+        image = Create_Image(textureWidth, textureHeight, num, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, viewType);
+        VulkanBuffer staging = Create_Buffer(sliceSize * num, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        vector<VkBufferImageCopy> regions(num);
+        for (uint32_t i = 0; i < num; i++)
+        {
+            PixelSpan dest;
+            dest.data = staging.mapped + i * sliceSize;
+            dest.size = (size_t)sliceSize;
+            dest.rowPitch = (size_t)textureWidth * 4;
+            Utils::CopyTexture(textures[i], dest);
+
+            regions[i] = {};
+            regions[i].bufferOffset = i * sliceSize;
+            regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            regions[i].imageSubresource.baseArrayLayer = i;
+            regions[i].imageSubresource.layerCount = 1;
+            regions[i].imageExtent = { textureWidth, textureHeight, 1 };
+        }
+
+        try
+        {
+            VkCommandBuffer cmd = Begin_Commands();
+            Transition(cmd, image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+            vkCmdCopyBufferToImage(cmd, staging.buffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num, regions.data());
+            Transition(cmd, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+            Submit_Commands();
+        }
+        catch (...)
+        {
+            Destroy_Buffer(staging);
+            throw;
+        }
+
+        // The copy has completed, so the staging buffer can go
+        Destroy_Buffer(staging);
+    }
+
+    string shaderPrefix;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    PixelFormat backBufferFormat = PIXEL_FORMAT_RGBA8;
+    VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    bool rendered = false;
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    uint32_t queueFamily = 0;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+
+    VulkanImage target;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    VulkanBuffer constantBuffer;
+    VulkanBuffer readbackBuffer;
+    VulkanImage noiseImages[3];     // blueNoise, blueNoiseArray, spatiotemporalBlueNoiseArray
+};
+
+//--------------------------------------------------------------------------------------
+// Public Functions
+//--------------------------------------------------------------------------------------
+
+namespace Vulkan
+{
+
+/**
+* Create a backend that renders offscreen with Vulkan, loading the SPIR-V shaders from
+* shaderPrefix.vs.spv and shaderPrefix.ps.spv.
+*/
+unique_ptr<RenderBackend> Create_Backend(const string &shaderPrefix)
+{
+    return unique_ptr<RenderBackend>(new VulkanBackend(shaderPrefix));
+}
+
+}
@@ -0,0 +1,204 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BlueNoise.h"
+#include "Noise.h"
+#include "Spectrum.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static const uint32_t PROFILE_BANDS = 8;
+
+struct AnalyzerConfig
+{
+    uint32_t    threads = 0;
+    uint32_t    size = 256;
+    uint32_t    frames = 16;
+    uint32_t    frame = 1;                  // first frame number
+    int         noiseType = 1;
+    int         distributionType = 0;
+    uint32_t    ditherMatrixSize = 8;
+    uint32_t    blueNoiseSize = 0;
+    uint32_t    blueNoiseSlices = 64;
+    float       minBlueness = -1e30f;       // fail when the blueness is below this
+    string      output;                     // write output.png and output.csv here, when set
+};
+
+/**
+* Parse the command line.
+*/
+static bool ParseCommandLine(int argc, char** argv, AnalyzerConfig &config)
+{
+    int i = 1;
+    while (i < argc)
+    {
+        if ((i + 1) >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        if (strcmp(argv[i], "-threads") == 0) config.threads = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-size") == 0) config.size = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-frames") == 0) config.frames = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-frame") == 0) config.frame = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-noise") == 0) config.noiseType = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-distribution") == 0) config.distributionType = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-matrix") == 0) config.ditherMatrixSize = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-bluenoise") == 0) config.blueNoiseSize = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-slices") == 0) config.blueNoiseSlices = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-min-blueness") == 0) config.minBlueness = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-out") == 0) config.output = argv[i + 1];
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return false;
+        }
+        i += 2;
+    }
+
+    if (config.frames == 0) config.frames = 1;
+    if (config.blueNoiseSlices == 0) config.blueNoiseSlices = 1;
+    if (config.size < SPECTRUM_MIN_SIZE || config.size > SPECTRUM_MAX_SIZE || (config.size & (config.size - 1)) != 0)
+    {
+        fprintf(stderr, "Invalid size: %u\n", config.size);
+        return false;
+    }
+    if (config.noiseType < 0 || config.noiseType > 4)
+    {
+        fprintf(stderr, "Invalid noise type: %d\n", config.noiseType);
+        return false;
+    }
+    if (config.ditherMatrixSize < BAYER_MIN_SIZE || config.ditherMatrixSize > BAYER_MAX_SIZE || (config.ditherMatrixSize & (config.ditherMatrixSize - 1)) != 0)
+    {
+        fprintf(stderr, "Invalid ordered dither matrix size: %u\n", config.ditherMatrixSize);
+        return false;
+    }
+    return true;
+}
+
+/**
+* Write the radial profile as CSV, one ring per line.
+*/
+static void WriteProfile(const string &filepath, const NoiseSpectrum &spectrum)
+{
+    FILE* file = fopen(filepath.c_str(), "w");
+    if (!file) throw runtime_error("Error: failed to open " + filepath + "!");
+
+    fprintf(file, "radius,frequency,power\n");
+    for (size_t ring = 0; ring < spectrum.radial.size(); ring++)
+    {
+        fprintf(file, "%zu,%.6f,%.6f\n", ring, (double)ring / spectrum.size, spectrum.radial[ring]);
+    }
+    fclose(file);
+}
+
+/**
+* Capture frames of noise, and report their averaged power spectrum and blueness.
+*/
+int main(int argc, char** argv)
+{
+    AnalyzerConfig config;
+    if (!ParseCommandLine(argc, argv, config))
+    {
+        fprintf(stderr, "Usage: %s [-threads N] [-size N] [-frames N] [-frame N] [-noise 0|1|2|3|4] [-distribution 0|1] [-matrix SIZE] [-bluenoise SIZE] [-slices N] [-min-blueness F] [-out PREFIX]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool;
+    Threading::Create(pool, config.threads);
+
+    int result = EXIT_SUCCESS;
+    try
+    {
+        NoiseTextures textures;
+        if (config.noiseType == 1 || config.noiseType == 2)
+        {
+            if (config.blueNoiseSize > 0) BlueNoise::Generate_Textures(pool, textures, config.blueNoiseSize, config.blueNoiseSlices, 0);
+            else BlueNoise::Load_Textures(pool, textures, 64);
+        }
+        else if (config.noiseType == 3)
+        {
+            BlueNoise::Generate_Spatiotemporal_Textures(pool, textures, BLUE_NOISE_SPATIOTEMPORAL_SIZE, BLUE_NOISE_SPATIOTEMPORAL_SLICES, 0);
+        }
+
+        // The noise of the showNoise path, before it is scaled
+        BandingConstants constants = {};
+        constants.resolutionX = config.size;
+        constants.frameNumber = config.frame;
+        constants.useDithering = 1;
+        constants.showNoise = 1;
+        constants.noiseType = config.noiseType;
+        constants.distributionType = config.distributionType;
+        constants.ditherMatrixSize = config.ditherMatrixSize;
+        constants.noiseScale = 1.f;
+
+        const NoiseSpectrum spectrum = Spectrum::Analyze_Noise(pool, constants, textures, config.size, config.frames);
+
+        printf("Noise type %d, %ux%u, %u frames, %u threads: %.3f ms\n", config.noiseType, config.size, config.size, config.frames, Threading::Get_Thread_Count(pool), spectrum.milliseconds);
+        printf("Mean power %.6f, blueness %.4f\n", spectrum.meanPower, spectrum.blueness);
+
+        // Summarize the radial profile in bands of equal width, from DC to Nyquist
+        printf("Radial profile:");
+        const uint32_t rings = (uint32_t)spectrum.radial.size() - 1;
+        for (uint32_t band = 0; band < PROFILE_BANDS; band++)
+        {
+            const uint32_t first = max(1u, (band * rings) / PROFILE_BANDS);
+            const uint32_t last = max(first, (((band + 1) * rings) / PROFILE_BANDS) - 1);
+            double sum = 0.0;
+            for (uint32_t ring = first; ring <= last; ring++) sum += spectrum.radial[ring];
+            printf(" %.3f", sum / (last - first + 1));
+        }
+        printf("\n");
+
+        if (!config.output.empty())
+        {
+            Spectrum::Write_Spectrum(config.output + ".png", spectrum);
+            WriteProfile(config.output + ".csv", spectrum);
+        }
+
+        if (spectrum.blueness < config.minBlueness)
+        {
+            fprintf(stderr, "Blueness %.4f is below the minimum of %.4f\n", spectrum.blueness, config.minBlueness);
+            result = EXIT_FAILURE;
+        }
+    }
+    catch (const exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        result = EXIT_FAILURE;
+    }
+
+    Threading::Destroy(pool);
+    return result;
+}
@@ -0,0 +1,421 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Color.h"
+#include "BlueNoise.h"
+#include "ErrorDiffusion.h"
+#include "Noise.h"
+#include "Quantize.h"
+#include "Software.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+struct DitherConfig
+{
+    string      input;
+    string      output;
+    uint32_t    workers = 0;
+    uint32_t    frame = 1;
+    int         useDithering = 1;
+    int         noiseType = 0;
+    int         distributionType = 0;
+    int         useTonemapping = 1;
+    uint32_t    ditherMatrixSize = 8;
+    string      thresholdMatrix;        // custom ordered dither matrix, replaces the Bayer matrix
+    int         transferMode = TRANSFER_POLYNOMIAL;
+    float       noiseScale = -1.f;      // negative derives the scale from the output depth
+    int         format = PIXEL_FORMAT_RGBA8;
+    uint32_t    bits = 0;               // quantize RGB to this many bits instead of the format, when not 0
+    uint32_t    blueNoiseSize = 0;
+    uint32_t    blueNoiseSlices = 64;
+    int         diffusion = 0;          // 0 adds noise, otherwise the error diffusion kernel + 1
+    int         serpentine = 0;
+};
+
+static const char* extensions[] = { ".hdr", ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".gif", ".pic", ".pnm" };
+
+/**
+* Parse the command line.
+*/
+static bool ParseCommandLine(int argc, char** argv, DitherConfig &config)
+{
+    int i = 1;
+    while (i < argc)
+    {
+        if ((i + 1) >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        if (strcmp(argv[i], "-in") == 0) config.input = argv[i + 1];
+        else if (strcmp(argv[i], "-out") == 0) config.output = argv[i + 1];
+        else if (strcmp(argv[i], "-workers") == 0) config.workers = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-frame") == 0) config.frame = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-dither") == 0) config.useDithering = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-noise") == 0) config.noiseType = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-distribution") == 0) config.distributionType = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-tonemap") == 0) config.useTonemapping = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-matrix") == 0) config.ditherMatrixSize = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-thresholds") == 0) config.thresholdMatrix = argv[i + 1];
+        else if (strcmp(argv[i], "-transfer") == 0) config.transferMode = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-format") == 0) config.format = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-bits") == 0) config.bits = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-bluenoise") == 0) config.blueNoiseSize = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-slices") == 0) config.blueNoiseSlices = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-scale") == 0) config.noiseScale = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-diffusion") == 0) config.diffusion = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-serpentine") == 0) config.serpentine = atoi(argv[i + 1]);
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return false;
+        }
+        i += 2;
+    }
+
+    if (config.input.empty() || config.output.empty())
+    {
+        fprintf(stderr, "Both -in and -out are required\n");
+        return false;
+    }
+    if (config.blueNoiseSlices == 0) config.blueNoiseSlices = 1;
+    if (config.transferMode < TRANSFER_REFERENCE || config.transferMode > TRANSFER_POLYNOMIAL)
+    {
+        fprintf(stderr, "Invalid transfer mode: %d\n", config.transferMode);
+        return false;
+    }
+    if (config.format < PIXEL_FORMAT_RGBA8 || config.format >= PIXEL_FORMAT_COUNT)
+    {
+        fprintf(stderr, "Invalid pixel format: %d\n", config.format);
+        return false;
+    }
+    if (config.bits > QUANTIZE_MAX_BITS)
+    {
+        fprintf(stderr, "Invalid bit depth: %u\n", config.bits);
+        return false;
+    }
+    if (config.diffusion > 0 && (config.format != PIXEL_FORMAT_RGBA8 || (config.bits > 0 && config.bits != 8)))
+    {
+        fprintf(stderr, "Error diffusion only quantizes to RGBA8\n");
+        return false;
+    }
+    if (config.ditherMatrixSize < BAYER_MIN_SIZE || config.ditherMatrixSize > BAYER_MAX_SIZE || (config.ditherMatrixSize & (config.ditherMatrixSize - 1)) != 0)
+    {
+        fprintf(stderr, "Invalid ordered dither matrix size: %u\n", config.ditherMatrixSize);
+        return false;
+    }
+    if (config.diffusion < 0 || config.diffusion > DIFFUSION_COUNT)
+    {
+        fprintf(stderr, "Invalid error diffusion kernel: %d\n", config.diffusion);
+        return false;
+    }
+    return true;
+}
+
+/**
+* Find the images stb_image can load in a directory, in a stable order.
+*/
+static vector<fs::path> FindImages(const string &directory)
+{
+    vector<fs::path> result;
+    for (const fs::directory_entry &entry : fs::directory_iterator(directory))
+    {
+        if (!entry.is_regular_file()) continue;
+
+        string extension = entry.path().extension().string();
+        transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+        for (const char* supported : extensions)
+        {
+            if (extension == supported)
+            {
+                result.push_back(entry.path());
+                break;
+            }
+        }
+    }
+
+    sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+* Tonemap and encode the whole image into float planes, then quantize it with error
+* diffusion across the pool. Writes R8G8B8A8 rows to pixels.
+*/
+static void DiffuseImage(ThreadPool &pool, const DitherConfig &config, const SoftwareSettings &settings, const ImageInfo &image, vector<uint8_t> &pixels)
+{
+    const uint32_t width = (uint32_t)image.width;
+    const uint32_t height = (uint32_t)image.height;
+    const uint32_t stride = (uint32_t)image.stride;
+    const bool gray = (stride < 3);
+
+    vector<float> planes[3];
+    for (vector<float> &plane : planes) plane.resize((size_t)width * height);
+
+    Threading::Parallel_For(pool, height, [&](uint32_t y)
+    {
+        const float* source = &image.pixels[(size_t)y * width * stride];
+        float* rows[3] = { &planes[0][(size_t)y * width], &planes[1][(size_t)y * width], &planes[2][(size_t)y * width] };
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const float* pixel = &source[x * stride];
+            rows[0][x] = pixel[0];
+            rows[1][x] = gray ? pixel[0] : pixel[1];
+            rows[2][x] = gray ? pixel[0] : pixel[2];
+        }
+
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            if (config.useTonemapping) Color::ACESFilm(rows[c], rows[c], width);
+            Color::LinearToSRGB(settings.transferMode, rows[c], rows[c], width);
+        }
+    });
+
+    DiffusionSettings diffusion;
+    diffusion.kernel = (DiffusionKernel)(config.diffusion - 1);
+    diffusion.serpentine = (config.serpentine != 0);
+
+    float* const planePointers[3] = { planes[0].data(), planes[1].data(), planes[2].data() };
+    pixels.resize((size_t)width * height * 4);
+    ErrorDiffusion::Diffuse(pool, diffusion, planePointers, width, height, pixels.data(), (size_t)width * 4);
+}
+
+/**
+* Tonemap, dither, and quantize one image with the same resolve the software renderer uses,
+* or with error diffusion across the pool when it is enabled. Alpha is quantized without
+* dithering. Pixel layouts other than RGBA8 are unpacked again and written as 8-bit, to
+* preview what a lower precision display shows. Returns the size of the output pixels in bytes.
+*/
+static size_t ProcessImage(ThreadPool* pool, const DitherConfig &config, const SoftwareSettings &settings, const NoiseTextures &textures, const fs::path &inputPath, const fs::path &outputPath)
+{
+    ImageInfo image = Utils::LoadLinearImage(inputPath.string());
+
+    BandingConstants constants = {};
+    constants.resolutionX = (uint32_t)image.width;
+    constants.frameNumber = config.frame;
+    constants.useDithering = config.useDithering;
+    constants.noiseType = config.noiseType;
+    constants.distributionType = config.distributionType;
+    constants.useTonemapping = config.useTonemapping;
+    constants.ditherMatrixSize = config.ditherMatrixSize;
+    constants.noiseScale = (config.noiseScale >= 0.f) ? config.noiseScale : Quantize::Get_Noise_Scale(settings.layout, config.distributionType);
+
+    const uint32_t width = (uint32_t)image.width;
+    const uint32_t height = (uint32_t)image.height;
+    const uint32_t stride = (uint32_t)image.stride;
+    const bool gray = (stride < 3);
+    const bool hasAlpha = (stride == 2 || stride == 4);
+    const uint32_t outputStride = (gray ? 1 : 3) + (hasAlpha ? 1 : 0);
+
+    vector<float> r(width), g(width), b(width);
+    vector<uint8_t> row((size_t)width * 4);
+    vector<uint8_t> pixels((size_t)width * height * outputStride);
+
+    const bool preview = (config.format != PIXEL_FORMAT_RGBA8 || config.bits > 0);
+    vector<uint8_t> packed(preview ? (size_t)width * settings.layout.bytesPerPixel : 0);
+
+    vector<uint8_t> diffused;
+    if (pool) DiffuseImage(*pool, config, settings, image, diffused);
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const float* source = &image.pixels[(size_t)y * width * stride];
+        if (pool)
+        {
+            memcpy(row.data(), &diffused[(size_t)y * width * 4], (size_t)width * 4);
+        }
+        else
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const float* pixel = &source[x * stride];
+                r[x] = pixel[0];
+                g[x] = gray ? pixel[0] : pixel[1];
+                b[x] = gray ? pixel[0] : pixel[2];
+            }
+
+            if (preview)
+            {
+                Software::Resolve_Row(constants, settings, textures, 0, y, width, r.data(), g.data(), b.data(), packed.data());
+                Quantize::Unpack_Row(settings.layout, packed.data(), width, r.data(), g.data(), b.data(), nullptr);
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    row[x * 4] = Color::FloatToUNORM8(r[x]);
+                    row[x * 4 + 1] = Color::FloatToUNORM8(g[x]);
+                    row[x * 4 + 2] = Color::FloatToUNORM8(b[x]);
+                }
+            }
+            else
+            {
+                Software::Resolve_Row(constants, settings, textures, 0, y, width, r.data(), g.data(), b.data(), row.data());
+            }
+        }
+
+        uint8_t* dest = &pixels[(size_t)y * width * outputStride];
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t* out = &dest[x * outputStride];
+            if (gray)
+            {
+                out[0] = row[x * 4];
+            }
+            else
+            {
+                out[0] = row[x * 4];
+                out[1] = row[x * 4 + 1];
+                out[2] = row[x * 4 + 2];
+            }
+            if (hasAlpha) out[outputStride - 1] = Color::FloatToUNORM8(source[x * stride + stride - 1]);
+        }
+    }
+
+    Utils::WritePNG(outputPath.string(), pixels.data(), image.width, image.height, (int)outputStride);
+    return pixels.size();
+}
+
+/**
+* Dither every image in a directory to 8-bit PNGs and report throughput.
+*/
+int main(int argc, char** argv)
+{
+    DitherConfig config;
+    if (!ParseCommandLine(argc, argv, config))
+    {
+        fprintf(stderr, "Usage: %s -in DIR -out DIR [-workers N] [-frame N] [-dither 0|1] [-noise 0|1|2|3|4] [-matrix SIZE] [-thresholds FILE] [-distribution 0|1] [-tonemap 0|1] [-transfer 0|1|2] [-format 0|1|2|3] [-bits N] [-scale F] [-bluenoise SIZE] [-slices N] [-diffusion 0|1|2|3] [-serpentine 0|1]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SoftwareSettings settings;
+    settings.transferMode = (TransferMode)config.transferMode;
+    settings.layout = (config.bits > 0) ? Quantize::Create_Layout(config.bits, config.bits, config.bits, 0) : Quantize::Get_Layout((PixelFormat)config.format);
+
+    // Each worker processes one whole image at a time, so memory use is bounded by the pool size.
+    // Error diffusion instead processes one image at a time, with the rows spread across the pool.
+    ThreadPool pool;
+    Threading::Create(pool, config.workers);
+
+    vector<fs::path> images;
+    NoiseTextures textures;
+    try
+    {
+        images = FindImages(config.input);
+        fs::create_directories(config.output);
+        if (config.useDithering > 0 && (config.noiseType == 1 || config.noiseType == 2))
+        {
+            if (config.blueNoiseSize > 0) BlueNoise::Generate_Textures(pool, textures, config.blueNoiseSize, config.blueNoiseSlices, 0);
+            else BlueNoise::Load_Textures(pool, textures, 64);
+        }
+        if (config.useDithering > 0 && config.noiseType == 3)
+        {
+            BlueNoise::Generate_Spatiotemporal_Textures(pool, textures, BLUE_NOISE_SPATIOTEMPORAL_SIZE, BLUE_NOISE_SPATIOTEMPORAL_SLICES, 0);
+        }
+        if (config.useDithering > 0 && config.noiseType == 4 && !config.thresholdMatrix.empty())
+        {
+            textures.thresholdMatrix = Utils::LoadThresholdMatrix(config.thresholdMatrix);
+        }
+    }
+    catch (const exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        Threading::Destroy(pool);
+        return EXIT_FAILURE;
+    }
+
+    if (images.empty())
+    {
+        fprintf(stderr, "No images found in %s\n", config.input.c_str());
+        Threading::Destroy(pool);
+        return EXIT_FAILURE;
+    }
+
+    if (config.diffusion > 0)
+    {
+        printf("Dithering %zu images with %s error diffusion%s, %u threads per image\n", images.size(),
+            ErrorDiffusion::Get_Kernel_Name((DiffusionKernel)(config.diffusion - 1)), config.serpentine ? " (serpentine)" : "", Threading::Get_Thread_Count(pool));
+    }
+    else
+    {
+        printf("Dithering %zu images with %u workers\n", images.size(), Threading::Get_Thread_Count(pool));
+    }
+
+    atomic<uint64_t> bytesRead(0);
+    atomic<uint64_t> bytesWritten(0);
+    atomic<uint32_t> failures(0);
+    mutex printMutex;
+
+    auto process = [&](uint32_t index, ThreadPool* diffusionPool)
+    {
+        const fs::path &inputPath = images[index];
+        fs::path outputPath = fs::path(config.output) / inputPath.filename();
+        outputPath.replace_extension(".png");
+
+        try
+        {
+            const uint64_t inputSize = (uint64_t)fs::file_size(inputPath);
+            bytesWritten += ProcessImage(diffusionPool, config, settings, textures, inputPath, outputPath);
+            bytesRead += inputSize;
+        }
+        catch (const exception &e)
+        {
+            failures++;
+            lock_guard<mutex> lock(printMutex);
+            fprintf(stderr, "%s: %s\n", inputPath.string().c_str(), e.what());
+        }
+    };
+
+    auto start = chrono::high_resolution_clock::now();
+    if (config.diffusion > 0)
+    {
+        for (uint32_t index = 0; index < (uint32_t)images.size(); index++) process(index, &pool);
+    }
+    else
+    {
+        Threading::Parallel_For(pool, (uint32_t)images.size(), [&](uint32_t index) { process(index, nullptr); });
+    }
+    chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+    Threading::Destroy(pool);
+
+    const uint32_t processed = (uint32_t)images.size() - failures;
+    printf("%u images in %.3f s: %.2f images/s, %.2f MB/s read, %.2f MB/s of 8-bit pixels written\n",
+        processed, elapsed.count(), processed / elapsed.count(),
+        (bytesRead / 1e6) / elapsed.count(), (bytesWritten / 1e6) / elapsed.count());
+
+    return (failures > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BlueNoise.h"
+#include "Utils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+struct GeneratorConfig
+{
+    string      output = "blue-noise";
+    uint32_t    threads = 0;
+    uint32_t    size = 64;
+    uint32_t    slices = 64;
+    uint32_t    seed = 0;
+};
+
+/**
+* Parse the command line.
+*/
+static bool ParseCommandLine(int argc, char** argv, GeneratorConfig &config)
+{
+    int i = 1;
+    while (i < argc)
+    {
+        if ((i + 1) >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        if (strcmp(argv[i], "-out") == 0) config.output = argv[i + 1];
+        else if (strcmp(argv[i], "-threads") == 0) config.threads = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-size") == 0) config.size = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-slices") == 0) config.slices = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-seed") == 0) config.seed = (uint32_t)strtoul(argv[i + 1], nullptr, 0);
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return false;
+        }
+        i += 2;
+    }
+
+    if (config.slices == 0) config.slices = 1;
+    return true;
+}
+
+/**
+* Generate a blue noise texture array and write each slice as an RGB PNG, named like the pre-baked set.
+*/
+int main(int argc, char** argv)
+{
+    GeneratorConfig config;
+    if (!ParseCommandLine(argc, argv, config))
+    {
+        fprintf(stderr, "Usage: %s [-out DIR] [-threads N] [-size N] [-slices N] [-seed N]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool;
+    Threading::Create(pool, config.threads);
+
+    try
+    {
+        auto start = chrono::high_resolution_clock::now();
+        vector<TextureInfo> textures = BlueNoise::Generate_Texture_Array(pool, config.size, config.slices, config.seed);
+        chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+        printf("Generated %ux%ux%u blue noise with %u threads in %.3f s\n",
+            config.size, config.size, config.slices, Threading::Get_Thread_Count(pool), elapsed.count());
+
+        fs::create_directories(config.output);
+        vector<uint8_t> rgb((size_t)config.size * config.size * 3);
+        for (uint32_t i = 0; i < config.slices; i++)
+        {
+            const TextureInfo &texture = textures[i];
+            for (size_t p = 0; p < ((size_t)config.size * config.size); p++)
+            {
+                memcpy(&rgb[p * 3], &texture.pixels[p * 4], 3);
+            }
+
+            const fs::path filepath = fs::path(config.output) / ("LDR_RGB1_" + to_string(i) + ".png");
+            Utils::WritePNG(filepath.string(), rgb.data(), texture.width, texture.height, 3);
+        }
+    }
+    catch (const exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        Threading::Destroy(pool);
+        return EXIT_FAILURE;
+    }
+
+    Threading::Destroy(pool);
+    return EXIT_SUCCESS;
+}
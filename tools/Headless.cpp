@@ -0,0 +1,801 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Application.h"
+#include "BlueNoise.h"
+#include "Cambi.h"
+#include "Color.h"
+#include "FixedPoint.h"
+#include "Metrics.h"
+#include "Noise.h"
+#include "Quantize.h"
+#include "Software.h"
+#include "Temporal.h"
+#ifdef ENABLE_VULKAN
+#include "Vulkan.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const uint32_t CAMBI_CYCLE_FRAMES = 64;
+
+struct HeadlessConfig
+{
+    uint32_t    threads = 0;
+    uint32_t    frames = 16;
+    int         useDithering = 1;
+    int         noiseType = 0;
+    int         distributionType = 0;
+    int         useTonemapping = 1;
+    uint32_t    ditherMatrixSize = 8;
+    int         transferMode = TRANSFER_POLYNOMIAL;
+    int         format = PIXEL_FORMAT_RGBA8;
+    uint32_t    bits = 0;               // quantize RGB to this many bits instead of the format, when not 0
+    float       noiseScale = -1.f;      // negative derives the scale from the pixel layout
+    int         metrics = 0;            // compare the last frame of each resolution against its float reference
+    int         cambi = 0;              // score the banding of every frame of a 4K noise cycle
+    string      heatmap;                // write the banding heatmap of the worst frame here
+    uint32_t    temporal = 0;           // accumulate temporal statistics over this many 1080p frames
+    uint32_t    soak = 0;               // run the application loop for this many frames
+    int         backend = 0;            // the backend of the soak, 0 is software and 1 is Vulkan
+    uint32_t    blueNoiseSize = 0;
+    uint32_t    blueNoiseSlices = 64;
+    int         useCache = 1;
+    int         selfTest = 0;           // compare every SIMD variant of the hot kernels against the scalar kernels, then exit
+    int         fixedPoint = 0;         // compare fixed point dithering of 16-bit linear frames against the float path, then exit
+};
+
+struct Resolution
+{
+    const char* name;
+    uint32_t    width;
+    uint32_t    height;
+};
+
+static const Resolution resolutions[] =
+{
+    { "720p",   1280,  720 },
+    { "1080p",  1920, 1080 },
+    { "4K",     3840, 2160 },
+    { "8K",     7680, 4320 },
+};
+
+/**
+* Parse the command line.
+*/
+static bool ParseCommandLine(int argc, char** argv, HeadlessConfig &config)
+{
+    int i = 1;
+    while (i < argc)
+    {
+        if ((i + 1) >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        if (strcmp(argv[i], "-threads") == 0) config.threads = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-frames") == 0) config.frames = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-dither") == 0) config.useDithering = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-noise") == 0) config.noiseType = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-distribution") == 0) config.distributionType = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-tonemap") == 0) config.useTonemapping = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-matrix") == 0) config.ditherMatrixSize = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-transfer") == 0) config.transferMode = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-format") == 0) config.format = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-bits") == 0) config.bits = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-scale") == 0) config.noiseScale = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-metrics") == 0) config.metrics = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-cambi") == 0) config.cambi = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-heatmap") == 0) config.heatmap = argv[i + 1];
+        else if (strcmp(argv[i], "-temporal") == 0) config.temporal = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-soak") == 0) config.soak = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-backend") == 0) config.backend = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-bluenoise") == 0) config.blueNoiseSize = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-slices") == 0) config.blueNoiseSlices = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-cache") == 0) config.useCache = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-selftest") == 0) config.selfTest = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-fixedpoint") == 0) config.fixedPoint = atoi(argv[i + 1]);
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return false;
+        }
+        i += 2;
+    }
+
+    if (config.frames == 0) config.frames = 1;
+    if (config.blueNoiseSlices == 0) config.blueNoiseSlices = 1;
+    if (config.transferMode < TRANSFER_REFERENCE || config.transferMode > TRANSFER_POLYNOMIAL)
+    {
+        fprintf(stderr, "Invalid transfer mode: %d\n", config.transferMode);
+        return false;
+    }
+    if (config.format < PIXEL_FORMAT_RGBA8 || config.format >= PIXEL_FORMAT_COUNT)
+    {
+        fprintf(stderr, "Invalid pixel format: %d\n", config.format);
+        return false;
+    }
+    if (config.bits > QUANTIZE_MAX_BITS)
+    {
+        fprintf(stderr, "Invalid bit depth: %u\n", config.bits);
+        return false;
+    }
+    if (config.ditherMatrixSize < BAYER_MIN_SIZE || config.ditherMatrixSize > BAYER_MAX_SIZE || (config.ditherMatrixSize & (config.ditherMatrixSize - 1)) != 0)
+    {
+        fprintf(stderr, "Invalid ordered dither matrix size: %u\n", config.ditherMatrixSize);
+        return false;
+    }
+#ifdef ENABLE_VULKAN
+    if (config.backend < 0 || config.backend > 1)
+#else
+    if (config.backend != 0)
+#endif
+    {
+        fprintf(stderr, "Invalid backend: %d (build with ENABLE_VULKAN for the Vulkan backend)\n", config.backend);
+        return false;
+    }
+    return true;
+}
+
+/**
+* Create the application's initial constants, with the noise settings of the command line.
+*/
+static BandingConstants CreateConstants(const HeadlessConfig &config, const PixelLayout &layout, uint32_t width, uint32_t height)
+{
+    BandingConstants constants = Application::Create_Constants(layout, width, height);
+    constants.useDithering = config.useDithering;
+    constants.noiseType = config.noiseType;
+    constants.distributionType = config.distributionType;
+    constants.useTonemapping = config.useTonemapping;
+    constants.ditherMatrixSize = config.ditherMatrixSize;
+    constants.noiseScale = (config.noiseScale >= 0.f) ? config.noiseScale : Quantize::Get_Noise_Scale(layout, config.distributionType);
+    return constants;
+}
+
+/**
+* Report how the blue noise was loaded, and the per-slice decode times when the PNGs were decoded.
+*/
+static void PrintLoadStats(const HeadlessConfig &config, const BlueNoiseLoadStats &stats)
+{
+    if (stats.cacheHit)
+    {
+        printf("Loaded blue noise in %.3f ms (mapped cache)\n", stats.milliseconds);
+        return;
+    }
+
+    const char* cache = !config.useCache ? "cache disabled" : (stats.cacheWritten ? "cache rebuilt" : "cache not written");
+    printf("Loaded blue noise in %.3f ms (decoded PNGs in %.3f ms, %s)\n", stats.milliseconds, stats.decodeMilliseconds, cache);
+
+    if (stats.sliceMilliseconds.empty()) return;
+    double sum = 0.0;
+    double slowest = 0.0;
+    double fastest = stats.sliceMilliseconds[0];
+    for (double time : stats.sliceMilliseconds)
+    {
+        sum += time;
+        slowest = max(slowest, time);
+        fastest = min(fastest, time);
+    }
+    printf("Per slice decode: %.3f ms min, %.3f ms avg, %.3f ms max, %.3f ms serial sum\n", fastest, sum / stats.sliceMilliseconds.size(), slowest, sum);
+}
+
+/**
+* Score the banding of every frame of a 4K noise cycle, and write the heatmap of the worst frame.
+*/
+static void ScoreNoiseCycle(ThreadPool &pool, const HeadlessConfig &config, const SoftwareSettings &settings, const NoiseTextures &textures)
+{
+    const Resolution &resolution = resolutions[2];
+    SoftwareFrame frame;
+    Software::Create_Frame(frame, resolution.width, resolution.height, settings.layout);
+    BandingConstants constants = CreateConstants(config, settings.layout, resolution.width, resolution.height);
+
+    double sum = 0.0;
+    double milliseconds = 0.0;
+    CambiResult worst;
+    worst.score = -1.0;
+    for (uint32_t i = 0; i < CAMBI_CYCLE_FRAMES; i++)
+    {
+        constants.frameNumber++;
+        Software::Render_Frame(pool, constants, settings, textures, frame);
+
+        CambiResult result = Cambi::Score(pool, frame, settings.layout, !config.heatmap.empty());
+        sum += result.score;
+        milliseconds += result.milliseconds;
+        if (result.score > worst.score) worst = move(result);
+    }
+
+    printf("CAMBI  %5ux%-5u %u frames: mean %.4f, worst %.4f (scales %.4f %.4f %.4f %.4f %.4f), %.3f ms/frame, %.3f ms total\n",
+        resolution.width, resolution.height, CAMBI_CYCLE_FRAMES, sum / CAMBI_CYCLE_FRAMES, worst.score,
+        worst.scaleScores[0], worst.scaleScores[1], worst.scaleScores[2], worst.scaleScores[3], worst.scaleScores[4],
+        milliseconds / CAMBI_CYCLE_FRAMES, milliseconds);
+
+    if (!config.heatmap.empty()) Cambi::Write_Heatmap(config.heatmap, worst);
+}
+
+/**
+* Stream 1080p frames into a temporal accumulator, and report how the dithered values converge.
+*/
+static void AccumulateFrames(ThreadPool &pool, const HeadlessConfig &config, const SoftwareSettings &settings, const NoiseTextures &textures)
+{
+    const Resolution &resolution = resolutions[1];
+    SoftwareFrame frame;
+    Software::Create_Frame(frame, resolution.width, resolution.height, settings.layout);
+    BandingConstants constants = CreateConstants(config, settings.layout, resolution.width, resolution.height);
+
+    ReferenceFrame reference;
+    Software::Create_Reference(reference, resolution.width, resolution.height);
+    Software::Render_Reference(pool, constants, settings, reference);
+
+    TemporalAccumulator accumulator;
+    Temporal::Create_Accumulator(accumulator, reference);
+
+    double milliseconds = 0.0;
+    for (uint32_t i = 0; i < config.temporal; i++)
+    {
+        constants.frameNumber++;
+        Software::Render_Frame(pool, constants, settings, textures, frame);
+
+        auto start = chrono::high_resolution_clock::now();
+        Temporal::Accumulate(pool, accumulator, frame, settings.layout);
+        chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+        milliseconds += elapsed.count();
+    }
+
+    const TemporalStats stats = Temporal::Get_Stats(pool, accumulator);
+    printf("Temporal %ux%u, %u frames (%.3f ms/frame accumulated)\n", resolution.width, resolution.height, stats.frames, milliseconds / stats.frames);
+    printf("       bias %.4f steps RMS (mean %.4f, max %.4f), deviation %.4f steps, flicker %.4f steps\n",
+        stats.bias, stats.meanBias, stats.maxBias, stats.deviation, stats.flicker);
+
+    printf("       convergence:");
+    for (uint32_t i = 1; i <= stats.frames; i *= 2) printf(" %u:%.4f", i, accumulator.convergence[i - 1]);
+    printf("\n");
+
+    for (uint32_t rate = 0; rate < accumulator.settings.numRates; rate++)
+    {
+        printf("       eye at %.0f Hz: %.4f steps RMS\n", accumulator.settings.refreshRates[rate], stats.eyeError[rate]);
+    }
+}
+
+/**
+* Run the application's Update() and Render() loop on a backend, at the default window size with
+* the light animated, and report the frame time and a checksum of the last frame, which is returned.
+*/
+static SoftwareFrame SoakBackend(RenderBackend &backend, const HeadlessConfig &config, const SoftwareSettings &settings)
+{
+    ApplicationConfig appConfig;
+    appConfig.backend.backBufferFormat = (PixelFormat)config.format;
+    appConfig.backend.customLayout = (config.bits > 0);
+    appConfig.backend.layout = settings.layout;
+    appConfig.blueNoiseSize = (int)config.blueNoiseSize;
+    appConfig.blueNoiseSlices = (int)config.blueNoiseSlices;
+
+    Application app;
+    app.Init(backend, appConfig);
+
+    // The settings the UI would otherwise change
+    FrameState &state = app.Get_State();
+    state.animateLight = true;
+    state.constants.useDithering = config.useDithering;
+    state.constants.noiseType = config.noiseType;
+    state.constants.distributionType = config.distributionType;
+    state.constants.useTonemapping = config.useTonemapping;
+    state.constants.ditherMatrixSize = config.ditherMatrixSize;
+    state.constants.noiseScale = (config.noiseScale >= 0.f) ? config.noiseScale : Quantize::Get_Noise_Scale(settings.layout, config.distributionType);
+
+    SoftwareFrame frame;
+    auto start = chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < config.soak; i++)
+    {
+        app.Update();
+        app.Render(((i + 1) == config.soak) ? &frame : nullptr);
+    }
+    chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+    app.Cleanup();
+
+    // FNV-1a of the last frame, to compare runs
+    uint32_t checksum = 2166136261u;
+    for (uint8_t value : frame.pixels) checksum = (checksum ^ value) * 16777619u;
+
+    printf("Soak   %5ux%-5u %u frames on the %s backend: %.3f ms/frame, last frame checksum %08x\n",
+        appConfig.backend.width, appConfig.backend.height, config.soak, backend.Get_Name(), elapsed.count() / config.soak, checksum);
+    return frame;
+}
+
+/**
+* Soak the selected backend. A Vulkan soak is followed by a software soak with the shader's
+* sRGB curve, and fails if any color code of their last frames is more than one apart.
+*/
+static bool SoakApplication(const HeadlessConfig &config, const SoftwareSettings &settings)
+{
+    unique_ptr<RenderBackend> backend = Backend::Create_Software(config.threads, settings.transferMode);
+#ifdef ENABLE_VULKAN
+    if (config.backend == 1)
+    {
+        fprintf(stderr, "Warning: the Vulkan backend is experimental and has not been validated against the software backend\n");
+        backend = Vulkan::Create_Backend();
+    }
+#endif
+    const SoftwareFrame frame = SoakBackend(*backend, config, settings);
+    if (config.backend == 0) return true;
+
+    unique_ptr<RenderBackend> reference = Backend::Create_Software(config.threads, TRANSFER_REFERENCE);
+    const SoftwareFrame expected = SoakBackend(*reference, config, settings);
+    if (frame.width != expected.width || frame.height != expected.height || frame.pixels.size() != expected.pixels.size())
+    {
+        printf("Soak   the %s frame is not the size of the software frame\n", backend->Get_Name());
+        return false;
+    }
+
+    // Compare the color codes, alpha is always opaque
+    const PixelLayout &layout = settings.layout;
+    vector<float> rgb[2][3];
+    for (auto &planes : rgb) for (auto &plane : planes) plane.resize(frame.width);
+
+    float maxDifference = 0.f;
+    size_t differences = 0;
+    for (uint32_t y = 0; y < frame.height; y++)
+    {
+        Quantize::Unpack_Row(layout, &frame.pixels[(size_t)y * frame.rowPitch], frame.width, rgb[0][0].data(), rgb[0][1].data(), rgb[0][2].data(), nullptr);
+        Quantize::Unpack_Row(layout, &expected.pixels[(size_t)y * expected.rowPitch], expected.width, rgb[1][0].data(), rgb[1][1].data(), rgb[1][2].data(), nullptr);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            const float maxValue = (float)((1u << layout.bits[c]) - 1);
+            for (uint32_t x = 0; x < frame.width; x++)
+            {
+                const float difference = roundf(fabsf(rgb[0][c][x] - rgb[1][c][x]) * maxValue);
+                maxDifference = max(maxDifference, difference);
+                differences += (difference > 0.f);
+            }
+        }
+    }
+
+    const bool passed = (maxDifference <= 1.f);
+    printf("Soak   %s vs software: max difference %.0f codes, %.4f%% of values differ, %s\n", backend->Get_Name(), maxDifference,
+        (100.0 * differences) / ((double)frame.width * frame.height * 3), passed ? "passed" : "FAILED");
+    return passed;
+}
+
+//--------------------------------------------------------------------------------------
+// SIMD Self Test
+//--------------------------------------------------------------------------------------
+
+static const char* const selfTestKernels[] =
+{
+    "GenerateWhiteNoiseRow", "ACESFilm", "ACESFilm_RGBA", "LinearToSRGB_LUT", "LinearToSRGB_Polynomial",
+    "SRGBToLinear_LUT", "SRGBToLinear_Polynomial", "Pack_Row", "Unpack_Row",
+};
+
+static const uint32_t SELF_TEST_KERNELS = sizeof(selfTestKernels) / sizeof(selfTestKernels[0]);
+
+struct SelfTestRow
+{
+    vector<float> planes[3];
+
+    explicit SelfTestRow(uint32_t width)
+    {
+        for (uint32_t c = 0; c < 3; c++) planes[c].resize(width);
+    }
+
+    float* operator[](uint32_t c) { return planes[c].data(); }
+    bool operator==(const SelfTestRow &other) const
+    {
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            if (memcmp(planes[c].data(), other.planes[c].data(), planes[c].size() * sizeof(float)) != 0) return false;
+        }
+        return true;
+    }
+};
+
+/**
+* Run each stage of a 720p frame through the hot kernels at every SIMD level the CPU supports, and
+* compare the results bit for bit against the scalar kernels. Each noise type is its own test frame,
+* and the first pixels of every frame are NaN, infinities, and values out of range. Returns false on any mismatch.
+*/
+static bool SelfTest(const HeadlessConfig &config, const NoiseTextures &textures)
+{
+    const Resolution &resolution = resolutions[0];
+    const uint32_t width = resolution.width;
+    const SimdLevel cpuLevel = Simd::Get_CPU_Level();
+    const float specials[] = { NAN, INFINITY, -INFINITY, -1.f, -0.f, 1e-40f, 0.0031308f, 0.04045f, 1.f, 1.0001f, 1e30f, 65504.f };
+
+    uint32_t mismatches[SELF_TEST_KERNELS][SIMD_LEVEL_COUNT] = {};
+    uint32_t rows = 0;
+
+    SelfTestRow hdr(width), noise(width), tonemapped(width), dithered(width), encoded[2] = { SelfTestRow(width), SelfTestRow(width) };
+    SelfTestRow expected(width), actual(width);
+    vector<float> rgba((size_t)width * 4), rgbaExpected(rgba.size()), rgbaActual(rgba.size());
+    vector<uint8_t> packedExpected((size_t)width * 8), packedActual(packedExpected.size());
+
+    for (int noiseType = NOISE_WHITE; noiseType < NOISE_NONE; noiseType++)
+    {
+        if ((noiseType == NOISE_BLUE && textures.blueNoiseArray.empty()) || (noiseType == NOISE_LDS_BLUE && textures.blueNoise.width == 0) ||
+            (noiseType == NOISE_SPATIOTEMPORAL_BLUE && textures.spatiotemporalArray.empty())) continue;
+
+        HeadlessConfig frameConfig = config;
+        frameConfig.noiseType = noiseType;
+        BandingConstants constants = CreateConstants(frameConfig, Quantize::Get_Layout(PIXEL_FORMAT_RGBA8), width, resolution.height);
+        constants.frameNumber += (uint32_t)noiseType;
+
+        for (uint32_t y = 0; y < resolution.height; y++, rows++)
+        {
+            // Scale the lit color into HDR, so the tonemapper sees values above 1
+            Software::Shade_Row(constants, 0, y, width, hdr[0], hdr[1], hdr[2]);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                for (uint32_t i = 0; i < width; i++) hdr[c][i] *= 4.f;
+                if (y == 0) memcpy(hdr[c], specials, sizeof(specials));
+            }
+            Noise::GetNoiseRow(constants, textures, 0, y, width, noise[0], noise[1], noise[2]);
+
+            for (uint32_t i = 0; i < width; i++)
+            {
+                for (uint32_t c = 0; c < 3; c++) rgba[i * 4 + c] = hdr[c][i];
+                rgba[i * 4 + 3] = noise[0][i];
+            }
+
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                Color::ACESFilm(SIMD_SCALAR, hdr[c], tonemapped[c], width);
+                for (uint32_t i = 0; i < width; i++) dithered[c][i] = tonemapped[c][i] + noise[c][i];
+                if (y == 0) memcpy(dithered[c], specials, sizeof(specials));
+                Color::LinearToSRGB(SIMD_SCALAR, TRANSFER_LUT, dithered[c], encoded[0][c], width);
+                Color::LinearToSRGB(SIMD_SCALAR, TRANSFER_POLYNOMIAL, dithered[c], encoded[1][c], width);
+            }
+            Color::ACESFilm_RGBA(SIMD_SCALAR, rgba.data(), rgbaExpected.data(), width);
+
+            for (int l = SIMD_SSE42; l <= (int)cpuLevel; l++)
+            {
+                const SimdLevel level = (SimdLevel)l;
+                uint32_t kernel = 0;
+
+                Noise::GenerateWhiteNoiseRow(SIMD_SCALAR, 0, y, width, width, constants.frameNumber, expected[0], expected[1], expected[2]);
+                Noise::GenerateWhiteNoiseRow(level, 0, y, width, width, constants.frameNumber, actual[0], actual[1], actual[2]);
+                mismatches[kernel++][level] += !(expected == actual);
+
+                for (uint32_t c = 0; c < 3; c++) Color::ACESFilm(level, hdr[c], actual[c], width);
+                mismatches[kernel++][level] += !(tonemapped == actual);
+
+                Color::ACESFilm_RGBA(level, rgba.data(), rgbaActual.data(), width);
+                mismatches[kernel++][level] += (memcmp(rgbaExpected.data(), rgbaActual.data(), rgba.size() * sizeof(float)) != 0);
+
+                for (int mode = TRANSFER_LUT; mode <= TRANSFER_POLYNOMIAL; mode++)
+                {
+                    for (uint32_t c = 0; c < 3; c++) Color::LinearToSRGB(level, (TransferMode)mode, dithered[c], actual[c], width);
+                    mismatches[kernel++][level] += !(encoded[mode - TRANSFER_LUT] == actual);
+                }
+
+                for (int mode = TRANSFER_LUT; mode <= TRANSFER_POLYNOMIAL; mode++)
+                {
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        Color::SRGBToLinear(SIMD_SCALAR, (TransferMode)mode, encoded[1][c], expected[c], width);
+                        Color::SRGBToLinear(level, (TransferMode)mode, encoded[1][c], actual[c], width);
+                    }
+                    mismatches[kernel++][level] += !(expected == actual);
+                }
+
+                bool packed = true;
+                bool unpacked = true;
+                for (int format = PIXEL_FORMAT_RGBA8; format < PIXEL_FORMAT_COUNT; format++)
+                {
+                    const PixelLayout layout = Quantize::Get_Layout((PixelFormat)format);
+                    const size_t bytes = (size_t)width * layout.bytesPerPixel;
+                    Quantize::Pack_Row(SIMD_SCALAR, layout, encoded[1][0], encoded[1][1], encoded[1][2], noise[0], width, packedExpected.data());
+                    Quantize::Pack_Row(level, layout, encoded[1][0], encoded[1][1], encoded[1][2], noise[0], width, packedActual.data());
+                    packed &= (memcmp(packedExpected.data(), packedActual.data(), bytes) == 0);
+
+                    Quantize::Unpack_Row(SIMD_SCALAR, layout, packedExpected.data(), width, expected[0], expected[1], expected[2], nullptr);
+                    Quantize::Unpack_Row(level, layout, packedExpected.data(), width, actual[0], actual[1], actual[2], nullptr);
+                    unpacked &= (expected == actual);
+                }
+                mismatches[kernel++][level] += !packed;
+                mismatches[kernel++][level] += !unpacked;
+            }
+        }
+    }
+
+    printf("SIMD self test: %u rows of %ux%u test frames, CPU supports %s\n", rows, width, resolution.height, Simd::Get_Level_Name(cpuLevel));
+
+    bool passed = true;
+    for (uint32_t kernel = 0; kernel < SELF_TEST_KERNELS; kernel++)
+    {
+        printf("  %-24s", selfTestKernels[kernel]);
+        for (int l = SIMD_SSE42; l <= (int)cpuLevel; l++)
+        {
+            if (mismatches[kernel][l] == 0) printf(" %s ok", Simd::Get_Level_Name((SimdLevel)l));
+            else printf(" %s FAILED on %u rows", Simd::Get_Level_Name((SimdLevel)l), mismatches[kernel][l]);
+            passed &= (mismatches[kernel][l] == 0);
+        }
+        printf("\n");
+    }
+    printf("SIMD self test %s\n", passed ? "passed" : "FAILED");
+    return passed;
+}
+
+/**
+* Dither 1080p frames of 16-bit linear color (the lit, tonemapped scene) to R8G8B8A8 with the fixed point
+* pipeline and with the float path, and report the speed of both and how far apart their codes are.
+*/
+static bool CompareFixedPoint(ThreadPool &pool, const HeadlessConfig &config, const SoftwareSettings &settings, const NoiseTextures &textures)
+{
+    const Resolution &resolution = resolutions[1];
+    const uint32_t width = resolution.width;
+    const PixelLayout layout = Quantize::Get_Layout(PIXEL_FORMAT_RGBA8);
+    const PixelLayout linearLayout = Quantize::Get_Layout(PIXEL_FORMAT_RGBA16);
+    BandingConstants constants = CreateConstants(config, layout, width, resolution.height);
+
+    SoftwareFrame linear, fixedFrame, floatFrame;
+    Software::Create_Frame(linear, width, resolution.height, linearLayout);
+    Software::Create_Frame(fixedFrame, width, resolution.height, layout);
+    Software::Create_Frame(floatFrame, width, resolution.height, layout);
+
+    Threading::Parallel_For(pool, resolution.height, [&](uint32_t y)
+    {
+        vector<float> row((size_t)width * 3);
+        float* rgb[3] = { &row[0], &row[width], &row[(size_t)width * 2] };
+        Software::Shade_Row(constants, 0, y, width, rgb[0], rgb[1], rgb[2]);
+        if (constants.useTonemapping)
+        {
+            for (uint32_t c = 0; c < 3; c++) Color::ACESFilm(rgb[c], rgb[c], width);
+        }
+        Quantize::Pack_Row(linearLayout, rgb[0], rgb[1], rgb[2], nullptr, width, &linear.pixels[(size_t)y * linear.rowPitch]);
+    });
+
+    PixelSpan src;
+    src.data = linear.pixels.data();
+    src.size = linear.pixels.size();
+    src.rowPitch = linear.rowPitch;
+
+    double fixedMilliseconds = 0.0;
+    double floatMilliseconds = 0.0;
+    int maxDifference = 0;
+    size_t differences = 0;
+    for (uint32_t i = 0; i < config.frames; i++)
+    {
+        constants.frameNumber++;
+
+        auto start = chrono::high_resolution_clock::now();
+        FixedPoint::Dither_Frame(pool, constants, textures, src, fixedFrame);
+        chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - start;
+        fixedMilliseconds += elapsed.count();
+
+        // Dither in float a tile width at a time, in buffers on the stack like the software renderer
+        start = chrono::high_resolution_clock::now();
+        Threading::Parallel_For(pool, resolution.height, [&](uint32_t y)
+        {
+            float rgba[4][SOFTWARE_TILE_SIZE];
+            float noise[3][SOFTWARE_TILE_SIZE];
+            for (uint32_t x = 0; x < width; x += SOFTWARE_TILE_SIZE)
+            {
+                const uint32_t span = min(width - x, SOFTWARE_TILE_SIZE);
+                Quantize::Unpack_Row(linearLayout, &linear.pixels[(size_t)y * linear.rowPitch + (size_t)x * linearLayout.bytesPerPixel], span, rgba[0], rgba[1], rgba[2], rgba[3]);
+                if (constants.useDithering > 0) Noise::GetNoiseRow(constants, textures, x, y, span, noise[0], noise[1], noise[2]);
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    if (constants.useDithering > 0)
+                    {
+                        for (uint32_t j = 0; j < span; j++) rgba[c][j] += noise[c][j];
+                    }
+                    Color::LinearToSRGB(settings.transferMode, rgba[c], rgba[c], span);
+                }
+                Quantize::Pack_Row(layout, rgba[0], rgba[1], rgba[2], rgba[3], span, &floatFrame.pixels[(size_t)y * floatFrame.rowPitch + (size_t)x * layout.bytesPerPixel]);
+            }
+        });
+        elapsed = chrono::high_resolution_clock::now() - start;
+        floatMilliseconds += elapsed.count();
+
+        for (size_t j = 0; j < fixedFrame.pixels.size(); j++)
+        {
+            const int difference = abs((int)fixedFrame.pixels[j] - (int)floatFrame.pixels[j]);
+            maxDifference = max(maxDifference, difference);
+            differences += (difference != 0);
+        }
+    }
+
+    const double pixels = (double)width * resolution.height * config.frames;
+    printf("Fixed point %ux%u, %u frames\n", width, resolution.height, config.frames);
+    printf("       fixed point %8.3f ms/frame %10.2f Mpixel/s\n", fixedMilliseconds / config.frames, (pixels / fixedMilliseconds) / 1e3);
+    printf("       float       %8.3f ms/frame %10.2f Mpixel/s\n", floatMilliseconds / config.frames, (pixels / floatMilliseconds) / 1e3);
+    printf("       max difference %d codes, %.4f%% of values differ over all frames\n", maxDifference, (100.0 * differences) / ((double)fixedFrame.pixels.size() * config.frames));
+
+    const bool passed = (maxDifference <= 1);
+    printf("Fixed point comparison %s\n", passed ? "passed" : "FAILED");
+    return passed;
+}
+
+/**
+* Render each standard resolution with the software renderer and report throughput.
+*/
+int main(int argc, char** argv)
+{
+    HeadlessConfig config;
+    if (!ParseCommandLine(argc, argv, config))
+    {
+        fprintf(stderr, "Usage: %s [-threads N] [-frames N] [-dither 0|1] [-noise 0|1|2|3|4] [-matrix SIZE] [-distribution 0|1] [-tonemap 0|1] [-transfer 0|1|2] [-format 0|1|2|3] [-bits N] [-scale F] [-metrics 0|1] [-cambi 0|1] [-heatmap FILE] [-temporal N] [-soak N] [-backend 0|1] [-bluenoise SIZE] [-slices N] [-cache 0|1] [-selftest 0|1] [-fixedpoint 0|1]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SoftwareSettings settings;
+    settings.transferMode = (TransferMode)config.transferMode;
+    try
+    {
+        if (config.bits > 0) settings.layout = Quantize::Create_Layout(config.bits, config.bits, config.bits, 0);
+        else settings.layout = Quantize::Get_Layout((PixelFormat)config.format);
+
+        // The application loads its own blue noise, so the soak skips everything else
+        if (config.soak > 0)
+        {
+            return SoakApplication(config, settings) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    catch (const exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool;
+    Threading::Create(pool, config.threads);
+
+    NoiseTextures textures;
+    try
+    {
+        if (config.blueNoiseSize > 0)
+        {
+            auto start = chrono::high_resolution_clock::now();
+            BlueNoise::Generate_Textures(pool, textures, config.blueNoiseSize, config.blueNoiseSlices, 0);
+            chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+            printf("Generated %ux%ux%u blue noise in %.3f s\n", config.blueNoiseSize, config.blueNoiseSize, config.blueNoiseSlices, elapsed.count());
+        }
+        else
+        {
+            BlueNoiseLoadStats stats;
+            if (config.useCache) BlueNoise::Load_Textures(pool, textures, 64, &stats);
+            else BlueNoise::Load_Textures_From_PNG(pool, textures, 64, &stats);
+            PrintLoadStats(config, stats);
+        }
+
+        if (config.noiseType == 3 || config.selfTest)
+        {
+            auto start = chrono::high_resolution_clock::now();
+            bool cacheHit = false;
+            if (config.useCache) cacheHit = BlueNoise::Load_Spatiotemporal_Textures(pool, textures, BLUE_NOISE_SPATIOTEMPORAL_SIZE, BLUE_NOISE_SPATIOTEMPORAL_SLICES, 0);
+            else BlueNoise::Generate_Spatiotemporal_Textures(pool, textures, BLUE_NOISE_SPATIOTEMPORAL_SIZE, BLUE_NOISE_SPATIOTEMPORAL_SLICES, 0);
+            chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+            printf("%s %ux%ux%u spatiotemporal blue noise in %.3f s\n", cacheHit ? "Mapped" : "Generated", BLUE_NOISE_SPATIOTEMPORAL_SIZE, BLUE_NOISE_SPATIOTEMPORAL_SIZE, BLUE_NOISE_SPATIOTEMPORAL_SLICES, elapsed.count());
+        }
+    }
+    catch (const exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        Threading::Destroy(pool);
+        return EXIT_FAILURE;
+    }
+
+    if (config.selfTest)
+    {
+        const bool passed = SelfTest(config, textures);
+        Threading::Destroy(pool);
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (config.fixedPoint)
+    {
+        bool passed = false;
+        try
+        {
+            passed = CompareFixedPoint(pool, config, settings, textures);
+        }
+        catch (const exception &e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+        }
+        Threading::Destroy(pool);
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    printf("Software renderer: %u threads, %u frames per resolution\n", Threading::Get_Thread_Count(pool), config.frames);
+    if (config.bits > 0) printf("Quantizing to %u bits per channel, %u bytes per pixel\n", config.bits, settings.layout.bytesPerPixel);
+    else printf("Quantizing to %s\n", Quantize::Get_Format_Name((PixelFormat)config.format));
+
+    for (const Resolution &resolution : resolutions)
+    {
+        SoftwareFrame frame;
+        Software::Create_Frame(frame, resolution.width, resolution.height, settings.layout);
+        BandingConstants constants = CreateConstants(config, settings.layout, resolution.width, resolution.height);
+
+        // Warm up
+        Software::Render_Frame(pool, constants, settings, textures, frame);
+
+        auto start = chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < config.frames; i++)
+        {
+            constants.frameNumber++;
+            Software::Render_Frame(pool, constants, settings, textures, frame);
+        }
+        chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+
+        const double pixels = (double)resolution.width * resolution.height * config.frames;
+        printf("%-6s %5ux%-5u %8.3f ms/frame %10.2f Mpixel/s\n",
+            resolution.name, resolution.width, resolution.height,
+            (elapsed.count() * 1000.0) / config.frames, (pixels / elapsed.count()) / 1e6);
+
+        if (config.metrics)
+        {
+            ReferenceFrame reference;
+            Software::Create_Reference(reference, resolution.width, resolution.height);
+            Software::Render_Reference(pool, constants, settings, reference);
+
+            const QualityMetrics metrics = Metrics::Compare(pool, reference, frame, settings.layout);
+            printf("       PSNR %.3f dB, SSIM %.6f, banding %.4f steps over %.1f%% of windows (%.3f ms)\n",
+                metrics.psnr, metrics.ssim, metrics.banding, metrics.smoothFraction * 100.0, metrics.milliseconds);
+        }
+    }
+
+    if (config.cambi)
+    {
+        try
+        {
+            ScoreNoiseCycle(pool, config, settings, textures);
+        }
+        catch (const exception &e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            Threading::Destroy(pool);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (config.temporal > 0)
+    {
+        try
+        {
+            AccumulateFrames(pool, config, settings, textures);
+        }
+        catch (const exception &e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            Threading::Destroy(pool);
+            return EXIT_FAILURE;
+        }
+    }
+
+    Threading::Destroy(pool);
+    return EXIT_SUCCESS;
+}
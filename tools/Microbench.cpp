@@ -0,0 +1,498 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BlueNoise.h"
+#include "Color.h"
+#include "Noise.h"
+#include "Quantize.h"
+#include "Simd.h"
+#include "Threading.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+static const uint32_t MIN_ITERATIONS = 3;
+
+struct BenchConfig
+{
+    string      threads = "1,0";                // comma separated, 0 is every hardware thread
+    string      resolutions = "720p,1080p,4K";  // comma separated names or WxH
+    string      kernels;                        // only run kernels whose name contains this, when set
+    float       seconds = 0.25f;                // minimum time per measurement
+    string      output;                         // write the JSON here instead of stdout, when set
+};
+
+struct Resolution
+{
+    string      name;
+    uint32_t    width;
+    uint32_t    height;
+};
+
+static const Resolution namedResolutions[] =
+{
+    { "720p",   1280,  720 },
+    { "1080p",  1920, 1080 },
+    { "4K",     3840, 2160 },
+    { "8K",     7680, 4320 },
+};
+
+// Row buffers of one thread, grown to the widest row it has run. They stay in cache, as the
+// tile buffers of the software renderer do, so the kernels are measured without DRAM traffic.
+struct RowBuffers
+{
+    vector<float>       input[3];       // sRGB encoded or linear values in [0, 1]
+    vector<float>       hdr[3];         // linear values in [0, 8], for tonemapping
+    vector<float>       output[3];
+    vector<uint32_t>    words;
+    vector<uint8_t>     packed;
+    uint32_t            width = 0;
+};
+
+struct Kernel
+{
+    string      name;
+    SimdLevel   level;
+    uint32_t    bytesPerPixel;          // read and written
+    function<void(RowBuffers&, uint32_t y, uint32_t width)> row;
+};
+
+struct Result
+{
+    const Kernel*   kernel;
+    Resolution      resolution;
+    uint32_t        threads;
+    uint32_t        iterations;
+    double          nsPerPixel;
+    double          gbPerSecond;
+    double          cyclesPerPixel;     // time stamp counter ticks on every thread, per pixel
+};
+
+/**
+* Read the time stamp counter, or 0 when the CPU has none.
+*/
+static uint64_t ReadTimestamp()
+{
+#if SIMD_X86
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+* Split a comma separated list.
+*/
+static vector<string> SplitList(const string &list)
+{
+    vector<string> items;
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t end = list.find(',', start);
+        if (end == string::npos) end = list.size();
+        if (end > start) items.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return items;
+}
+
+/**
+* Parse the command line.
+*/
+static bool ParseCommandLine(int argc, char** argv, BenchConfig &config)
+{
+    int i = 1;
+    while (i < argc)
+    {
+        if ((i + 1) >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        if (strcmp(argv[i], "-threads") == 0) config.threads = argv[i + 1];
+        else if (strcmp(argv[i], "-resolutions") == 0) config.resolutions = argv[i + 1];
+        else if (strcmp(argv[i], "-kernels") == 0) config.kernels = argv[i + 1];
+        else if (strcmp(argv[i], "-time") == 0) config.seconds = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-out") == 0) config.output = argv[i + 1];
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return false;
+        }
+        i += 2;
+    }
+
+    if (!(config.seconds > 0.f))
+    {
+        fprintf(stderr, "Invalid time: %f\n", config.seconds);
+        return false;
+    }
+    return true;
+}
+
+/**
+* Parse the thread counts, where 0 is every hardware thread.
+*/
+static bool ParseThreads(const string &list, vector<uint32_t> &threads)
+{
+    const uint32_t hardwareThreads = max(1u, thread::hardware_concurrency());
+    for (const string &item : SplitList(list))
+    {
+        const int count = atoi(item.c_str());
+        if (count < 0 || (count == 0 && item != "0"))
+        {
+            fprintf(stderr, "Invalid thread count: %s\n", item.c_str());
+            return false;
+        }
+        const uint32_t value = (count == 0) ? hardwareThreads : (uint32_t)count;
+        if (find(threads.begin(), threads.end(), value) == threads.end()) threads.push_back(value);
+    }
+    return !threads.empty();
+}
+
+/**
+* Parse the resolutions, by name (720p, 1080p, 4K, 8K) or as WxH.
+*/
+static bool ParseResolutions(const string &list, vector<Resolution> &resolutions)
+{
+    for (const string &item : SplitList(list))
+    {
+        bool found = false;
+        for (const Resolution &named : namedResolutions)
+        {
+            if (item == named.name)
+            {
+                resolutions.push_back(named);
+                found = true;
+            }
+        }
+
+        uint32_t width = 0, height = 0;
+        if (!found && sscanf(item.c_str(), "%ux%u", &width, &height) == 2 && width > 0 && height > 0)
+        {
+            resolutions.push_back({ item, width, height });
+            found = true;
+        }
+
+        if (!found)
+        {
+            fprintf(stderr, "Invalid resolution: %s\n", item.c_str());
+            return false;
+        }
+    }
+    return !resolutions.empty();
+}
+
+/**
+* Build the kernel table: the scalar building blocks once, and the batch kernels at every
+* SIMD level the CPU supports.
+*/
+static vector<Kernel> CreateKernels(const BandingConstants &constants, const NoiseTextures &textures)
+{
+    vector<Kernel> kernels;
+
+    kernels.push_back({ "WangHash", SIMD_SCALAR, 4, [](RowBuffers &buffers, uint32_t y, uint32_t width)
+    {
+        uint32_t* words = buffers.words.data();
+        for (uint32_t x = 0; x < width; x++) words[x] = Noise::WangHash((y * width) + x);
+    }});
+
+    kernels.push_back({ "Xorshift", SIMD_SCALAR, 4, [](RowBuffers &buffers, uint32_t y, uint32_t width)
+    {
+        uint32_t* words = buffers.words.data();
+        for (uint32_t x = 0; x < width; x++) words[x] = Noise::Xorshift((y * width) + x + 1);
+    }});
+
+    kernels.push_back({ "GenerateRandomNumber", SIMD_SCALAR, 4, [](RowBuffers &buffers, uint32_t y, uint32_t width)
+    {
+        float* output = buffers.output[0].data();
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint32_t seed = (y * width) + x;
+            output[x] = Noise::GenerateRandomNumber(seed);
+        }
+    }});
+
+    kernels.push_back({ "ToTriangular", SIMD_SCALAR, 8, [](RowBuffers &buffers, uint32_t, uint32_t width)
+    {
+        const float* input = buffers.input[0].data();
+        float* output = buffers.output[0].data();
+        for (uint32_t x = 0; x < width; x++) output[x] = Noise::ToTriangular(input[x]);
+    }});
+
+    // The row functions of the renderer, with a uniform distribution. White noise uses the widest batch kernel.
+    kernels.push_back({ "WhiteNoise", Simd::Get_Level(), 12, [&constants](RowBuffers &buffers, uint32_t y, uint32_t width)
+    {
+        Noise::GetWhiteNoiseRow(constants, 0, y, width, buffers.output[0].data(), buffers.output[1].data(), buffers.output[2].data());
+    }});
+
+    kernels.push_back({ "BlueNoise", SIMD_SCALAR, 16, [&constants, &textures](RowBuffers &buffers, uint32_t y, uint32_t width)
+    {
+        Noise::GetBlueNoiseRow(constants, textures, 0, y, width, buffers.output[0].data(), buffers.output[1].data(), buffers.output[2].data());
+    }});
+
+    kernels.push_back({ "LDSBlueNoise", SIMD_SCALAR, 16, [&constants, &textures](RowBuffers &buffers, uint32_t y, uint32_t width)
+    {
+        Noise::GetLDSBlueNoiseRow(constants, textures, 0, y, width, buffers.output[0].data(), buffers.output[1].data(), buffers.output[2].data());
+    }});
+
+    const SimdLevel maxLevel = Simd::Get_Level();
+    for (int l = SIMD_SCALAR; l <= (int)maxLevel; l++)
+    {
+        const SimdLevel level = (SimdLevel)l;
+
+        kernels.push_back({ "GenerateWhiteNoiseRow", level, 12, [level, &constants](RowBuffers &buffers, uint32_t y, uint32_t width)
+        {
+            Noise::GenerateWhiteNoiseRow(level, 0, y, width, width, constants.frameNumber, buffers.output[0].data(), buffers.output[1].data(), buffers.output[2].data());
+        }});
+
+        kernels.push_back({ "ACESFilm", level, 24, [level](RowBuffers &buffers, uint32_t, uint32_t width)
+        {
+            for (uint32_t c = 0; c < 3; c++) Color::ACESFilm(level, buffers.hdr[c].data(), buffers.output[c].data(), width);
+        }});
+
+        static const char* transferNames[] = { "LinearToSRGB_Reference", "LinearToSRGB_LUT", "LinearToSRGB_Polynomial" };
+        for (int mode = TRANSFER_REFERENCE; mode <= TRANSFER_POLYNOMIAL; mode++)
+        {
+            kernels.push_back({ transferNames[mode], level, 24, [level, mode](RowBuffers &buffers, uint32_t, uint32_t width)
+            {
+                for (uint32_t c = 0; c < 3; c++) Color::LinearToSRGB(level, (TransferMode)mode, buffers.input[c].data(), buffers.output[c].data(), width);
+            }});
+        }
+
+        for (int format = 0; format < PIXEL_FORMAT_COUNT; format++)
+        {
+            const PixelLayout layout = Quantize::Get_Layout((PixelFormat)format);
+            kernels.push_back({ string("Pack_Row_") + Quantize::Get_Format_Name((PixelFormat)format), level, 12 + layout.bytesPerPixel, [level, layout](RowBuffers &buffers, uint32_t, uint32_t width)
+            {
+                Quantize::Pack_Row(level, layout, buffers.input[0].data(), buffers.input[1].data(), buffers.input[2].data(), nullptr, width, buffers.packed.data());
+            }});
+        }
+    }
+    return kernels;
+}
+
+/**
+* Fill the row buffers with a gradient, offset per channel.
+*/
+static void CreateRowBuffers(RowBuffers &buffers, uint32_t width)
+{
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        buffers.input[c].resize(width);
+        buffers.hdr[c].resize(width);
+        buffers.output[c].resize(width);
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const float t = fmodf(((float)x + 0.5f) / (float)width + (float)c / 3.f, 1.f);
+            buffers.input[c][x] = t;
+            buffers.hdr[c][x] = t * 8.f;
+        }
+    }
+    buffers.words.resize(width);
+    buffers.packed.resize((size_t)width * 8);
+    buffers.width = width;
+}
+
+/**
+* Create one set of row buffers per band for a resolution, once, before any kernel is timed.
+* Each band is timed as one job, so no two workers share a set.
+*/
+static void CreateBands(vector<RowBuffers> &bands, uint32_t numBands, const Resolution &resolution)
+{
+    bands.clear();
+    bands.resize(numBands);
+    for (RowBuffers &rows : bands) CreateRowBuffers(rows, resolution.width);
+}
+
+/**
+* Time a kernel over every row of a resolution, repeating whole frames until the minimum time has passed.
+* The rows are split into one contiguous band per set of buffers.
+*/
+static Result RunKernel(ThreadPool &pool, const Kernel &kernel, const Resolution &resolution, vector<RowBuffers> &bands, float seconds)
+{
+    const uint32_t numBands = (uint32_t)bands.size();
+    const uint32_t bandSize = (resolution.height + numBands - 1) / numBands;
+    auto frame = [&](uint32_t band)
+    {
+        RowBuffers &rows = bands[band];
+        const uint32_t first = min(band * bandSize, resolution.height);
+        const uint32_t last = min(first + bandSize, resolution.height);
+        for (uint32_t y = first; y < last; y++) kernel.row(rows, y, resolution.width);
+    };
+
+    // Warm up the caches, the table, and the workers
+    Threading::Parallel_For(pool, numBands, frame);
+
+    uint32_t iterations = 0;
+    chrono::duration<double> elapsed(0.0);
+    const auto start = chrono::high_resolution_clock::now();
+    const uint64_t startTicks = ReadTimestamp();
+    while (iterations < MIN_ITERATIONS || elapsed.count() < seconds)
+    {
+        Threading::Parallel_For(pool, numBands, frame);
+        iterations++;
+        elapsed = chrono::high_resolution_clock::now() - start;
+    }
+    const uint64_t ticks = ReadTimestamp() - startTicks;
+
+    const double pixels = (double)resolution.width * resolution.height * iterations;
+    const uint32_t threads = Threading::Get_Thread_Count(pool);
+
+    Result result;
+    result.kernel = &kernel;
+    result.resolution = resolution;
+    result.threads = threads;
+    result.iterations = iterations;
+    result.nsPerPixel = (elapsed.count() * 1e9) / pixels;
+    result.gbPerSecond = (pixels * kernel.bytesPerPixel) / (elapsed.count() * 1e9);
+    result.cyclesPerPixel = ((double)ticks * threads) / pixels;
+    return result;
+}
+
+/**
+* Write the results as JSON.
+*/
+static void WriteResults(FILE* file, const vector<Result> &results, float seconds)
+{
+    fprintf(file, "{\n");
+    fprintf(file, "  \"cpu\": { \"simdLevel\": \"%s\", \"hardwareThreads\": %u, \"timestampCounter\": %s },\n",
+        Simd::Get_Level_Name(Simd::Get_Level()), thread::hardware_concurrency(), SIMD_X86 ? "true" : "false");
+    fprintf(file, "  \"minSeconds\": %.3f,\n", seconds);
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result &result = results[i];
+        fprintf(file, "    { \"kernel\": \"%s\", \"simd\": \"%s\", \"resolution\": \"%s\", \"width\": %u, \"height\": %u, \"threads\": %u, \"iterations\": %u, "
+            "\"nsPerPixel\": %.4f, \"gbPerSecond\": %.3f, \"cyclesPerPixel\": %.3f }%s\n",
+            result.kernel->name.c_str(), Simd::Get_Level_Name(result.kernel->level), result.resolution.name.c_str(), result.resolution.width, result.resolution.height,
+            result.threads, result.iterations, result.nsPerPixel, result.gbPerSecond, result.cyclesPerPixel, (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+}
+
+/**
+* Time every noise, tonemap, transfer, and pack kernel at each resolution and thread count,
+* and write the results as JSON.
+*/
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+    vector<uint32_t> threadCounts;
+    vector<Resolution> resolutions;
+    if (!ParseCommandLine(argc, argv, config) || !ParseThreads(config.threads, threadCounts) || !ParseResolutions(config.resolutions, resolutions))
+    {
+        fprintf(stderr, "Usage: %s [-threads LIST] [-resolutions LIST] [-kernels NAME] [-time SECONDS] [-out FILE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool loader;
+    Threading::Create(loader);
+
+    int result = EXIT_SUCCESS;
+    try
+    {
+        NoiseTextures textures;
+        BlueNoise::Load_Textures(loader, textures, 64);
+
+        BandingConstants constants = {};
+        constants.useDithering = 1;
+        constants.noiseScale = 1.f / 255.f;
+        constants.frameNumber = 1;
+
+        const vector<Kernel> kernels = CreateKernels(constants, textures);
+
+        vector<Result> results;
+        for (uint32_t threads : threadCounts)
+        {
+            ThreadPool pool;
+            Threading::Create(pool, threads);
+
+            try
+            {
+                vector<RowBuffers> bands;
+                for (const Resolution &resolution : resolutions)
+                {
+                    constants.resolutionX = resolution.width;
+                    CreateBands(bands, Threading::Get_Thread_Count(pool), resolution);
+                    for (const Kernel &kernel : kernels)
+                    {
+                        if (!config.kernels.empty() && kernel.name.find(config.kernels) == string::npos) continue;
+
+                        results.push_back(RunKernel(pool, kernel, resolution, bands, config.seconds));
+                        const Result &last = results.back();
+                        fprintf(stderr, "%-26s %-7s %-6s %2u threads: %8.3f ns/pixel %8.2f GB/s %8.2f cycles/pixel\n",
+                            kernel.name.c_str(), Simd::Get_Level_Name(kernel.level), resolution.name.c_str(), last.threads, last.nsPerPixel, last.gbPerSecond, last.cyclesPerPixel);
+                    }
+                }
+            }
+            catch (...)
+            {
+                Threading::Destroy(pool);
+                throw;
+            }
+            Threading::Destroy(pool);
+        }
+
+        if (config.output.empty())
+        {
+            WriteResults(stdout, results, config.seconds);
+        }
+        else
+        {
+            FILE* file = fopen(config.output.c_str(), "w");
+            if (!file) throw runtime_error("Error: failed to open " + config.output + "!");
+            WriteResults(file, results, config.seconds);
+            fclose(file);
+        }
+    }
+    catch (const exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        result = EXIT_FAILURE;
+    }
+
+    Threading::Destroy(loader);
+    return result;
+}
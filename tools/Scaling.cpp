@@ -0,0 +1,421 @@
+/* Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Application.h"
+#include "BlueNoise.h"
+#include "Noise.h"
+#include "Quantize.h"
+#include "Software.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const size_t FILL_BUFFER_SIZE = 256 * 1024 * 1024;
+static const size_t FILL_CHUNK_SIZE = 1024 * 1024;
+static const float BANDWIDTH_BOUND_FRACTION = 0.75f;     // of the fill bandwidth
+
+struct ScalingConfig
+{
+    uint32_t    threads = 0;                    // largest thread count, 0 is every hardware thread
+    string      maxResolution = "16K";
+    string      weakBase = "1080p";             // pixels per thread of the weak scaling runs
+    float       seconds = 0.5f;                 // minimum time per measurement
+    int         noiseType = 1;
+    int         transferMode = TRANSFER_POLYNOMIAL;
+    int         format = PIXEL_FORMAT_RGBA8;
+    string      output;                         // write the results as JSON here, when set
+};
+
+struct Resolution
+{
+    const char* name;
+    uint32_t    width;
+    uint32_t    height;
+};
+
+static const Resolution resolutions[] =
+{
+    { "360p",    640,   360 },                  // the ConfigInfo default
+    { "720p",   1280,   720 },
+    { "1080p",  1920,  1080 },
+    { "1440p",  2560,  1440 },
+    { "4K",     3840,  2160 },
+    { "8K",     7680,  4320 },
+    { "16K",   15360,  8640 },
+};
+
+struct Measurement
+{
+    string      name;
+    uint32_t    width = 0;
+    uint32_t    height = 0;
+    uint32_t    threads = 0;
+    uint32_t    frames = 0;
+    double      milliseconds = 0.0;             // per frame
+    double      efficiency = 0.0;
+    double      gbPerSecond = 0.0;              // frame bytes written
+    double      bandwidthFraction = 0.0;        // of the fill bandwidth at the same thread count
+};
+
+struct BandwidthBound
+{
+    string      name;
+    uint32_t    threads = 0;                    // first measured thread count that is bandwidth bound, 0 when none
+    double      projectedThreads = 0.0;         // where the measured per-thread traffic would reach the bound
+};
+
+/**
+* Find a resolution by name.
+*/
+static int FindResolution(const string &name)
+{
+    for (int i = 0; i < (int)(sizeof(resolutions) / sizeof(resolutions[0])); i++)
+    {
+        if (name == resolutions[i].name) return i;
+    }
+    return -1;
+}
+
+/**
+* Parse the command line.
+*/
+static bool ParseCommandLine(int argc, char** argv, ScalingConfig &config)
+{
+    int i = 1;
+    while (i < argc)
+    {
+        if ((i + 1) >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        if (strcmp(argv[i], "-threads") == 0) config.threads = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-max-resolution") == 0) config.maxResolution = argv[i + 1];
+        else if (strcmp(argv[i], "-weak-base") == 0) config.weakBase = argv[i + 1];
+        else if (strcmp(argv[i], "-time") == 0) config.seconds = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-noise") == 0) config.noiseType = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-transfer") == 0) config.transferMode = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-format") == 0) config.format = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-out") == 0) config.output = argv[i + 1];
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return false;
+        }
+        i += 2;
+    }
+
+    if (FindResolution(config.maxResolution) < 0)
+    {
+        fprintf(stderr, "Invalid resolution: %s\n", config.maxResolution.c_str());
+        return false;
+    }
+    if (FindResolution(config.weakBase) < 0)
+    {
+        fprintf(stderr, "Invalid resolution: %s\n", config.weakBase.c_str());
+        return false;
+    }
+    if (!(config.seconds > 0.f))
+    {
+        fprintf(stderr, "Invalid time: %f\n", config.seconds);
+        return false;
+    }
+    if (config.noiseType < 0 || config.noiseType > 4)
+    {
+        fprintf(stderr, "Invalid noise type: %d\n", config.noiseType);
+        return false;
+    }
+    if (config.transferMode < TRANSFER_REFERENCE || config.transferMode > TRANSFER_POLYNOMIAL)
+    {
+        fprintf(stderr, "Invalid transfer mode: %d\n", config.transferMode);
+        return false;
+    }
+    if (config.format < PIXEL_FORMAT_RGBA8 || config.format >= PIXEL_FORMAT_COUNT)
+    {
+        fprintf(stderr, "Invalid pixel format: %d\n", config.format);
+        return false;
+    }
+    return true;
+}
+
+/**
+* Thread counts from 1 to the largest, doubling, plus the largest.
+*/
+static vector<uint32_t> GetThreadCounts(uint32_t maxThreads)
+{
+    vector<uint32_t> counts;
+    for (uint32_t count = 1; count < maxThreads; count *= 2) counts.push_back(count);
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+/**
+* Create the application's initial constants, with the noise type of the command line.
+*/
+static BandingConstants CreateConstants(const ScalingConfig &config, const PixelLayout &layout, uint32_t width, uint32_t height)
+{
+    BandingConstants constants = Application::Create_Constants(layout, width, height);
+    constants.noiseType = config.noiseType;
+    return constants;
+}
+
+/**
+* Measure the rate the pool can write memory, with each thread filling 1 MB chunks of a buffer
+* much larger than the caches. Frames are written the same way, one tile row at a time.
+*/
+static double MeasureFillBandwidth(ThreadPool &pool, vector<uint8_t> &buffer, float seconds)
+{
+    const uint32_t numChunks = (uint32_t)(buffer.size() / FILL_CHUNK_SIZE);
+    uint8_t value = 0;
+    auto fill = [&](uint32_t chunk)
+    {
+        memset(&buffer[(size_t)chunk * FILL_CHUNK_SIZE], value, FILL_CHUNK_SIZE);
+    };
+
+    // Warm up, which also faults in the pages
+    Threading::Parallel_For(pool, numChunks, fill);
+
+    uint32_t passes = 0;
+    chrono::duration<double> elapsed(0.0);
+    const auto start = chrono::high_resolution_clock::now();
+    while (passes < 2 || elapsed.count() < seconds)
+    {
+        value++;
+        Threading::Parallel_For(pool, numChunks, fill);
+        passes++;
+        elapsed = chrono::high_resolution_clock::now() - start;
+    }
+    return ((double)buffer.size() * passes) / (elapsed.count() * 1e9);
+}
+
+/**
+* Render frames until the minimum time has passed, after a warm up frame, and return the frame count and time.
+*/
+static Measurement TimeFrames(ThreadPool &pool, const ScalingConfig &config, const SoftwareSettings &settings, const NoiseTextures &textures, SoftwareFrame &frame)
+{
+    BandingConstants constants = CreateConstants(config, settings.layout, frame.width, frame.height);
+    Software::Render_Frame(pool, constants, settings, textures, frame);
+
+    Measurement measurement;
+    measurement.width = frame.width;
+    measurement.height = frame.height;
+    measurement.threads = Threading::Get_Thread_Count(pool);
+
+    chrono::duration<double> elapsed(0.0);
+    const auto start = chrono::high_resolution_clock::now();
+    while (measurement.frames == 0 || elapsed.count() < config.seconds)
+    {
+        constants.frameNumber++;
+        Software::Render_Frame(pool, constants, settings, textures, frame);
+        measurement.frames++;
+        elapsed = chrono::high_resolution_clock::now() - start;
+    }
+
+    measurement.milliseconds = (elapsed.count() * 1000.0) / measurement.frames;
+    measurement.gbPerSecond = ((double)frame.pixels.size() * measurement.frames) / (elapsed.count() * 1e9);
+    return measurement;
+}
+
+/**
+* Write a list of measurements as a JSON array.
+*/
+static void WriteMeasurements(FILE* file, const char* name, const vector<Measurement> &measurements, bool last)
+{
+    fprintf(file, "  \"%s\": [\n", name);
+    for (size_t i = 0; i < measurements.size(); i++)
+    {
+        const Measurement &m = measurements[i];
+        fprintf(file, "    { \"resolution\": \"%s\", \"width\": %u, \"height\": %u, \"threads\": %u, \"frames\": %u, \"msPerFrame\": %.4f, "
+            "\"mpixelsPerSecond\": %.3f, \"efficiency\": %.4f, \"gbPerSecond\": %.3f, \"bandwidthFraction\": %.4f }%s\n",
+            m.name.c_str(), m.width, m.height, m.threads, m.frames, m.milliseconds, ((double)m.width * m.height) / (m.milliseconds * 1000.0),
+            m.efficiency, m.gbPerSecond, m.bandwidthFraction, (i + 1 < measurements.size()) ? "," : "");
+    }
+    fprintf(file, "  ]%s\n", last ? "" : ",");
+}
+
+/**
+* Write the results as JSON.
+*/
+static void WriteResults(const string &filepath, const vector<uint32_t> &threadCounts, const vector<double> &fillBandwidth,
+    const vector<Measurement> &strong, const vector<Measurement> &weak, const vector<BandwidthBound> &bounds)
+{
+    FILE* file = fopen(filepath.c_str(), "w");
+    if (!file) throw runtime_error("Error: failed to open " + filepath + "!");
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"hardwareThreads\": %u,\n", thread::hardware_concurrency());
+    fprintf(file, "  \"fillBandwidth\": [");
+    for (size_t i = 0; i < threadCounts.size(); i++)
+    {
+        fprintf(file, "%s{ \"threads\": %u, \"gbPerSecond\": %.3f }", (i > 0) ? ", " : " ", threadCounts[i], fillBandwidth[i]);
+    }
+    fprintf(file, " ],\n");
+    WriteMeasurements(file, "strong", strong, false);
+    WriteMeasurements(file, "weak", weak, false);
+    fprintf(file, "  \"bandwidthBound\": [\n");
+    for (size_t i = 0; i < bounds.size(); i++)
+    {
+        fprintf(file, "    { \"resolution\": \"%s\", \"threads\": %u, \"projectedThreads\": %.1f }%s\n",
+            bounds[i].name.c_str(), bounds[i].threads, bounds[i].projectedThreads, (i + 1 < bounds.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+    fclose(file);
+}
+
+/**
+* Render the full frame pipeline from 640x360 up to 16K at 1 to N threads, and report strong and
+* weak scaling efficiency, and where the pipeline becomes bound by memory bandwidth.
+*/
+int main(int argc, char** argv)
+{
+    ScalingConfig config;
+    if (!ParseCommandLine(argc, argv, config))
+    {
+        fprintf(stderr, "Usage: %s [-threads N] [-max-resolution 360p|720p|1080p|1440p|4K|8K|16K] [-weak-base RESOLUTION] [-time SECONDS] [-noise 0|1|2|3|4] [-transfer 0|1|2] [-format 0|1|2|3] [-out FILE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const uint32_t maxThreads = (config.threads > 0) ? config.threads : max(1u, thread::hardware_concurrency());
+    const vector<uint32_t> threadCounts = GetThreadCounts(maxThreads);
+
+    // One pool per thread count, created up front so each frame is allocated once
+    vector<unique_ptr<ThreadPool>> pools;
+    for (uint32_t count : threadCounts)
+    {
+        pools.emplace_back(new ThreadPool());
+        Threading::Create(*pools.back(), count);
+    }
+
+    int result = EXIT_SUCCESS;
+    try
+    {
+        SoftwareSettings settings;
+        settings.transferMode = (TransferMode)config.transferMode;
+        settings.layout = Quantize::Get_Layout((PixelFormat)config.format);
+
+        ThreadPool &widest = *pools.back();
+        NoiseTextures textures;
+        if (config.noiseType == 1 || config.noiseType == 2) BlueNoise::Load_Textures(widest, textures, 64);
+        else if (config.noiseType == 3) BlueNoise::Generate_Spatiotemporal_Textures(widest, textures, BLUE_NOISE_SPATIOTEMPORAL_SIZE, BLUE_NOISE_SPATIOTEMPORAL_SLICES, 0);
+
+        printf("Scaling: noise type %d, %s, 1 to %u threads, %.2f s per measurement\n", config.noiseType, Quantize::Get_Format_Name((PixelFormat)config.format), maxThreads, config.seconds);
+
+        // The ceiling that frame writes are compared against
+        vector<double> fillBandwidth;
+        {
+            vector<uint8_t> buffer(FILL_BUFFER_SIZE);
+            for (size_t i = 0; i < pools.size(); i++)
+            {
+                fillBandwidth.push_back(MeasureFillBandwidth(*pools[i], buffer, config.seconds));
+                printf("Fill bandwidth %3u threads: %8.2f GB/s\n", threadCounts[i], fillBandwidth[i]);
+            }
+        }
+
+        // Strong scaling: the same frame at every thread count
+        vector<Measurement> strong;
+        vector<BandwidthBound> bounds;
+        const int lastResolution = FindResolution(config.maxResolution);
+        for (int r = 0; r <= lastResolution; r++)
+        {
+            const Resolution &resolution = resolutions[r];
+            SoftwareFrame frame;
+            Software::Create_Frame(frame, resolution.width, resolution.height, settings.layout);
+
+            BandwidthBound bound;
+            bound.name = resolution.name;
+            double serial = 0.0;
+            for (size_t i = 0; i < pools.size(); i++)
+            {
+                Measurement m = TimeFrames(*pools[i], config, settings, textures, frame);
+                m.name = resolution.name;
+                if (i == 0) serial = m.milliseconds;
+                m.efficiency = serial / (m.milliseconds * m.threads);
+                m.bandwidthFraction = m.gbPerSecond / fillBandwidth[i];
+                if (bound.threads == 0 && m.bandwidthFraction >= BANDWIDTH_BOUND_FRACTION) bound.threads = m.threads;
+
+                printf("Strong %-6s %5ux%-5u %3u threads: %10.3f ms/frame %10.2f Mpixel/s, efficiency %6.1f%%, %7.2f GB/s (%5.1f%% of fill)\n",
+                    resolution.name, resolution.width, resolution.height, m.threads, m.milliseconds, ((double)m.width * m.height) / (m.milliseconds * 1000.0),
+                    m.efficiency * 100.0, m.gbPerSecond, m.bandwidthFraction * 100.0);
+                strong.push_back(m);
+            }
+
+            // Extrapolate the traffic per thread at the widest pool to the widest pool's fill bandwidth
+            const Measurement &widestRun = strong.back();
+            bound.projectedThreads = (BANDWIDTH_BOUND_FRACTION * fillBandwidth.back()) / (widestRun.gbPerSecond / widestRun.threads);
+            bounds.push_back(bound);
+        }
+
+        // Weak scaling: the base resolution's pixels per thread, added as rows
+        vector<Measurement> weak;
+        const Resolution &base = resolutions[FindResolution(config.weakBase)];
+        double serial = 0.0;
+        for (size_t i = 0; i < pools.size(); i++)
+        {
+            SoftwareFrame frame;
+            Software::Create_Frame(frame, base.width, base.height * threadCounts[i], settings.layout);
+
+            Measurement m = TimeFrames(*pools[i], config, settings, textures, frame);
+            m.name = base.name;
+            if (i == 0) serial = m.milliseconds;
+            m.efficiency = serial / m.milliseconds;
+            m.bandwidthFraction = m.gbPerSecond / fillBandwidth[i];
+
+            printf("Weak   %-6s %5ux%-5u %3u threads: %10.3f ms/frame %10.2f Mpixel/s, efficiency %6.1f%%, %7.2f GB/s (%5.1f%% of fill)\n",
+                base.name, m.width, m.height, m.threads, m.milliseconds, ((double)m.width * m.height) / (m.milliseconds * 1000.0),
+                m.efficiency * 100.0, m.gbPerSecond, m.bandwidthFraction * 100.0);
+            weak.push_back(m);
+        }
+
+        for (const BandwidthBound &bound : bounds)
+        {
+            if (bound.threads > 0) printf("Bandwidth bound %-6s from %u threads\n", bound.name.c_str(), bound.threads);
+            else printf("Bandwidth bound %-6s not reached at %u threads, projected at about %.0f threads\n", bound.name.c_str(), maxThreads, bound.projectedThreads);
+        }
+
+        if (!config.output.empty()) WriteResults(config.output, threadCounts, fillBandwidth, strong, weak, bounds);
+    }
+    catch (const exception &e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        result = EXIT_FAILURE;
+    }
+
+    for (unique_ptr<ThreadPool> &pool : pools) Threading::Destroy(*pool);
+    return result;
+}